@@ -0,0 +1,181 @@
+// counts malloc calls on the server request path under client load
+// usage: alloc_bench [connection_num] [request_num_per_connection]
+// the server listens on the ip and port in ./config.json
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include <rapidjson/document.h>
+#include "server.hpp"
+
+using namespace xjj;
+
+// malloc family interposed for the whole process, glibc forwards to the __libc_ versions
+static std::atomic<unsigned long> g_malloc_num(0);
+
+extern "C" {
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t num, size_t size);
+    void* __libc_realloc(void* ptr, size_t size);
+
+    void* malloc(size_t size) {
+        g_malloc_num.fetch_add(1, std::memory_order_relaxed);
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t num, size_t size) {
+        g_malloc_num.fetch_add(1, std::memory_order_relaxed);
+        return __libc_calloc(num, size);
+    }
+
+    void* realloc(void* ptr, size_t size) {
+        g_malloc_num.fetch_add(1, std::memory_order_relaxed);
+        return __libc_realloc(ptr, size);
+    }
+}
+
+const char RequestBody[] = "{\"cmd\":2,\"Id\":12345}";
+const char ResponseSuffix[] = " ok";
+
+// echo the request with a suffix, building the response in the request arena
+void echoLogic(const Server::Request& req, Server::Response& res) {
+    typedef std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>> ArenaString;
+    ArenaString body(req.getBody().data(), req.getBody().size(), ArenaAllocator<char>(&req.getArena()));
+    body.append(ResponseSuffix);
+    res.sendResponse(body.data(), body.size());
+}
+
+bool readConfig(std::string& ip, uint16_t& port) {
+    std::ifstream config_fs("./config.json");
+    std::stringstream ss;
+    ss << config_fs.rdbuf();
+    rapidjson::Document document;
+    document.Parse(ss.str().c_str());
+    if (!document.IsObject() || !document.HasMember("ip") ||
+        !document["ip"].IsString() || !document.HasMember("port") || !document["port"].IsUint())
+        return false;
+    ip = document["ip"].GetString();
+    port = static_cast<uint16_t>(document["port"].GetUint());
+    return true;
+}
+
+int connectServer(const std::string& ip, uint16_t port) {
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, ip.c_str(), &addr.sin_addr);
+    for (int retry = 0; retry < 100; retry++) {  // wait for the server to listen
+        int sock = socket(AF_INET, SOCK_STREAM, 0);
+        if (0 == connect(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)))
+            return sock;
+        close(sock);
+        usleep(10000);
+    }
+    return -1;
+}
+
+bool recvAll(int sock, char* buf, size_t length) {
+    while (length > 0) {
+        ssize_t received = recv(sock, buf, length, 0);
+        if (received <= 0)
+            return false;
+        buf += received;
+        length -= received;
+    }
+    return true;
+}
+
+// one request and its response over fixed buffers, so the client itself does not allocate
+bool roundTrip(int sock) {
+    const size_t body_len = sizeof(RequestBody) - 1;
+    const size_t response_len = body_len + sizeof(ResponseSuffix) - 1;
+    char request[4 + sizeof(RequestBody)];
+    for (int i = 0; i < 4; i++)
+        request[i] = static_cast<char>(body_len >> (i * 8));
+    memcpy(request + 4, RequestBody, body_len);
+    if (send(sock, request, 4 + body_len, 0) != static_cast<ssize_t>(4 + body_len))
+        return false;
+    char response[4 + sizeof(RequestBody) + sizeof(ResponseSuffix)];
+    if (!recvAll(sock, response, 4 + response_len))
+        return false;
+    size_t length = 0;
+    for (int i = 0; i < 4; i++)
+        length |= static_cast<size_t>(static_cast<unsigned char>(response[i])) << (i * 8);
+    return length == response_len && 0 == memcmp(response + 4 + body_len, ResponseSuffix, length - body_len);
+}
+
+// runs request_num round trips on every connection in parallel, returns whether all succeeded
+bool runLoad(const std::vector<int>& socks, size_t request_num) {
+    std::atomic<bool> ok(true);
+    std::vector<std::thread> clients;
+    for (int sock : socks) {
+        clients.emplace_back([sock, request_num, &ok] {
+            for (size_t n = 0; n < request_num; n++) {
+                if (!roundTrip(sock)) {
+                    ok = false;
+                    return;
+                }
+            }
+        });
+    }
+    for (auto& client : clients)
+        client.join();
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    int conn_num = argc > 1 ? atoi(argv[1]) : 4;
+    size_t request_num = argc > 2 ? strtoull(argv[2], nullptr, 10) : 20000;
+    std::string ip;
+    uint16_t port = 0;
+    if (conn_num <= 0 || 0 == request_num || !readConfig(ip, port)) {
+        fprintf(stderr, "usage: %s [connection_num] [request_num_per_connection], needs ./config.json\n", argv[0]);
+        return 1;
+    }
+
+    std::thread server_thread([] {
+        Server server(echoLogic);
+        server.run();
+    });
+
+    // connect one by one, each connection finishes a round trip before the next one is opened
+    std::vector<int> socks;
+    for (int i = 0; i < conn_num; i++) {
+        int sock = connectServer(ip, port);
+        if (sock < 0 || !roundTrip(sock)) {
+            fprintf(stderr, "cannot reach the server at %s:%u\n", ip.c_str(), port);
+            _exit(1);
+        }
+        socks.push_back(sock);
+    }
+
+    // warm up thread caches, object pools and connection buffers
+    if (!runLoad(socks, 1000)) {
+        fprintf(stderr, "warm-up failed\n");
+        _exit(1);
+    }
+
+    // client threads are created inside runLoad, count them separately
+    unsigned long baseline = g_malloc_num.load();
+    runLoad(socks, 0);
+    unsigned long thread_mallocs = g_malloc_num.load() - baseline;
+
+    unsigned long before = g_malloc_num.load();
+    bool ok = runLoad(socks, request_num);
+    unsigned long mallocs = g_malloc_num.load() - before - thread_mallocs;
+    size_t total = request_num * conn_num;
+    printf("%d connections, %zu requests: %lu malloc calls (%.3f per request)%s\n",
+           conn_num, total, mallocs, static_cast<double>(mallocs) / total, ok ? "" : ", some requests failed");
+    fflush(stdout);
+    _exit(ok ? 0 : 1);  // the server runs until the process exits
+}
@@ -0,0 +1,104 @@
+// Mutex (plain vs adaptive) and RWMutex under varying contention
+// usage: mutex_bench [max_thread_num] [op_num_per_thread]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <thread>
+#include <vector>
+#include "mutex.hpp"
+
+using namespace xjj;
+
+// runs body(thread_index) on thread_num threads, returns nanoseconds per operation
+template <typename Body>
+double timeThreads(int thread_num, size_t op_num, Body body) {
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < thread_num; i++)
+        threads.emplace_back(body, i);
+    for (auto& thread : threads)
+        thread.join();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) /
+           (op_num * thread_num);
+}
+
+// every operation locks, touches a few shared words and unlocks
+double lockBench(bool adaptive, int thread_num, size_t op_num) {
+    Mutex mutex(adaptive);
+    volatile uint64_t shared[4] = {0, 0, 0, 0};
+    double ns = timeThreads(thread_num, op_num, [&] (int) {
+        for (size_t n = 0; n < op_num; n++) {
+            AutoLockMutex autoLockMutex(&mutex);
+            for (int i = 0; i < 4; i++)
+                shared[i] = shared[i] + 1;
+        }
+    });
+    if (shared[0] != op_num * thread_num) {
+        fprintf(stderr, "lost updates\n");
+        exit(1);
+    }
+    return ns;
+}
+
+// lookups and updates on a shared map, read_percent% of operations are lookups
+template <typename Lock>
+double mapBench(Lock& lock, void (*readLock)(Lock&), void (*writeLock)(Lock&), void (*unlock)(Lock&),
+                int read_percent, int thread_num, size_t op_num) {
+    std::map<int, int> table;
+    for (int i = 0; i < 1024; i++)
+        table[i] = i;
+    return timeThreads(thread_num, op_num, [&] (int index) {
+        unsigned seed = static_cast<unsigned>(index) * 2654435761u + 1;
+        volatile int sink = 0;
+        for (size_t n = 0; n < op_num; n++) {
+            seed = seed * 1103515245u + 12345u;
+            int key = static_cast<int>((seed >> 8) & 1023);
+            if (static_cast<int>((seed >> 20) % 100) < read_percent) {
+                readLock(lock);
+                sink = table.find(key) -> second;
+                unlock(lock);
+            } else {
+                writeLock(lock);
+                table[key]++;
+                unlock(lock);
+            }
+        }
+        (void) sink;
+    });
+}
+
+int main(int argc, char* argv[]) {
+    int max_thread_num = argc > 1 ? atoi(argv[1]) : 8;
+    size_t op_num = argc > 2 ? strtoull(argv[2], nullptr, 10) : 500000;
+    if (max_thread_num <= 0 || 0 == op_num) {
+        fprintf(stderr, "usage: %s [max_thread_num] [op_num_per_thread]\n", argv[0]);
+        return 1;
+    }
+    printf("%u hardware threads, %zu operations per thread, ns per operation\n",
+           std::thread::hardware_concurrency(), op_num);
+
+    printf("\nshort critical section\nthreads     Mutex  adaptive\n");
+    for (int thread_num = 1; thread_num <= max_thread_num; thread_num *= 2)
+        printf("%7d  %8.1f  %8.1f\n", thread_num,
+               lockBench(false, thread_num, op_num), lockBench(true, thread_num, op_num));
+
+    Mutex mutex(true);
+    RWMutex rwmutex;
+    auto mutexLock = [] (Mutex& m) { m.lock(); };
+    auto mutexUnlock = [] (Mutex& m) { m.unlock(); };
+    auto readLock = [] (RWMutex& m) { m.readLock(); };
+    auto writeLock = [] (RWMutex& m) { m.writeLock(); };
+    auto rwUnlock = [] (RWMutex& m) { m.unlock(); };
+    const int read_percents[] = {50, 90, 99};
+    for (int read_percent : read_percents) {
+        printf("\nstd::map, %d%% reads\nthreads     Mutex   RWMutex\n", read_percent);
+        for (int thread_num = 1; thread_num <= max_thread_num; thread_num *= 2)
+            printf("%7d  %8.1f  %8.1f\n", thread_num,
+                   mapBench<Mutex>(mutex, mutexLock, mutexLock, mutexUnlock, read_percent, thread_num, op_num),
+                   mapBench<RWMutex>(rwmutex, readLock, writeLock, rwUnlock, read_percent, thread_num, op_num));
+    }
+    return 0;
+}
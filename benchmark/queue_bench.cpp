@@ -0,0 +1,80 @@
+// contended throughput of BlockingQueue vs LockFreeQueue
+// usage: queue_bench [producer_num] [consumer_num] [item_num]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "blocking_queue.hpp"
+#include "lock_free_queue.hpp"
+
+using namespace xjj;
+
+static const size_t Capacity = 4096;
+
+// every producer pushes item_num / producer_num items, consumers pop until all items are taken,
+// returns nanoseconds per item
+template <typename Queue>
+double run(Queue& queue, int producer_num, int consumer_num, size_t item_num) {
+    size_t per_producer = item_num / producer_num;
+    size_t total = per_producer * producer_num;
+    size_t per_consumer = total / consumer_num;
+    std::vector<std::thread> threads;
+    std::vector<unsigned long long> sums(consumer_num, 0);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < producer_num; i++) {
+        threads.emplace_back([&queue, per_producer] () {
+            for (size_t n = 0; n < per_producer; n++)
+                queue.push(n);
+        });
+    }
+    for (int i = 0; i < consumer_num; i++) {
+        // the last consumer also takes the remainder
+        size_t count = (i == consumer_num - 1) ? total - per_consumer * (consumer_num - 1) : per_consumer;
+        threads.emplace_back([&queue, &sums, i, count] () {
+            size_t value;
+            for (size_t n = 0; n < count; n++) {
+                queue.pop(value);
+                sums[i] += value;
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    unsigned long long sum = 0, expected = 0;
+    for (unsigned long long s : sums)
+        sum += s;
+    for (int i = 0; i < producer_num; i++)
+        expected += per_producer * (per_producer - 1) / 2;
+    if (sum != expected) {
+        fprintf(stderr, "checksum mismatch: %llu != %llu\n", sum, expected);
+        exit(1);
+    }
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) / total;
+}
+
+int main(int argc, char* argv[]) {
+    int producer_num = argc > 1 ? atoi(argv[1]) : 4;
+    int consumer_num = argc > 2 ? atoi(argv[2]) : 4;
+    size_t item_num = argc > 3 ? strtoull(argv[3], nullptr, 10) : 4000000;
+    if (producer_num <= 0 || consumer_num <= 0 || item_num < static_cast<size_t>(producer_num)) {
+        fprintf(stderr, "usage: %s [producer_num] [consumer_num] [item_num]\n", argv[0]);
+        return 1;
+    }
+
+    printf("%d producers, %d consumers, %zu items, capacity %zu, %u hardware threads\n",
+           producer_num, consumer_num, item_num, Capacity, std::thread::hardware_concurrency());
+
+    BlockingQueue<size_t> blocking_queue(Capacity);
+    double blocking_ns = run(blocking_queue, producer_num, consumer_num, item_num);
+    printf("BlockingQueue  %8.1f ns/item %8.2f Mitems/s\n", blocking_ns, 1000.0 / blocking_ns);
+
+    LockFreeQueue<size_t> lock_free_queue(Capacity);
+    double lock_free_ns = run(lock_free_queue, producer_num, consumer_num, item_num);
+    printf("LockFreeQueue  %8.1f ns/item %8.2f Mitems/s\n", lock_free_ns, 1000.0 / lock_free_ns);
+    return 0;
+}
@@ -13,8 +13,6 @@
 
 using namespace rapidjson;
 
-#define BUF_SIZE 1000
-
 struct Param
 {
     unsigned int Id;
@@ -53,6 +51,33 @@ void remove(Param& param) {
     scanf("%d", &param.Id);
 }
 
+void exportRows(Param& param) {
+    printf("Input min Id: ");
+    scanf("%d", &param.Id);
+}
+
+// read exactly length bytes
+bool recvAll(int sock, char* buf, size_t length) {
+    while (length > 0) {
+        ssize_t received = recv(sock, buf, length, 0);
+        if (received <= 0)
+            return false;
+        buf += received;
+        length -= received;
+    }
+    return true;
+}
+
+// read one frame: 4-byte little-endian length followed by the body
+bool recvFrame(int sock, std::string& body) {
+    unsigned char header[4];
+    if (!recvAll(sock, reinterpret_cast<char*>(header), sizeof(header)))
+        return false;
+    size_t length = header[0] | (header[1] << 8) | (header[2] << 16) | (static_cast<size_t>(header[3]) << 24);
+    body.resize(length);
+    return length == 0 || recvAll(sock, &body[0], length);
+}
+
 int main() {
 	// send request to specified server
 	struct sockaddr_in serv_addr;
@@ -61,9 +86,6 @@ int main() {
 	serv_addr.sin_addr.s_addr = inet_addr("127.0.0.1"); // IP addr
 	serv_addr.sin_port = htons(1234); // port
 
-	char buf_send[BUF_SIZE] = {0};
-	char buf_recv[BUF_SIZE] = {0};
-	
     // creat socket
 	int sock = socket(AF_INET, SOCK_STREAM, 0);
 	connect(sock, (struct sockaddr*)&serv_addr, sizeof(serv_addr));
@@ -76,7 +98,9 @@ int main() {
         std::cout << "0 - insert" << std::endl;
         std::cout << "1 - select" << std::endl;
         std::cout << "2 - update" << std::endl;
-        std::cout << "3 - delete" << std::endl;        
+        std::cout << "3 - delete" << std::endl;
+        std::cout << "4 - export" << std::endl;
+        std::cout << "5 - count" << std::endl;
         std::cout << "-----------" << std::endl;
         std::cout << "Input choice: " << std::endl;
 
@@ -98,6 +122,12 @@ int main() {
             case 3:
                 remove(param);
                 break;
+            case 4:
+                exportRows(param);
+                break;
+            case 5:
+                param.Id = 0;
+                break;
             default:
                 std::cout << "Wrong command!" << std::endl;
                 flag = false;
@@ -140,12 +170,30 @@ int main() {
         request.append(body);
         send(sock, request.c_str(), request.length(), MSG_NOSIGNAL);
 
-		// read data from server
-		recv(sock, buf_recv, BUF_SIZE, 0);
-		
+        // read data from server
+        std::string frame;
+        if (!recvFrame(sock, frame)) {
+            printf("Connection closed!\n");
+            break;
+        }
+
+        // export: data chunks {"rows":[[Id,"Name"],...]} until the status frame, then an empty frame
+        if (cmd[0] - '0' == 4) {
+            while (doc.Parse(frame.c_str()), doc.IsObject() && doc.HasMember("rows")) {
+                for (const auto& row : doc["rows"].GetArray())
+                    printf("\t%d\t%s\n", row[0].GetInt(), row[1].GetString());
+                if (!recvFrame(sock, frame))
+                    break;
+            }
+            std::string end;
+            if (!recvFrame(sock, end) || !end.empty())
+                printf("Export not terminated!\n");
+            if (doc.IsObject() && doc.HasMember("row_num") && doc["row_num"].IsInt64())
+                printf("Rows: %ld\n", doc["row_num"].GetInt64());
+        }
 
         // parsing data from server into JSON obj
-        doc.Parse(buf_recv + 4);
+        doc.Parse(frame.c_str());
         if (doc.IsObject() && 
             doc.HasMember("cli_timestamp") && 
             doc["cli_timestamp"].IsInt64() &&
@@ -167,12 +215,13 @@ int main() {
                 }
             }
 
+            // count: the row number of the last finished count, -1 before the first one finishes
+            if (cmd[0] - '0' == 5 && doc.HasMember("count") && doc["count"].IsInt64())
+                printf("count: %ld\n", doc["count"].GetInt64());
+
         } else {
             printf("Response Error!\n");
         }
-		
-		memset(buf_send, 0, BUF_SIZE); // reset send buffer
-		memset(buf_recv, 0, BUF_SIZE); // reset recv buffer
     }
 
 	// close socket
@@ -1,14 +1,20 @@
+#include <cstdio>
 #include <stdexcept>
 #include <string>
 #include <iostream>
 #include <memory>
+#include <atomic>
+#include <chrono>
 #include <csignal>
 #include <rapidjson/document.h>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 #include <rapidjson/prettywriter.h>
 #include "server.hpp"
+#include "async_query_executor.hpp"
 #include "mysql_connection_pool.hpp"
+#include "insert_batcher.hpp"
+#include "query_cache.hpp"
 
 using std::cout;
 using std::endl;
@@ -59,12 +65,59 @@ private:
     /// 数据库连接池
     shared_ptr<MySQLConnectionPool> m_conn_pool;
 
+    /// 插入合并器：并发的插入请求合并为多行INSERT执行；业务逻辑对象被拷贝给服务器，以shared_ptr共享
+    shared_ptr<InsertBatcher> m_insert_batcher;
+
+    /// 查询结果缓存：按Id查询的结果缓存在进程内，经缓存执行的更新与删除使Writers表的结果失效
+    shared_ptr<QueryCache> m_query_cache;
+
+    /*!
+     * @brief 异步统计的行数 \struct
+     */
+    struct RowCounter {
+        /// 最近一次统计的行数，尚未统计完成时为-1
+        std::atomic<int64_t> m_count{-1};
+
+        /// 是否有统计查询正在执行
+        std::atomic<bool> m_running{false};
+    };
+
+    /// 异步查询执行器：统计查询在epoll线程中完成，等待数据库响应期间不占用工作线程
+    shared_ptr<AsyncQueryExecutor> m_async_executor;
+
+    /// Writers表的行数
+    shared_ptr<RowCounter> m_row_counter;
+
+    /// 从请求内存池分配的JSON类型：解析、构造与序列化响应都不再调用malloc
+    typedef rapidjson::MemoryPoolAllocator<ArenaJsonAllocator> JsonAllocator;
+    typedef rapidjson::GenericDocument<rapidjson::UTF8<>, JsonAllocator, ArenaJsonAllocator> JsonDocument;
+    typedef rapidjson::GenericValue<rapidjson::UTF8<>, JsonAllocator> JsonValue;
+    typedef rapidjson::GenericStringBuffer<rapidjson::UTF8<>, ArenaJsonAllocator> JsonBuffer;
+    typedef rapidjson::Writer<JsonBuffer, rapidjson::UTF8<>, rapidjson::UTF8<>, ArenaJsonAllocator> JsonWriter;
+
+    /// 获取数据库连接的等待时长上限
+    static constexpr std::chrono::milliseconds ConnectionTimeout{500};
+
+    /// 查询结果缓存的内存字节数上限
+    static const size_t QueryCacheCapacity = 64 * 1024 * 1024;
+
+    /// 查询结果的存活时长，其他进程的写入最多在这段时间后可见
+    static constexpr std::chrono::milliseconds QueryCacheTtl{30000};
+
+    /// JSON内存池分配器的块大小，取较小值使短请求只占用请求内存池的一小部分
+    static const size_t JsonChunkSize = 4096;
+
+    /// 导出时每个数据块的目标字节数，编码的行达到该大小即发送
+    static const size_t ExportChunkSize = 64 * 1024;
+
     /// CRUD操作代号常量
     static const int
             InsertCmd = 0,
             SelectCmd = 1,
             UpdateCmd = 2,
-            DeleteCmd = 3;
+            DeleteCmd = 3,
+            ExportCmd = 4,
+            CountCmd = 5;
 
     /// CRUD操作结果代号常量
     static const int
@@ -74,29 +127,21 @@ private:
             Fail = 3;
 
     /*!
-     * @brief 执行SQL语句
-     * @param [in] sql 目标SQL语句
-     * @return 执行得到的结果集对象指针
+     * @brief 经查询缓存执行预处理语句：查询在副本上执行（配置了副本时），写入在主库上执行；
+     * 连接缓存了已解析的语句，重复执行时只发送参数
+     * @tparam Execute 函数对象类型
+     * @param [in] execute 经查询缓存执行语句的函数对象，返回操作结果代号
+     * @return 操作结果代号，出现SQL异常（含获取连接超时）时为SQLErr
      */
-    shared_ptr<sql::ResultSet> executeSQL(const std::string& sql) {
-        shared_ptr<sql::ResultSet> res = nullptr;
-        shared_ptr<sql::Connection> con(nullptr);
+    template <typename Execute>
+    int executeStatement(Execute execute) {
         try {
-            con = m_conn_pool -> getConnection();
-            shared_ptr<sql::Statement> stmt(con -> createStatement());
-
-            cout << sql << endl;
-
-            res = stmt -> executeQuery(sql);
-
+            return execute(*m_query_cache);
         } catch (sql::SQLException &e) {
             cout << e.what() << endl;
             cout << "(SQLException error code: " << e.getErrorCode() << ")" << endl;
-            res = nullptr;
+            return SQLErr;
         }
-        if (con)
-            m_conn_pool -> returnConnection(con);  // 注意返回连接！
-        return res;
     }
 
     /*!
@@ -104,24 +149,24 @@ private:
      * @param [in] doc 客户端请求JSON对象
      * @return 操作结果代号
      */
-    int insert(const rapidjson::Document& doc) {
+    int insert(const JsonDocument& doc) {
         if (!doc.HasMember("Id") || !doc["Id"].IsInt() ||
                 !doc.HasMember("Name") || !doc["Name"].IsString())
             return ParamErr;
-        std::string sql = "INSERT INTO Writers(Id, Name) VALUES (";
-        sql.append(std::to_string(doc["Id"].GetInt()));
-        sql.append(", \'");
-        sql.append(doc["Name"].GetString());
-        sql.append("\')");
-
-        shared_ptr<sql::ResultSet> res(executeSQL(sql));
-        if (res == nullptr)
-            return SQLErr;
 
-        if (res -> getAffectedRow() > 0)
+        try {
+            // 阻塞至本行所在的批次执行完毕，参数在执行批次的线程中设置
+            m_insert_batcher -> insert([&doc](sql::PreparedStatement& stmt, uint32_t first_index) {
+                stmt.setInt(first_index, doc["Id"].GetInt());
+                stmt.setString(first_index + 1, doc["Name"].GetString(), doc["Name"].GetStringLength());
+            });
+            m_query_cache -> invalidate("Writers");  // 插入合并器不经过查询缓存
             return Success;
-        else
-            return Fail;
+        } catch (sql::SQLException &e) {
+            cout << e.what() << endl;
+            cout << "(SQLException error code: " << e.getErrorCode() << ")" << endl;
+            return SQLErr;
+        }
     }
 
     /*!
@@ -130,26 +175,25 @@ private:
      * @param [in,out] res_doc 响应JSON对象
      * @return 操作结果代号
      */
-    int select(const rapidjson::Document& doc, rapidjson::Document& res_doc) {
+    int select(const JsonDocument& doc, JsonDocument& res_doc) {
         if (!doc.HasMember("Id") || !doc["Id"].IsInt())
             return ParamErr;
-        std::string sql = "SELECT Name FROM Writers WHERE Id = ";
-        sql.append(std::to_string(doc["Id"].GetInt()));
-
-        shared_ptr<sql::ResultSet> res(executeSQL(sql));
-        if (res == nullptr)
-            return SQLErr;
-        auto &alloc = res_doc.GetAllocator();
-        rapidjson::Value arr(rapidjson::kArrayType);
-        while (res -> next()) {
-            rapidjson::Value str_obj(rapidjson::kStringType);
-            std::string name(res -> getString("Name"));
-            str_obj.SetString(name.c_str(), name.length(), alloc);
-            arr.PushBack(str_obj, alloc);
-        }
-        res_doc.AddMember("names", arr, alloc);
 
-        return Success;
+        static const std::string sql_text("SELECT Name FROM Writers WHERE Id = ?");
+        return executeStatement([&doc, &res_doc](QueryCache& cache) -> int {
+            shared_ptr<sql::ResultSet> res(cache.executeQuery(sql_text, QueryParameters().addInt64(doc["Id"].GetInt())));
+
+            auto &alloc = res_doc.GetAllocator();
+            JsonValue arr(rapidjson::kArrayType);
+            while (res -> next()) {
+                JsonValue str_obj(rapidjson::kStringType);
+                std::string name(res -> getString(1));
+                str_obj.SetString(name.c_str(), name.length(), alloc);
+                arr.PushBack(str_obj, alloc);
+            }
+            res_doc.AddMember("names", arr, alloc);
+            return Success;
+        });
     }
 
     /*!
@@ -157,24 +201,20 @@ private:
      * @param [in] doc 客户端请求JSON对象
      * @return 操作结果代号
      */
-    int update(const rapidjson::Document& doc) {
+    int update(const JsonDocument& doc) {
         if (!doc.HasMember("Id") || !doc["Id"].IsInt() ||
             !doc.HasMember("Name") || !doc["Name"].IsString())
             return ParamErr;
 
-        std::string sql = "UPDATE Writers SET Name = \'";
-        sql.append(doc["Name"].GetString());
-        sql.append("\' WHERE Id = ");
-        sql.append(std::to_string(doc["Id"].GetInt()));
-
-        shared_ptr<sql::ResultSet> res(executeSQL(sql));
-        if (res == nullptr)
-            return SQLErr;
-
-        if (res -> getAffectedRow() > 0)
-            return Success;
-        else
-            return Fail;
+        static const std::string sql_text("UPDATE Writers SET Name = ? WHERE Id = ?");
+        return executeStatement([&doc](QueryCache& cache) -> int {
+            QueryParameters params;
+            params.addString(doc["Name"].GetString(), doc["Name"].GetStringLength()).addInt64(doc["Id"].GetInt());
+            if (cache.executeUpdate(sql_text, params) > 0)
+                return Success;
+            else
+                return Fail;
+        });
     }
 
     /*!
@@ -182,21 +222,133 @@ private:
      * @param [in] doc 客户端请求JSON对象
      * @return 操作结果代号
      */
-    int remove(const rapidjson::Document& doc) {
+    int remove(const JsonDocument& doc) {
         if (!doc.HasMember("Id") || !doc["Id"].IsInt())
             return ParamErr;
 
-        std::string sql = "DELETE FROM Writers WHERE Id = ";
-        sql.append(std::to_string(doc["Id"].GetInt()));
+        static const std::string sql_text("DELETE FROM Writers WHERE Id = ?");
+        return executeStatement([&doc](QueryCache& cache) -> int {
+            if (cache.executeUpdate(sql_text, QueryParameters().addInt64(doc["Id"].GetInt())) > 0)
+                return Success;
+            else
+                return Fail;
+        });
+    }
 
-        shared_ptr<sql::ResultSet> res(executeSQL(sql));
-        if (res == nullptr)
-            return SQLErr;
+    /*!
+     * @brief 统计操作：立即返回最近一次统计的行数，并在没有统计进行时发起新的异步统计查询
+     * @param [in,out] res_doc 响应JSON对象
+     * @return 操作结果代号
+     */
+    int count(JsonDocument& res_doc) {
+        static const std::string sql_text("SELECT COUNT(*) FROM Writers");
+        bool running = false;
+        if (m_row_counter -> m_running.compare_exchange_strong(running, true)) {
+            try {
+                ConnectionLease con = m_conn_pool -> getConnection(AccessMode::ReadOnly, ConnectionTimeout);
+                shared_ptr<RowCounter> counter = m_row_counter;
+                // 回调在epoll线程（或本线程）中执行，只记录结果
+                m_async_executor -> execute(std::move(con), sql_text,
+                        [counter](shared_ptr<sql::ResultSet> res, std::exception_ptr error) {
+                            try {
+                                if (error)
+                                    std::rethrow_exception(error);
+                                if (res -> next())
+                                    counter -> m_count = res -> getInt64(1);
+                            } catch (sql::SQLException &e) {
+                                cerr << e.what() << endl;
+                            }
+                            counter -> m_running = false;
+                        });
+            } catch (sql::SQLException &e) {
+                m_row_counter -> m_running = false;
+                cout << e.what() << endl;
+                cout << "(SQLException error code: " << e.getErrorCode() << ")" << endl;
+                return SQLErr;
+            }
+        }
+        res_doc.AddMember("count", m_row_counter -> m_count.load(), res_doc.GetAllocator());
+        return Success;
+    }
 
-        if (res -> getAffectedRow() > 0)
-            return Success;
-        else
-            return Fail;
+    /*!
+     * @brief 导出操作：逐行读取Id不小于请求中Id（缺省为0）的全部记录，边读取边编码为分块响应发送，
+     * 服务器内存占用与记录数无关，发送速度由客户端的读取速度决定。
+     * 数据块为{"rows":[[Id,"Name"],...]}，最后一块为{"cli_timestamp":...,"status":...,"row_num":...}，
+     * 之后是长度为0的结束报文
+     * @param [in] doc 客户端请求JSON对象
+     * @param [out] response 响应对象
+     * @param [in] arena_alloc 请求内存池分配器
+     */
+    void exportRows(const JsonDocument& doc, Server::Response& response, ArenaJsonAllocator& arena_alloc) {
+        int min_id = 0;
+        if (doc.HasMember("Id") && doc["Id"].IsInt())
+            min_id = doc["Id"].GetInt();
+
+        // 数据块发送后清空缓冲区，其容量保持在一个数据块左右
+        JsonBuffer buffer(&arena_alloc, ExportChunkSize + JsonChunkSize);
+        JsonWriter writer(buffer, &arena_alloc);
+        bool connected = true;
+        auto flush = [&]() {
+            writer.EndArray();
+            writer.EndObject();
+            connected = response.sendChunk(buffer.GetString(), buffer.GetSize());
+            buffer.Clear();
+            writer.Reset(buffer);
+        };
+
+        int64_t row_num = 0;
+        const char* status = "ok";
+        try {
+            // 租约须在结果集之后析构：逐行读取的结果集析构前连接不能归还
+            ConnectionLease con = m_conn_pool -> getConnection(AccessMode::ReadOnly, ConnectionTimeout);
+            shared_ptr<sql::Statement> stmt(con -> createStatement());
+            stmt -> setResultMode(sql::ResultMode::Streaming);
+
+            char sql_text[64];
+            int length = snprintf(sql_text, sizeof(sql_text), "SELECT Id, Name FROM Writers WHERE Id >= %d", min_id);
+            shared_ptr<sql::ResultSet> res(stmt -> executeQuery(sql_text, static_cast<size_t>(length)));
+
+            while (connected && res -> next()) {
+                if (0 == buffer.GetSize()) {
+                    writer.StartObject();
+                    writer.Key("rows");
+                    writer.StartArray();
+                }
+                sql::StringRef name = res -> getStringRef(2);  // 直接引用行数据，不复制
+                writer.StartArray();
+                writer.Int(res -> getInt(1));
+                if (name.data())
+                    writer.String(name.data(), static_cast<rapidjson::SizeType>(name.size()));
+                else
+                    writer.Null();
+                writer.EndArray();
+                row_num++;
+                if (buffer.GetSize() >= ExportChunkSize)
+                    flush();
+            }
+            if (connected && buffer.GetSize() > 0)
+                flush();
+        } catch (sql::SQLException &e) {
+            cout << e.what() << endl;
+            cout << "(SQLException error code: " << e.getErrorCode() << ")" << endl;
+            status = "sql_err";
+            buffer.Clear();  // 丢弃未完成的数据块
+            writer.Reset(buffer);
+        }
+        if (!connected)
+            return;  // 客户端已断开，连接由之后的读事件回收
+
+        writer.StartObject();
+        writer.Key("cli_timestamp");
+        writer.Int64(doc["timestamp"].GetInt64());
+        writer.Key("status");
+        writer.String(status);
+        writer.Key("row_num");
+        writer.Int64(row_num);
+        writer.EndObject();
+        if (response.sendChunk(buffer.GetString(), buffer.GetSize()))
+            response.endChunks();
     }
 
 public:
@@ -205,7 +357,22 @@ public:
      * @brief 构造函数，初始化数据库连接池
      */
     BusinessLogic()
-            : m_conn_pool(MySQLConnectionPool::getInstance()) {}
+            : m_conn_pool(MySQLConnectionPool::getInstance()),
+              m_insert_batcher(new InsertBatcher(m_conn_pool.get(), "Writers", {"Id", "Name"},
+                                                 InsertBatcher::DefaultMaxRows, InsertBatcher::DefaultMaxDelay,
+                                                 ConnectionTimeout)),
+              m_query_cache(new QueryCache(m_conn_pool.get(), QueryCacheCapacity, QueryCacheTtl, ConnectionTimeout)),
+              m_async_executor(new AsyncQueryExecutor()),
+              m_row_counter(new RowCounter()) {}
+
+    /*!
+     * @brief 将异步查询执行器加入服务器的事件循环，须在服务器运行之前调用
+     * @param [in] server 服务器
+     */
+    void addEventSources(Server& server) {
+        shared_ptr<AsyncQueryExecutor> executor = m_async_executor;
+        server.addEventSource(executor -> getEventFd(), [executor] { executor -> processEvents(); });
+    }
 
     /*!
      * @brief 重载()运算符，可以作为函数对象
@@ -214,8 +381,13 @@ public:
      */
     void operator() (const Server::Request& request, Server::Response& response) {
 
+        // 请求期间的JSON对象和输出缓冲区均从请求内存池分配，请求结束时一次性归还
+        Arena& arena = request.getArena();
+        ArenaJsonAllocator arena_alloc(&arena);
+
         // 解析请求JSON内容
-        rapidjson::Document doc;
+        JsonAllocator doc_alloc(JsonChunkSize, &arena_alloc);
+        JsonDocument doc(&doc_alloc, JsonChunkSize, &arena_alloc);
         doc.Parse(request.getBody().c_str());
 
         if (!doc.IsObject() || !doc.HasMember("timestamp") || !doc["timestamp"].IsInt64()) {
@@ -223,11 +395,18 @@ public:
             return;
         }
 
-        rapidjson::Document res_doc;
+        if (doc.HasMember("cmd") && doc["cmd"].IsInt() && ExportCmd == doc["cmd"].GetInt()) {
+            exportRows(doc, response, arena_alloc);
+            return;
+        }
+
+        JsonAllocator res_alloc(JsonChunkSize, &arena_alloc);
+        JsonDocument res_doc(&res_alloc, JsonChunkSize, &arena_alloc);
         res_doc.SetObject();
         auto& alloc = res_doc.GetAllocator();
-        rapidjson::StringBuffer buffer;
-        rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+        JsonBuffer buffer(&arena_alloc);
+        rapidjson::PrettyWriter<JsonBuffer, rapidjson::UTF8<>, rapidjson::UTF8<>, ArenaJsonAllocator>
+                writer(buffer, &arena_alloc);
 
         // 为响应报文打上客户端请求报文的时间戳
         res_doc.AddMember("cli_timestamp", doc["timestamp"].GetInt64(), alloc);
@@ -235,7 +414,7 @@ public:
         if (!doc.HasMember("cmd") || !doc["cmd"].IsInt()) {
             res_doc.AddMember("status", "cmd_err", alloc);
             res_doc.Accept(writer);
-            response.sendResponse(buffer.GetString());
+            response.sendResponse(buffer.GetString(), buffer.GetSize());
             return;
         }
 
@@ -255,10 +434,13 @@ public:
             case DeleteCmd:
                 res_status = remove(doc);
                 break;
+            case CountCmd:
+                res_status = count(res_doc);
+                break;
             default:
                 res_doc.AddMember("status", "cmd_err", alloc);
                 res_doc.Accept(writer);
-                response.sendResponse(buffer.GetString());
+                response.sendResponse(buffer.GetString(), buffer.GetSize());
                 return;
         }
 
@@ -282,15 +464,22 @@ public:
         }
 
         res_doc.Accept(writer);
-        response.sendResponse(buffer.GetString());
+        response.sendResponse(buffer.GetString(), buffer.GetSize());
     }
 };
 
+/// 获取数据库连接的等待时长上限
+constexpr std::chrono::milliseconds BusinessLogic::ConnectionTimeout;
+
+/// 查询结果的存活时长
+constexpr std::chrono::milliseconds BusinessLogic::QueryCacheTtl;
+
 int main() {
     SignalTranslator<SigIntException> signalTranslatorForSigInt;
     SignalTranslator<SigQuitException> signalTranslatorForSigQuit;
     BusinessLogic businessLogic;
     unique_ptr<Server> server(new Server(businessLogic));
+    businessLogic.addEventSources(*server);
     try {
         server -> run();
     } catch (std::exception& e) {
@@ -0,0 +1,316 @@
+//
+// created by agent on 2026-10-18
+//
+
+#ifndef _XJJ_ARENA_HPP
+#define _XJJ_ARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace xjj {
+    /*!
+     * @brief 单调内存池类 \class
+     * 必须在构造它的线程上析构，只应作为栈上对象嵌套使用
+     */
+    class Arena {
+    public:
+
+        /// 线程缓存的内存块大小（含块头），超过该大小的分配单独申请内存块
+        static const size_t SlabSize = 64 * 1024;
+
+        /// 每个线程缓存的内存块数目上限
+        static const size_t MaxCachedSlabs = 4;
+
+        /*!
+         * @brief 构造函数，不申请内存，首次分配时才取内存块
+         */
+        Arena();
+
+        /*!
+         * @brief 禁止拷贝构造
+         */
+        Arena(const Arena&) = delete;
+
+        /*!
+         * @brief 禁止赋值
+         * @return Arena&
+         */
+        Arena& operator=(const Arena&) = delete;
+
+        /*!
+         * @brief 析构函数：执行登记的析构函数并归还全部内存块
+         */
+        ~Arena();
+
+        /*!
+         * @brief 分配内存
+         * @param [in] size 字节数
+         * @param [in] alignment 对齐字节数，须为2的幂
+         * @return 内存地址
+         */
+        void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+            uintptr_t aligned = (reinterpret_cast<uintptr_t>(m_cursor) + alignment - 1) &
+                                ~static_cast<uintptr_t>(alignment - 1);
+            if (!m_cursor || aligned + size > reinterpret_cast<uintptr_t>(m_end))
+                return allocateSlow(size, alignment);
+            m_cursor = reinterpret_cast<char*>(aligned + size);
+            m_used += size;
+            return reinterpret_cast<void*>(aligned);
+        }
+
+        /*!
+         * @brief 在内存池中构造对象；对象的析构函数在内存池析构或reset时按构造的逆序执行
+         * @tparam T 对象类型
+         * @tparam Args 构造参数类型
+         * @param [in] args 构造参数
+         * @return 对象指针
+         */
+        template <typename T, typename... Args>
+        T* create(Args&&... args) {
+            T* object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+            if (!std::is_trivially_destructible<T>::value) {
+                auto finalizer = new (allocate(sizeof(Finalizer), alignof(Finalizer))) Finalizer;
+                finalizer -> m_destroy = &destroyObject<T>;
+                finalizer -> m_object = object;
+                finalizer -> m_next = m_finalizers;
+                m_finalizers = finalizer;
+            }
+            return object;
+        }
+
+        /*!
+         * @brief 复制字符串到内存池，结果以'\0'结尾
+         * @param [in] str 字符串
+         * @param [in] length 字符串长度
+         * @return 复制得到的字符串
+         */
+        char* copyString(const char* str, size_t length) {
+            auto copy = static_cast<char*>(allocate(length + 1, 1));
+            memcpy(copy, str, length);
+            copy[length] = '\0';
+            return copy;
+        }
+
+        /*!
+         * @brief 执行登记的析构函数并归还全部内存块，之后可继续分配
+         */
+        void reset();
+
+        /*!
+         * @brief 获取已分配的字节数
+         * @return 已分配的字节数
+         */
+        size_t used() const;
+
+        /*!
+         * @brief 获取当前线程的当前内存池（最近构造且尚未析构的内存池）
+         * @return 内存池指针，没有时为空
+         */
+        static Arena* current();
+
+    private:
+
+        /*!
+         * @brief 内存块头，数据紧随其后 \struct
+         */
+        struct Block {
+            /// 下一个内存块
+            Block* m_next;
+
+            /// 内存块大小（含块头）
+            size_t m_size;
+        };
+
+        /*!
+         * @brief 析构登记 \struct
+         */
+        struct Finalizer {
+            /// 析构函数
+            void (*m_destroy)(void*);
+
+            /// 对象指针
+            void* m_object;
+
+            /// 下一个（更早构造的）析构登记
+            Finalizer* m_next;
+        };
+
+        /*!
+         * @brief 析构对象
+         * @tparam T 对象类型
+         * @param [in] object 对象指针
+         */
+        template <typename T>
+        static void destroyObject(void* object) {
+            static_cast<T*>(object) -> ~T();
+        }
+
+        /*!
+         * @brief 当前内存块空间不足时取新内存块再分配
+         * @param [in] size 字节数
+         * @param [in] alignment 对齐字节数
+         * @return 内存地址
+         */
+        void* allocateSlow(size_t size, size_t alignment);
+
+        /*!
+         * @brief 从线程缓存中取内存块，缓存为空或所需空间超过SlabSize时申请内存
+         * @param [in] min_size 所需的最小块大小（含块头）
+         * @return 内存块
+         */
+        static Block* acquireBlock(size_t min_size);
+
+        /*!
+         * @brief 归还内存块到线程缓存，缓存已满、非定长内存块或线程正在退出时释放
+         * @param [in] block 内存块
+         */
+        static void releaseBlock(Block* block);
+
+        /// 内存块链表，最新的在前
+        Block* m_blocks;
+
+        /// 当前内存块中的分配位置
+        char* m_cursor;
+
+        /// 当前内存块的末尾
+        char* m_end;
+
+        /// 析构登记链表，最近构造的在前
+        Finalizer* m_finalizers;
+
+        /// 已分配的字节数
+        size_t m_used;
+
+        /// 构造前的当前内存池
+        Arena* m_previous;
+    };
+
+    /*!
+     * @brief 从内存池分配的STL分配器 \class
+     * @tparam T 元素类型
+     */
+    template <typename T>
+    class ArenaAllocator {
+    public:
+
+        /// 元素类型
+        typedef T value_type;
+
+        /*!
+         * @brief 构造函数
+         * @param [in] arena 内存池指针
+         */
+        explicit ArenaAllocator(Arena* arena) noexcept : m_arena(arena) {}
+
+        /*!
+         * @brief 从其它元素类型的分配器构造
+         * @param [in] other 其它元素类型的分配器
+         */
+        template <typename U>
+        ArenaAllocator(const ArenaAllocator<U>& other) noexcept : m_arena(other.getArena()) {}
+
+        /*!
+         * @brief 分配n个元素的内存
+         * @param [in] n 元素个数
+         * @return 内存地址
+         */
+        T* allocate(size_t n) {
+            return static_cast<T*>(m_arena -> allocate(n * sizeof(T), alignof(T)));
+        }
+
+        /*!
+         * @brief 不做任何事
+         */
+        void deallocate(T*, size_t) noexcept {}
+
+        /*!
+         * @brief 获取内存池指针
+         * @return 内存池指针
+         */
+        Arena* getArena() const noexcept {
+            return m_arena;
+        }
+
+    private:
+
+        /// 内存池指针
+        Arena* m_arena;
+    };
+
+    template <typename T, typename U>
+    bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) noexcept {
+        return a.getArena() == b.getArena();
+    }
+
+    template <typename T, typename U>
+    bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) noexcept {
+        return a.getArena() != b.getArena();
+    }
+
+    /*!
+     * @brief 从内存池分配的RapidJSON分配器 \class
+     */
+    class ArenaJsonAllocator {
+    public:
+
+        /// Free不做任何事，RapidJSON可省略释放
+        static const bool kNeedFree = false;
+
+        /*!
+         * @brief 构造函数，使用当前线程的当前内存池（RapidJSON需要自行构造分配器时），没有时抛出异常
+         */
+        ArenaJsonAllocator() : m_arena(Arena::current()) {
+            if (!m_arena)
+                throw std::logic_error("no current arena in this thread.");
+        }
+
+        /*!
+         * @brief 构造函数
+         * @param [in] arena 内存池指针
+         */
+        explicit ArenaJsonAllocator(Arena* arena) noexcept : m_arena(arena) {}
+
+        /*!
+         * @brief 分配内存
+         * @param [in] size 字节数
+         * @return 内存地址，size为0时为空
+         */
+        void* Malloc(size_t size) {
+            return size ? m_arena -> allocate(size) : nullptr;
+        }
+
+        /*!
+         * @brief 重新分配内存：缩小时原地返回，扩大时分配新内存并复制
+         * @param [in] original 原内存地址
+         * @param [in] original_size 原字节数
+         * @param [in] new_size 新字节数
+         * @return 内存地址
+         */
+        void* Realloc(void* original, size_t original_size, size_t new_size) {
+            if (original && new_size <= original_size)
+                return original;
+            void* memory = Malloc(new_size);
+            if (original && memory)
+                memcpy(memory, original, original_size);
+            return memory;
+        }
+
+        /*!
+         * @brief 不做任何事
+         */
+        static void Free(void*) {}
+
+    private:
+
+        /// 内存池指针
+        Arena* m_arena;
+    };
+} // namespace xjj
+
+#endif
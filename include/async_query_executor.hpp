@@ -0,0 +1,137 @@
+//
+// created by agent on 2026-10-19
+//
+
+#ifndef _XJJ_ASYNC_QUERY_EXECUTOR_HPP
+#define _XJJ_ASYNC_QUERY_EXECUTOR_HPP
+
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <sys/epoll.h>
+#include "mutex.hpp"
+#include "mysql_connection.hpp"
+#include "mysql_connection_pool.hpp"
+
+namespace xjj {
+
+    /*!
+     * @brief 异步查询执行器类 \class
+     * 可通过Server::addEventSource注册到服务器的事件循环，用法参见example/server_test.cpp
+     */
+    class AsyncQueryExecutor {
+    public:
+
+        /// 查询完成回调：成功时结果集非空，出错时异常非空
+        typedef std::function<void(std::shared_ptr<sql::ResultSet>, std::exception_ptr)> Callback;
+
+        /*!
+         * @brief 构造函数
+         */
+        AsyncQueryExecutor();
+
+        /*!
+         * @brief 禁止拷贝构造
+         */
+        AsyncQueryExecutor(const AsyncQueryExecutor&) = delete;
+
+        /*!
+         * @brief 禁止赋值
+         * @return AsyncQueryExecutor&
+         */
+        AsyncQueryExecutor& operator=(const AsyncQueryExecutor&) = delete;
+
+        /*!
+         * @brief 析构函数；未完成的查询等待其执行完毕后归还连接，不调用回调
+         */
+        ~AsyncQueryExecutor();
+
+        /*!
+         * @brief 开始执行sql语句；语句在本调用中即完成时（包括出错）回调在调用线程中执行，
+         * 否则在调用processEvents()的线程中执行。回调应简短且不可抛出异常
+         * @param [in] lease 执行语句的连接租约，查询完成后归还
+         * @param [in] sql sql语句
+         * @param [in] callback 查询完成回调
+         */
+        void execute(ConnectionLease lease, const std::string& sql, Callback callback);
+
+        /*!
+         * @brief 开始执行sql语句
+         * @param [in] lease 执行语句的连接租约，查询完成后归还
+         * @param [in] sql sql语句
+         * @return 结果集的future，出错时get()抛出SQLException；须有线程调用processEvents()才能完成
+         */
+        std::future<std::shared_ptr<sql::ResultSet>> execute(ConnectionLease lease, const std::string& sql);
+
+        /*!
+         * @brief 推进套接字已就绪的查询并调用已完成查询的回调；同一时间只应有一个线程调用
+         * @param [in] timeout_ms 没有就绪查询时的等待时长，单位为毫秒，-1表示一直等待，默认为0
+         * @return 本次完成的查询数目
+         */
+        size_t processEvents(int timeout_ms = 0);
+
+        /*!
+         * @brief 获取执行器的epoll文件描述符，有查询套接字就绪时可读
+         * @return epoll文件描述符
+         */
+        int getEventFd() const;
+
+        /*!
+         * @brief 获取未完成的查询数目
+         * @return 未完成的查询数目
+         */
+        size_t getPendingNum() const;
+
+    private:
+
+        /// 一次epoll_wait收集的事件数目上限
+        static const int MaxEventCount = 64;
+
+        /*!
+         * @brief 未完成的查询 \struct
+         */
+        struct PendingQuery {
+            /// 执行查询的连接租约
+            ConnectionLease m_lease;
+
+            /// 异步查询对象
+            std::shared_ptr<sql::AsyncQuery> m_query;
+
+            /// 查询完成回调
+            Callback m_callback;
+        };
+
+        /*!
+         * @brief 推进查询一次
+         * @param [in] query 异步查询对象
+         * @param [out] error 出错时的异常
+         * @return 是否已完成（包括出错）
+         */
+        static bool advance(sql::AsyncQuery& query, std::exception_ptr& error);
+
+        /*!
+         * @brief 归还已完成查询的连接并调用其回调
+         * @param [in] pending 已完成的查询
+         * @param [in] error 出错时的异常
+         */
+        static void complete(std::unique_ptr<PendingQuery> pending, std::exception_ptr error);
+
+        /// epoll文件描述符
+        int m_epoll_fd;
+
+        /// epoll事件数组
+        epoll_event m_events[MaxEventCount];
+
+        /// 未完成的查询表，以连接套接字文件描述符为键
+        std::unordered_map<int, std::unique_ptr<PendingQuery>> m_pending;
+
+        /// 保护未完成的查询表的互斥量
+        mutable Mutex m_mutex;
+    };
+}
+
+#endif //_XJJ_ASYNC_QUERY_EXECUTOR_HPP
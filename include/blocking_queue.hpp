@@ -5,14 +5,17 @@
 #ifndef _XJJ_BLOCKING_QUEUE_HPP
 #define _XJJ_BLOCKING_QUEUE_HPP
 
-#include <queue>
+#include <chrono>
 #include <climits>
+#include <utility>
 #include "condition_variable.hpp"
+#include "ring_buffer.hpp"
 
 namespace xjj {
     /*!
      * @brief 阻塞队列模板类 \class
-     * 主要的实现维护一个queue，使用条件变量和互斥量来进行队空和队满时的阻塞
+     * 主要的实现维护一个环形缓冲区队列，使用条件变量和互斥量来进行队空和队满时的阻塞；
+     * 入队出队均支持移动语义，T可以是只可移动的类型
      * @tparam T 模板参数类型
      */
     template <typename T>
@@ -29,24 +32,68 @@ namespace xjj {
          * @param [in] max_len 队列最大长度，默认为size_type可表示的最大值
          */
         explicit BlockingQueue(size_type max_len = DefaultMaxLen)
-                : m_max_len(max_len) {}
+                : m_mutex("BlockingQueue", true),  // 临界区很短，先自旋再睡眠
+                  m_max_len(max_len) {}
 
         /*!
          * @brief 入队函数
          * @param [in] element 入队对象const引用
          */
         void push(const T& element) {
+            emplace(element);
+        }
+
+        /*!
+         * @brief 移动入队函数
+         * @param [in] element 入队对象右值引用
+         */
+        void push(T&& element) {
+            emplace(std::move(element));
+        }
+
+        /*!
+         * @brief 原地构造入队函数
+         * @param [in] args 入队对象的构造参数
+         */
+        template <typename... Args>
+        void emplace(Args&&... args) {
             {  // 使用自动加锁互斥量
                 AutoLockMutex autoLockMutex(&m_mutex);
                 // 当队列已超队长上限，则等待队列未满条件
                 while (m_queue.size() >= m_max_len) {
                     m_not_full_cond_var.wait(&m_mutex);
                 }
-                m_queue.push(element);
+                m_queue.emplace(std::forward<Args>(args)...);
             }  // 离开作用域自动释放互斥量
             m_not_empty_cond_var.signal();  // 插入成功，队列非空条件为真，唤醒等候出队线程
         }
 
+        /*!
+         * @brief 批量入队函数，整批元素在一次加锁内移动入队
+         * @tparam Iterator 迭代器类型，元素被移出
+         * @param [in] first 起始迭代器
+         * @param [in] last 结束迭代器
+         */
+        template <typename Iterator>
+        void pushRange(Iterator first, Iterator last) {
+            size_type unsignaled = 0;  // 已入队但尚未唤醒出队线程的元素数
+            {
+                AutoLockMutex autoLockMutex(&m_mutex);
+                for (; first != last; ++first) {
+                    while (m_queue.size() >= m_max_len) {
+                        // 阻塞前先唤醒出队线程，否则可能互相等待
+                        for (; unsignaled > 0; unsignaled--)
+                            m_not_empty_cond_var.signal();
+                        m_not_full_cond_var.wait(&m_mutex);
+                    }
+                    m_queue.emplace(std::move(*first));
+                    ++unsignaled;
+                }
+            }
+            for (; unsignaled > 0; unsignaled--)
+                m_not_empty_cond_var.signal();
+        }
+
         /*!
          * @brief 出队函数
          * @param [out] element 队头对象引用
@@ -58,8 +105,8 @@ namespace xjj {
                 while (m_queue.empty()) {
                     m_not_empty_cond_var.wait(&m_mutex);
                 }
-                // 获取队头对象
-                element = m_queue.front();
+                // 移出队头对象
+                element = std::move(m_queue.front());
                 m_queue.pop();  // 弹出队头对象
             }
             m_not_full_cond_var.signal();  // 出队成功，队长不超上限，唤醒等候入队线程
@@ -72,16 +119,26 @@ namespace xjj {
          * @return 出队操作成功与否
          */
         bool timedPop(T& element, long seconds) {
+            return timedPop(element, std::chrono::seconds(seconds));
+        }
+
+        /*!
+         * @brief 定时出队函数，精确到纳秒
+         * @param [out] element 队头对象引用
+         * @param [in] timeout 等候时间，可直接传入std::chrono::microseconds等时长
+         * @return 出队操作成功与否
+         */
+        bool timedPop(T& element, std::chrono::nanoseconds timeout) {
             bool can_pop = false;  // 出队是否成功状态
             {
                 AutoLockMutex autoLockMutex(&m_mutex);
-                if (m_queue.empty())  // 队列为空，等候seconds秒后队列是否非空
-                    m_not_empty_cond_var.timedWait(&m_mutex, seconds);
+                // 等候队列非空或超时，虚假唤醒与被其它消费者抢先时在剩余时间内继续等待
+                m_not_empty_cond_var.timedWait(&m_mutex, timeout, [this] { return !m_queue.empty(); });
 
                 // 队列非空条件为真，或者超时，对队列是否非空进行判断
                 if (!m_queue.empty()) {  // 队列非空，执行出队操作
                     can_pop = true;
-                    element = m_queue.front();
+                    element = std::move(m_queue.front());
                     m_queue.pop();
                 }
             }
@@ -89,13 +146,32 @@ namespace xjj {
             return can_pop;
         }
 
+        /*!
+         * @brief 非阻塞出队函数
+         * @param [out] element 队头对象引用
+         * @return 出队操作成功与否（队列为空时立即返回false）
+         */
+        bool tryPop(T& element) {
+            {
+                AutoLockMutex autoLockMutex(&m_mutex);
+                if (m_queue.empty())
+                    return false;
+                element = std::move(m_queue.front());
+                m_queue.pop();
+            }
+            m_not_full_cond_var.signal();
+            return true;
+        }
+
         /*!
          * @brief 清空阻塞队列
          */
         void clear() {
-            AutoLockMutex autoLockMutex(&m_mutex);
-            while (!m_queue.empty())
-                m_queue.pop();
+            {
+                AutoLockMutex autoLockMutex(&m_mutex);
+                m_queue.clear();
+            }
+            m_not_full_cond_var.broadcast();  // 队列已空，唤醒所有等候入队线程
         }
 
         /*!
@@ -124,7 +200,7 @@ namespace xjj {
         size_type m_max_len;
 
         /// 内部队列对象
-        std::queue<T> m_queue;
+        RingBuffer<T> m_queue;
 
         /// 队长不超上限 条件变量
         ConditionVariable m_not_full_cond_var;
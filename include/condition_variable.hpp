@@ -5,12 +5,14 @@
 #ifndef _XJJ_CONDITION_VARIABLE_HPP
 #define _XJJ_CONDITION_VARIABLE_HPP
 
+#include <chrono>
 #include <memory>
 #include "mutex.hpp"
 
 namespace xjj {
     /*!
      * @brief 条件变量类 \class
+     * 定时等待基于CLOCK_MONOTONIC，不受系统时间调整影响
      */
     class ConditionVariable {
     public:
@@ -43,20 +45,94 @@ namespace xjj {
          */
         bool wait(Mutex* mutex_ptr);
 
+        /*!
+         * @brief 等候谓词为真，可防止虚假唤醒
+         * @tparam Predicate 谓词类型，在持有互斥量时调用
+         * @param [in] mutex_ptr 用于锁住条件变量的互斥量指针
+         * @param [in] predicate 等候的条件
+         */
+        template <typename Predicate>
+        void wait(Mutex* mutex_ptr, Predicate predicate) {
+            while (!predicate())
+                wait(mutex_ptr);
+        }
+
         /*!
          * @brief 定时等待条件变量为真
          * @param [in] mutex_ptr 用于锁住条件变量的互斥量指针
          * @param [in] seconds 等候时间长度，以秒为单位
-         * @return 成功与否
+         * @return 成功与否（超时返回false）
          */
         bool timedWait(Mutex* mutex_ptr, long seconds);
 
+        /*!
+         * @brief 定时等待条件变量为真，精确到纳秒，
+         * 可直接传入std::chrono::microseconds、std::chrono::milliseconds等时长
+         * @param [in] mutex_ptr 用于锁住条件变量的互斥量指针
+         * @param [in] duration 等候时间长度
+         * @return 成功与否（超时返回false）
+         */
+        bool timedWait(Mutex* mutex_ptr, std::chrono::nanoseconds duration);
+
+        /*!
+         * @brief 定时等待谓词为真，可防止虚假唤醒
+         * @tparam Predicate 谓词类型，在持有互斥量时调用
+         * @param [in] mutex_ptr 用于锁住条件变量的互斥量指针
+         * @param [in] duration 等候时间长度
+         * @param [in] predicate 等候的条件
+         * @return 返回时谓词的值
+         */
+        template <typename Predicate>
+        bool timedWait(Mutex* mutex_ptr, std::chrono::nanoseconds duration, Predicate predicate) {
+            return timedWaitUntil(mutex_ptr, deadlineAfter(duration), predicate);
+        }
+
+        /*!
+         * @brief 等待条件变量为真，直到绝对时间点
+         * @param [in] mutex_ptr 用于锁住条件变量的互斥量指针
+         * @param [in] deadline 截止时间点（steady_clock与CLOCK_MONOTONIC同源）
+         * @return 成功与否（超时返回false）
+         */
+        bool timedWaitUntil(Mutex* mutex_ptr, std::chrono::steady_clock::time_point deadline);
+
+        /*!
+         * @brief 等待谓词为真，直到绝对时间点，可防止虚假唤醒
+         * @tparam Predicate 谓词类型，在持有互斥量时调用
+         * @param [in] mutex_ptr 用于锁住条件变量的互斥量指针
+         * @param [in] deadline 截止时间点
+         * @param [in] predicate 等候的条件
+         * @return 返回时谓词的值
+         */
+        template <typename Predicate>
+        bool timedWaitUntil(Mutex* mutex_ptr, std::chrono::steady_clock::time_point deadline,
+                            Predicate predicate) {
+            while (!predicate()) {
+                if (!timedWaitUntil(mutex_ptr, deadline))  // 超时
+                    return predicate();
+            }
+            return true;
+        }
+
+        /*!
+         * @brief 计算从现在起经过duration后的截止时间点，超出time_point表示范围时取最大值，
+         * 负的时长视为0
+         * @param [in] duration 时间长度，可为std::chrono::nanoseconds::max()表示一直等待
+         * @return 截止时间点
+         */
+        static std::chrono::steady_clock::time_point deadlineAfter(std::chrono::nanoseconds duration);
+
         /*!
          * @brief 条件为真，唤醒一个等候条件变量变为真的线程
          * @return 成功与否
          */
         bool signal();
 
+        /*!
+         * @brief 条件为真，唤醒所有等候条件变量变为真的线程
+         * @return 成功与否
+         */
+        bool broadcast();
+
     private:
 
         /// 内部条件变量id
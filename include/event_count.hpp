@@ -0,0 +1,106 @@
+//
+// created by agent on 2026-10-18
+//
+
+#ifndef _XJJ_EVENT_COUNT_HPP
+#define _XJJ_EVENT_COUNT_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace xjj {
+    /*!
+     * @brief 事件计数类 \class
+     * 基于futex的等待/通知原语，等待方依次调用prepareWait、重新检查条件、wait或cancelWait
+     */
+    class EventCount {
+    public:
+
+        /// 等待凭据类型
+        typedef uint32_t key_type;
+
+        /*!
+         * @brief 构造函数
+         */
+        EventCount();
+
+        /*!
+         * @brief 禁止拷贝构造
+         */
+        EventCount(const EventCount&) = delete;
+
+        /*!
+         * @brief 禁止赋值
+         * @return EventCount&
+         */
+        EventCount& operator=(const EventCount&) = delete;
+
+        /*!
+         * @brief 登记为等待者并获取等待凭据
+         * @return 等待凭据
+         */
+        key_type prepareWait();
+
+        /*!
+         * @brief 条件已满足，取消等待登记
+         */
+        void cancelWait();
+
+        /*!
+         * @brief 等待通知，返回时已取消等待登记
+         * @param [in] key prepareWait返回的等待凭据
+         */
+        void wait(key_type key);
+
+        /*!
+         * @brief 定时等待通知，返回时已取消等待登记
+         * @param [in] key prepareWait返回的等待凭据
+         * @param [in] seconds 等候时间长度，以秒为单位
+         * @return 是否在超时前收到通知
+         */
+        bool timedWait(key_type key, long seconds);
+
+        /*!
+         * @brief 定时等待通知，精确到纳秒，返回时已取消等待登记
+         * @param [in] key prepareWait返回的等待凭据
+         * @param [in] timeout 等候时间长度（futex以CLOCK_MONOTONIC计时）
+         * @return 是否在超时前收到通知
+         */
+        bool timedWait(key_type key, std::chrono::nanoseconds timeout);
+
+        /*!
+         * @brief 唤醒一个等待者
+         */
+        void notify();
+
+        /*!
+         * @brief 唤醒所有等待者
+         */
+        void notifyAll();
+
+    private:
+
+        /*!
+         * @brief 若有等待者，推进事件序号并唤醒至多count个等待者
+         * @param [in] count 唤醒数目
+         */
+        void doNotify(int count);
+
+        /*!
+         * @brief 在事件序号仍等于key时进入futex等待
+         * @param [in] key 等待凭据
+         * @param [in] timeout 等候时间长度，为空表示不限时
+         * @return 是否因超时返回
+         */
+        bool futexWait(key_type key, const timespec* timeout);
+
+        /// 事件序号，同时作为futex字
+        std::atomic<key_type> m_epoch;
+
+        /// 等待者数目
+        std::atomic<key_type> m_waiters;
+    };
+} // namespace xjj
+
+#endif
@@ -0,0 +1,122 @@
+//
+// created by agent on 2026-10-18
+//
+
+#ifndef _XJJ_HISTOGRAM_HPP
+#define _XJJ_HISTOGRAM_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace xjj {
+    /*!
+     * @brief 计数直方图类 \class
+     * 按2的幂划分桶（第i桶记录[2^(i-1), 2^i)），记录为relaxed原子加，热点路径上宜每线程一个
+     */
+    class Histogram {
+    public:
+
+        /// 桶数目
+        static const size_t BucketNum = 64;
+
+        /*!
+         * @brief 直方图快照 \struct
+         */
+        struct Snapshot {
+            /// 各桶计数
+            uint64_t m_buckets[BucketNum];
+
+            /// 记录总数
+            uint64_t m_count;
+
+            /// 记录值之和
+            uint64_t m_sum;
+
+            /// 记录最大值
+            uint64_t m_max;
+
+            /*!
+             * @brief 构造函数，构造空快照
+             */
+            Snapshot();
+
+            /*!
+             * @brief 合并另一快照
+             * @param [in] other 另一快照
+             */
+            void merge(const Snapshot& other);
+
+            /*!
+             * @brief 获取平均值
+             * @return 平均值，没有记录时为0
+             */
+            double mean() const;
+
+            /*!
+             * @brief 获取分位数的近似值（所在桶的上界，且不超过最大值）
+             * @param [in] ratio 分位，取值[0, 1]，如0.99
+             * @return 分位数近似值
+             */
+            uint64_t percentile(double ratio) const;
+        };
+
+        /*!
+         * @brief 构造函数
+         */
+        Histogram();
+
+        /*!
+         * @brief 禁止拷贝构造
+         */
+        Histogram(const Histogram&) = delete;
+
+        /*!
+         * @brief 禁止赋值
+         * @return Histogram&
+         */
+        Histogram& operator=(const Histogram&) = delete;
+
+        /*!
+         * @brief 记录一个值
+         * @param [in] value 记录值
+         */
+        void record(uint64_t value);
+
+        /*!
+         * @brief 读取快照，与记录操作并发时各字段之间可能略有出入
+         * @return 快照
+         */
+        Snapshot snapshot() const;
+
+        /*!
+         * @brief 获取值所在的桶下标
+         * @param [in] value 值
+         * @return 桶下标
+         */
+        static size_t bucketIndex(uint64_t value);
+
+        /*!
+         * @brief 获取桶的上界（桶内值均小于该上界）
+         * @param [in] index 桶下标
+         * @return 上界
+         */
+        static uint64_t bucketUpperBound(size_t index);
+
+    private:
+
+        /// 各桶计数
+        std::atomic<uint64_t> m_buckets[BucketNum];
+
+        /// 记录总数
+        std::atomic<uint64_t> m_count;
+
+        /// 记录值之和
+        std::atomic<uint64_t> m_sum;
+
+        /// 记录最大值
+        std::atomic<uint64_t> m_max;
+    };
+} // namespace xjj
+
+#endif
@@ -0,0 +1,203 @@
+//
+// created by agent on 2026-10-19
+//
+
+#ifndef _XJJ_INSERT_BATCHER_HPP
+#define _XJJ_INSERT_BATCHER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <string>
+#include <vector>
+#include "condition_variable.hpp"
+#include "mutex.hpp"
+#include "mysql_connection.hpp"
+#include "mysql_connection_pool.hpp"
+
+namespace xjj {
+
+    /*!
+     * @brief 插入合并器类 \class
+     * 将并发的单行INSERT合并为一条多行INSERT执行；表须使用InnoDB等事务引擎
+     */
+    class InsertBatcher {
+    public:
+
+        /*!
+         * @brief 参数设置函数类型：为一行设置参数，该行第一列的参数序号为first_index，其余各列依次递增；
+         * 在领导者线程中调用，此时插入者仍在等待，可引用插入者栈上的数据
+         */
+        typedef std::function<void(sql::PreparedStatement& stmt, uint32_t first_index)> Binder;
+
+        /// 一批的默认行数上限
+        static const size_t DefaultMaxRows = 32;
+
+        /// 默认的批次等待时长上限
+        static constexpr std::chrono::microseconds DefaultMaxDelay{1000};
+
+        /*!
+         * @brief 构造函数
+         * @param [in] pool 连接池指针
+         * @param [in] table 表名
+         * @param [in] columns 插入的列名
+         * @param [in] max_rows 一批的行数上限，默认为DefaultMaxRows；语句按行数缓存于连接中，
+         * 连接的预处理语句缓存容量应足以容纳各种行数
+         * @param [in] max_delay 最早的行等待凑批的时长上限，默认为DefaultMaxDelay
+         * @param [in] connection_timeout 获取连接的等待时长上限，默认为0，表示按连接池配置项db_pool_timeout_ms等待
+         */
+        InsertBatcher(MySQLConnectionPool* pool, const std::string& table, const std::vector<std::string>& columns,
+                      size_t max_rows = DefaultMaxRows,
+                      std::chrono::microseconds max_delay = DefaultMaxDelay,
+                      std::chrono::nanoseconds connection_timeout = std::chrono::nanoseconds::zero());
+
+        /*!
+         * @brief 禁止拷贝构造
+         */
+        InsertBatcher(const InsertBatcher&) = delete;
+
+        /*!
+         * @brief 禁止赋值
+         * @return InsertBatcher&
+         */
+        InsertBatcher& operator=(const InsertBatcher&) = delete;
+
+        /*!
+         * @brief 插入一行，阻塞至该行所在的批次执行完毕；该行插入失败时抛出该行的异常（SQLException等）
+         * @param [in] binder 为该行设置参数的函数对象
+         */
+        void insert(const Binder& binder);
+
+        /*!
+         * @brief 获取已执行的批次数
+         * @return 批次数
+         */
+        uint64_t getBatchNum() const;
+
+        /*!
+         * @brief 获取已插入的行数（含失败的行）
+         * @return 行数
+         */
+        uint64_t getRowNum() const;
+
+        /*!
+         * @brief 获取整批失败而逐行重试的批次数
+         * @return 批次数
+         */
+        uint64_t getRetriedBatchNum() const;
+
+    private:
+
+        /*!
+         * @brief 等待插入的行 \struct
+         * 位于插入者的栈上
+         */
+        struct Waiter {
+            /*!
+             * @brief 行状态 \enum
+             */
+            enum class State {
+                /// 在队列中等待
+                Queued,
+
+                /// 已被领导者取出执行
+                Taken,
+
+                /// 已执行完毕
+                Done
+            };
+
+            /// 插入者专用的条件变量
+            ConditionVariable m_cond;
+
+            /// 为该行设置参数的函数对象
+            const Binder* m_binder;
+
+            /// 行状态
+            State m_state;
+
+            /// 入队时间点，批次以最早的行计算等待时长
+            std::chrono::steady_clock::time_point m_enqueue_time;
+
+            /// 该行插入失败时的异常
+            std::exception_ptr m_error;
+        };
+
+        /*!
+         * @brief 获取插入若干行的语句
+         * @param [in] row_num 行数
+         * @return sql语句
+         */
+        std::string sqlText(size_t row_num) const;
+
+        /*!
+         * @brief 作为领导者等待批次凑满或超时，取出一批并让出领导者身份；调用时须持有互斥量
+         * @param [out] batch 取出的行
+         */
+        void collectBatchLocked(std::vector<Waiter*>& batch);
+
+        /*!
+         * @brief 执行一批，将各行的异常记录在其等待者中；不持有互斥量
+         * @param [in] batch 待执行的行
+         */
+        void executeBatch(const std::vector<Waiter*>& batch);
+
+        /*!
+         * @brief 判断异常是否只与语句本身有关（如重复键、数据错误），逐行重试可以找出失败的行；
+         * 连接断开等客户端错误（CR_*）时逐行重试同样会失败
+         * @param [in] e sql异常
+         * @return 是否为语句错误
+         */
+        static bool isStatementError(sql::SQLException& e);
+
+        /// 连接池指针
+        MySQLConnectionPool* m_pool;
+
+        /// 插入max_rows行的语句，插入n行的语句为其前缀
+        std::string m_sql_text;
+
+        /// 语句中VALUES之前部分的长度
+        size_t m_header_length;
+
+        /// 每行参数组"(?, ?)"的长度
+        size_t m_row_length;
+
+        /// 每行的列数
+        uint32_t m_column_num;
+
+        /// 一批的行数上限
+        size_t m_max_rows;
+
+        /// 最早的行等待凑批的时长上限
+        std::chrono::microseconds m_max_delay;
+
+        /// 获取连接的等待时长上限，0表示按连接池的配置等待
+        std::chrono::nanoseconds m_connection_timeout;
+
+        /// 保护等待队列的互斥量
+        Mutex m_mutex;
+
+        /// 领导者等待批次凑满的条件变量
+        ConditionVariable m_leader_cond;
+
+        /// 按到达顺序排队的行
+        std::deque<Waiter*> m_queue;
+
+        /// 是否已有领导者在收集批次
+        bool m_has_leader;
+
+        /// 已执行的批次数
+        std::atomic<uint64_t> m_batch_num;
+
+        /// 已插入的行数
+        std::atomic<uint64_t> m_row_num;
+
+        /// 逐行重试的批次数
+        std::atomic<uint64_t> m_retried_batch_num;
+    };
+}
+
+#endif //_XJJ_INSERT_BATCHER_HPP
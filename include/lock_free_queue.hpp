@@ -0,0 +1,307 @@
+//
+// created by agent on 2026-10-18
+//
+
+#ifndef _XJJ_LOCK_FREE_QUEUE_HPP
+#define _XJJ_LOCK_FREE_QUEUE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "condition_variable.hpp"
+#include "event_count.hpp"
+
+namespace xjj {
+    /*!
+     * @brief 无锁有界多生产者多消费者队列模板类 \class
+     * 基于Dmitry Vyukov的有界MPMC队列算法，接口同BlockingQueue，队满/队空时以EventCount阻塞
+     * @tparam T 元素类型，需可移动构造
+     */
+    template <typename T>
+    class LockFreeQueue {
+    public:
+        /// 队列长度数据类型
+        typedef size_t size_type;
+
+        /// 默认容量
+        static const size_type DefaultCapacity = 4096;
+
+        /// 缓存行大小
+        static const size_t CacheLineSize = 64;
+
+        /*!
+         * @brief 构造函数
+         * @param [in] capacity 队列容量，向上取整为2的幂，至少为2
+         */
+        explicit LockFreeQueue(size_type capacity = DefaultCapacity)
+                : m_buffer(nullptr), m_mask(0), m_padding0(), m_enqueue_pos(0),
+                  m_padding1(), m_dequeue_pos(0), m_padding2() {
+            size_type real_capacity = 2;
+            while (real_capacity < capacity)
+                real_capacity <<= 1;
+            void* memory = nullptr;
+            if (posix_memalign(&memory, CacheLineSize, real_capacity * sizeof(Cell)) != 0)
+                throw std::bad_alloc();
+            m_buffer = static_cast<Cell*>(memory);
+            for (size_type i = 0; i < real_capacity; i++)
+                new (&m_buffer[i].m_sequence) std::atomic<size_type>(i);
+            m_mask = real_capacity - 1;
+        }
+
+        /*!
+         * @brief 禁止拷贝构造
+         */
+        LockFreeQueue(const LockFreeQueue&) = delete;
+
+        /*!
+         * @brief 禁止赋值
+         * @return LockFreeQueue&
+         */
+        LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+        /*!
+         * @brief 析构函数
+         */
+        ~LockFreeQueue() {
+            clear();
+            free(m_buffer);
+        }
+
+        /*!
+         * @brief 入队函数
+         * @param [in] element 入队对象const引用
+         */
+        void push(const T& element) {
+            emplace(element);
+        }
+
+        /*!
+         * @brief 移动入队函数
+         * @param [in] element 入队对象右值引用
+         */
+        void push(T&& element) {
+            emplace(std::move(element));
+        }
+
+        /*!
+         * @brief 原地构造入队函数，队满时阻塞
+         * @param [in] args 入队对象的构造参数，入队失败时不会被消耗
+         */
+        template <typename... Args>
+        void emplace(Args&&... args) {
+            while (!tryEmplace(std::forward<Args>(args)...)) {
+                EventCount::key_type key = m_not_full.prepareWait();
+                if (tryEmplace(std::forward<Args>(args)...)) {
+                    m_not_full.cancelWait();
+                    break;
+                }
+                m_not_full.wait(key);
+            }
+        }
+
+        /*!
+         * @brief 非阻塞原地构造入队函数
+         * @param [in] args 入队对象的构造参数
+         * @return 入队操作成功与否（队列已满时立即返回false，参数不被消耗）
+         */
+        template <typename... Args>
+        bool tryEmplace(Args&&... args) {
+            Cell* cell = nullptr;
+            size_type pos = m_enqueue_pos.load(std::memory_order_relaxed);
+            for (;;) {
+                cell = &m_buffer[pos & m_mask];
+                size_type sequence = cell -> m_sequence.load(std::memory_order_acquire);
+                std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) -
+                                      static_cast<std::ptrdiff_t>(pos);
+                if (diff == 0) {  // 槽位空闲，尝试占用
+                    if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                } else if (diff < 0) {  // 槽位仍被上一轮元素占用，队列已满
+                    return false;
+                } else {  // 其它生产者已占用该槽位，重新读取入队位置
+                    pos = m_enqueue_pos.load(std::memory_order_relaxed);
+                }
+            }
+            new (&cell -> m_storage) T(std::forward<Args>(args)...);
+            cell -> m_sequence.store(pos + 1, std::memory_order_release);
+            m_not_empty.notify();
+            return true;
+        }
+
+        /*!
+         * @brief 批量入队函数，元素被逐个移动入队
+         * @tparam Iterator 迭代器类型，元素被移出
+         * @param [in] first 起始迭代器
+         * @param [in] last 结束迭代器
+         */
+        template <typename Iterator>
+        void pushRange(Iterator first, Iterator last) {
+            for (; first != last; ++first)
+                emplace(std::move(*first));
+        }
+
+        /*!
+         * @brief 出队函数，队空时阻塞
+         * @param [out] element 队头对象引用
+         */
+        void pop(T& element) {
+            while (!tryPop(element)) {
+                EventCount::key_type key = m_not_empty.prepareWait();
+                if (tryPop(element)) {
+                    m_not_empty.cancelWait();
+                    break;
+                }
+                m_not_empty.wait(key);
+            }
+        }
+
+        /*!
+         * @brief 定时出队函数
+         * @param [out] element 队头对象引用
+         * @param [in] seconds 等候时间，以秒为单位
+         * @return 出队操作成功与否
+         */
+        bool timedPop(T& element, long seconds) {
+            return timedPop(element, std::chrono::seconds(seconds));
+        }
+
+        /*!
+         * @brief 定时出队函数，精确到纳秒
+         * @param [out] element 队头对象引用
+         * @param [in] timeout 等候时间，可直接传入std::chrono::microseconds等时长
+         * @return 出队操作成功与否
+         */
+        bool timedPop(T& element, std::chrono::nanoseconds timeout) {
+            if (tryPop(element))
+                return true;
+            auto deadline = ConditionVariable::deadlineAfter(timeout);
+            while (true) {
+                EventCount::key_type key = m_not_empty.prepareWait();
+                if (tryPop(element)) {
+                    m_not_empty.cancelWait();
+                    return true;
+                }
+                auto remaining = deadline - std::chrono::steady_clock::now();
+                if (remaining <= std::chrono::nanoseconds::zero()) {
+                    m_not_empty.cancelWait();
+                    return false;
+                }
+                m_not_empty.timedWait(key, std::chrono::duration_cast<std::chrono::nanoseconds>(remaining));
+                if (tryPop(element))
+                    return true;
+                // 被其它消费者抢先或提前唤醒，在剩余时间内继续等待
+            }
+        }
+
+        /*!
+         * @brief 非阻塞出队函数
+         * @param [out] element 队头对象引用
+         * @return 出队操作成功与否（队列为空时立即返回false）
+         */
+        bool tryPop(T& element) {
+            Cell* cell = nullptr;
+            size_type pos = m_dequeue_pos.load(std::memory_order_relaxed);
+            for (;;) {
+                cell = &m_buffer[pos & m_mask];
+                size_type sequence = cell -> m_sequence.load(std::memory_order_acquire);
+                std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) -
+                                      static_cast<std::ptrdiff_t>(pos + 1);
+                if (diff == 0) {  // 槽位已写入，尝试取出
+                    if (m_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                } else if (diff < 0) {  // 槽位尚未写入，队列为空
+                    return false;
+                } else {  // 其它消费者已取走该槽位，重新读取出队位置
+                    pos = m_dequeue_pos.load(std::memory_order_relaxed);
+                }
+            }
+            T* stored = reinterpret_cast<T*>(&cell -> m_storage);
+            element = std::move(*stored);
+            stored -> ~T();
+            // 槽位交给下一轮的生产者
+            cell -> m_sequence.store(pos + m_mask + 1, std::memory_order_release);
+            m_not_full.notify();
+            return true;
+        }
+
+        /*!
+         * @brief 清空队列
+         */
+        void clear() {
+            T element;
+            while (tryPop(element)) {}
+        }
+
+        /*!
+         * 判断队列判空，并发修改时结果仅为近似值
+         * @return 队列是否为空
+         */
+        bool empty() const {
+            return 0 == size();
+        }
+
+        /*!
+         * 获取队列长度，并发修改时结果仅为近似值
+         * @return 队列长度
+         */
+        size_type size() const {
+            size_type dequeue_pos = m_dequeue_pos.load(std::memory_order_acquire);
+            size_type enqueue_pos = m_enqueue_pos.load(std::memory_order_acquire);
+            return enqueue_pos > dequeue_pos ? enqueue_pos - dequeue_pos : 0;
+        }
+
+        /*!
+         * @brief 获取队列容量
+         * @return 容量
+         */
+        size_type capacity() const {
+            return m_mask + 1;
+        }
+
+    private:
+
+        /*!
+         * @brief 队列槽位，按缓存行对齐 \struct
+         */
+        struct alignas(CacheLineSize) Cell {
+            /// 槽位序号，等于pos表示可写入，等于pos + 1表示可读取
+            std::atomic<size_type> m_sequence;
+
+            /// 元素存储区
+            typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type m_storage;
+        };
+
+        /// 槽位数组
+        Cell* m_buffer;
+
+        /// 下标掩码，等于容量减一
+        size_type m_mask;
+
+        /// 填充，使入队位置与其它成员不在同一缓存行
+        char m_padding0[CacheLineSize];
+
+        /// 入队位置
+        std::atomic<size_type> m_enqueue_pos;
+
+        /// 填充，使入队位置与出队位置不在同一缓存行
+        char m_padding1[CacheLineSize - sizeof(std::atomic<size_type>)];
+
+        /// 出队位置
+        std::atomic<size_type> m_dequeue_pos;
+
+        /// 填充，使出队位置与事件计数不在同一缓存行
+        char m_padding2[CacheLineSize - sizeof(std::atomic<size_type>)];
+
+        /// 队列非空 事件计数
+        EventCount m_not_empty;
+
+        /// 队列未满 事件计数
+        EventCount m_not_full;
+    };
+} // namespace xjj
+
+#endif
@@ -5,20 +5,47 @@
 #ifndef _XJJ_MUTEX_HPP
 #define _XJJ_MUTEX_HPP
 
+/// 互斥量竞争分析：为1时命名的互斥量统计加锁次数、竞争次数、等待与持有时长，见MutexProfiler；
+/// 为0时不含任何统计代码
+#ifndef _XJJ_MUTEX_PROFILING
+#define _XJJ_MUTEX_PROFILING 0
+#endif
+
 #include <pthread.h>
+#include <atomic>
+#include <cstdint>
 #include <memory>
+#if _XJJ_MUTEX_PROFILING
+#include "mutex_profiler.hpp"
+#endif
 
 namespace xjj {
     /*!
      * @brief 互斥量类 \class
+     * 自适应模式下，加锁时先以指数退避的间隔反复尝试加锁，尝试次数上限根据此前自旋成功所需的次数动态调整，
+     * 仍未成功才让线程睡眠等待；适合临界区很短的场景，可避免线程切换。单核机器上自旋没有意义，自适应模式不生效
      */
     class Mutex {
     public:
 
+        /// 自适应模式下自旋尝试次数上限
+        static const int MaxSpinNum = 100;
+
+        /// 自适应模式下两次尝试之间的最大退避（pause指令数）
+        static const int MaxBackoff = 64;
+
         /*!
          * @brief 构造函数
+         * @param [in] adaptive 是否使用自适应（先自旋后睡眠）模式，默认为否
          */
-        Mutex();
+        explicit Mutex(bool adaptive = false);
+
+        /*!
+         * @brief 构造函数，竞争分析模式下按名称统计，同名互斥量的统计合并
+         * @param [in] name 互斥量名称，为空时不统计
+         * @param [in] adaptive 是否使用自适应（先自旋后睡眠）模式，默认为否
+         */
+        explicit Mutex(const char* name, bool adaptive = false);
 
         /*!
          * @brief 拷贝构造函数，设为delete，阻止拷贝
@@ -42,6 +69,12 @@ namespace xjj {
          */
         bool lock();
 
+        /*!
+         * @brief 尝试互斥量加锁，不阻塞
+         * @return 是否加锁成功
+         */
+        bool tryLock();
+
         /*!
          * @brief 互斥量解锁
          * @return 成功与否
@@ -56,8 +89,135 @@ namespace xjj {
 
     private:
 
+        friend class AutoLockMutex;
+        friend class ConditionVariable;
+
+        /*!
+         * @brief 加锁（自适应模式下先自旋），不做统计
+         * @return 成功与否
+         */
+        bool acquire();
+
+        /*!
+         * @brief 自适应模式下自旋尝试加锁
+         * @return 是否加锁成功
+         */
+        bool spinLock();
+
+#if _XJJ_MUTEX_PROFILING
+        /*!
+         * @brief 加锁并统计
+         * @param [in] caller 调用加锁的代码地址
+         * @return 成功与否
+         */
+        bool lockFrom(const void* caller);
+
+        /*!
+         * @brief 开始一次持有，按抽样率决定是否计时
+         * @param [in] now 当前时间（纳秒），为0时需要计时则读取时钟
+         */
+        void beginHold(uint64_t now);
+
+        /*!
+         * @brief 结束一次持有，若本次持有被抽中则计入统计
+         */
+        void endHold();
+
+        /*!
+         * @brief 条件变量等待前调用：等待期间互斥量被释放，结束本次持有的计时
+         */
+        void releaseForWait();
+
+        /*!
+         * @brief 条件变量等待返回后调用：互斥量已重新持有，开始计时
+         * 重新加锁发生在pthread_cond_wait内部，其等待时长无法测得，不计入统计
+         */
+        void reacquireAfterWait();
+#endif
+
         /// 底层互斥量id
         pthread_mutex_t m_mutex;
+
+        /// 是否使用自适应模式
+        bool m_adaptive;
+
+        /// 自旋成功所需尝试次数的估计值，决定下次自旋的尝试次数上限
+        std::atomic<int> m_spin_estimate;
+
+#if _XJJ_MUTEX_PROFILING
+        /// 竞争统计，未命名时为空
+        MutexProfile* m_profile;
+
+        /// 本次持有的开始时间（纳秒），未被抽中时为0；只由持有者读写
+        uint64_t m_locked_at;
+
+        /// 持有次数计数，用于抽样；只由持有者读写
+        uint32_t m_hold_tick;
+#endif
+    };
+
+    /*!
+     * @brief 读写锁类 \class
+     * 读锁可被多个线程同时持有，适合读多写少的数据结构；写者优先，持续的读者不会使写者饿死
+     */
+    class RWMutex {
+    public:
+
+        /*!
+         * @brief 构造函数
+         */
+        RWMutex();
+
+        /*!
+         * @brief 拷贝构造函数，设为delete，阻止拷贝
+         */
+        RWMutex(const RWMutex&) = delete;
+
+        /*!
+         * @brief 赋值操作，设为delete，阻止赋值
+         * @return RWMutex&
+         */
+        RWMutex& operator=(const RWMutex&) = delete;
+
+        /*!
+         * @brief 析构函数
+         */
+        ~RWMutex();
+
+        /*!
+         * @brief 加读锁
+         * @return 成功与否
+         */
+        bool readLock();
+
+        /*!
+         * @brief 加写锁
+         * @return 成功与否
+         */
+        bool writeLock();
+
+        /*!
+         * @brief 尝试加读锁，不阻塞
+         * @return 是否加锁成功
+         */
+        bool tryReadLock();
+
+        /*!
+         * @brief 尝试加写锁，不阻塞
+         * @return 是否加锁成功
+         */
+        bool tryWriteLock();
+
+        /*!
+         * @brief 解锁（读锁或写锁）
+         * @return 成功与否
+         */
+        bool unlock();
+
+    private:
+
+        /// 底层读写锁id
+        pthread_rwlock_t m_rwlock;
     };
 
     /*!
@@ -95,6 +255,76 @@ namespace xjj {
         /// 底层互斥量类指针
         Mutex* m_mutex_ptr;
     };
+
+    /*!
+     * @brief 自动加解读锁类 \class
+     * 在构造函数中加读锁，在析构函数中解锁
+     */
+    class AutoReadLock {
+    public:
+
+        /*!
+         * @brief 构造函数
+         * @param [in] rwmutex_ptr 读写锁指针
+         */
+        explicit AutoReadLock(RWMutex* rwmutex_ptr);
+
+        /*!
+         * @brief 拷贝构造函数，设为delete，阻止拷贝
+         */
+        AutoReadLock(const AutoReadLock&) = delete;
+
+        /*!
+         * @brief 赋值操作，设为delete，阻止赋值
+         * @return AutoReadLock&
+         */
+        AutoReadLock& operator=(const AutoReadLock&) = delete;
+
+        /*!
+         * @brief 析构函数
+         */
+        ~AutoReadLock();
+
+    private:
+
+        /// 读写锁指针
+        RWMutex* m_rwmutex_ptr;
+    };
+
+    /*!
+     * @brief 自动加解写锁类 \class
+     * 在构造函数中加写锁，在析构函数中解锁
+     */
+    class AutoWriteLock {
+    public:
+
+        /*!
+         * @brief 构造函数
+         * @param [in] rwmutex_ptr 读写锁指针
+         */
+        explicit AutoWriteLock(RWMutex* rwmutex_ptr);
+
+        /*!
+         * @brief 拷贝构造函数，设为delete，阻止拷贝
+         */
+        AutoWriteLock(const AutoWriteLock&) = delete;
+
+        /*!
+         * @brief 赋值操作，设为delete，阻止赋值
+         * @return AutoWriteLock&
+         */
+        AutoWriteLock& operator=(const AutoWriteLock&) = delete;
+
+        /*!
+         * @brief 析构函数
+         */
+        ~AutoWriteLock();
+
+    private:
+
+        /// 读写锁指针
+        RWMutex* m_rwmutex_ptr;
+    };
 } // namespace xjj
 
 #endif
\ No newline at end of file
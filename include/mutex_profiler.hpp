@@ -0,0 +1,157 @@
+//
+// created by agent on 2026-10-18
+//
+
+#ifndef _XJJ_MUTEX_PROFILER_HPP
+#define _XJJ_MUTEX_PROFILER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace xjj {
+    /*!
+     * @brief 互斥量竞争统计 \struct
+     * 同名的互斥量共享同一份统计（如所有BlockingQueue实例），由MutexProfiler持有，进程结束前不释放
+     */
+    struct MutexProfile {
+
+        /// 记录的最长等待次数
+        static const size_t TopWaitNum = 8;
+
+        /// 持有时长的抽样率：每HoldSampleRate次加锁计时一次，以免每次加锁都读两次时钟
+        static const uint32_t HoldSampleRate = 16;
+
+        /*!
+         * @brief 一次等待及其调用位置 \struct
+         */
+        struct CallSite {
+            /// 调用加锁的代码地址
+            const void* m_caller;
+
+            /// 等待时长（纳秒）
+            uint64_t m_wait_ns;
+        };
+
+        /*!
+         * @brief 构造函数
+         * @param [in] name 互斥量名称
+         */
+        explicit MutexProfile(const std::string& name);
+
+        /*!
+         * @brief 记录一次加锁
+         * @param [in] wait_ns 等待时长（纳秒），为0表示未发生竞争
+         * @param [in] caller 调用加锁的代码地址
+         */
+        void recordAcquire(uint64_t wait_ns, const void* caller);
+
+        /*!
+         * @brief 记录一次抽样的持有，按抽样率放大计入
+         * @param [in] hold_ns 持有时长（纳秒）
+         */
+        void recordHold(uint64_t hold_ns);
+
+        /*!
+         * @brief 清零统计
+         */
+        void reset();
+
+        /// 互斥量名称
+        const std::string m_name;
+
+        /// 加锁次数
+        std::atomic<uint64_t> m_acquisitions;
+
+        /// 发生竞争（首次尝试加锁失败）的次数
+        std::atomic<uint64_t> m_contended;
+
+        /// 累计等待时长（纳秒）
+        std::atomic<uint64_t> m_wait_ns;
+
+        /// 最长单次等待时长（纳秒）
+        std::atomic<uint64_t> m_max_wait_ns;
+
+        /// 累计持有时长（纳秒），由抽样估计
+        std::atomic<uint64_t> m_hold_ns;
+
+        /// 最长等待记录中最短的一次，短于它的等待无需加锁比较
+        std::atomic<uint64_t> m_top_min_ns;
+
+        /// 保护最长等待记录的自旋锁
+        std::atomic_flag m_top_lock;
+
+        /// 最长的若干次等待及其调用位置
+        CallSite m_top_waits[TopWaitNum];
+    };
+
+    /*!
+     * @brief 互斥量竞争分析器类 \class
+     * 以宏 _XJJ_MUTEX_PROFILING 为1编译时统计命名的互斥量，report按累计等待时长排序
+     */
+    class MutexProfiler {
+    public:
+
+        /*!
+         * @brief 单个互斥量名称的统计快照 \struct
+         */
+        struct Report {
+            /// 互斥量名称
+            std::string m_name;
+
+            /// 加锁次数
+            uint64_t m_acquisitions;
+
+            /// 发生竞争的次数
+            uint64_t m_contended;
+
+            /// 累计等待时长（纳秒）
+            uint64_t m_wait_ns;
+
+            /// 最长单次等待时长（纳秒）
+            uint64_t m_max_wait_ns;
+
+            /// 累计持有时长（纳秒），由抽样估计
+            uint64_t m_hold_ns;
+
+            /// 最长的若干次等待，按时长降序
+            std::vector<MutexProfile::CallSite> m_top_waits;
+        };
+
+        /*!
+         * @brief 获取名称对应的统计，不存在时创建
+         * @param [in] name 互斥量名称
+         * @return 统计指针，进程结束前有效
+         */
+        static MutexProfile* getProfile(const char* name);
+
+        /*!
+         * @brief 获取所有统计的快照，按累计等待时长降序
+         * @return 快照列表
+         */
+        static std::vector<Report> snapshot();
+
+        /*!
+         * @brief 生成可读的竞争报告，最长等待的调用位置以符号形式给出
+         * @return 报告文本
+         */
+        static std::string report();
+
+        /*!
+         * @brief 清零所有统计
+         */
+        static void reset();
+
+    private:
+
+        /*!
+         * @brief 获取全部统计，函数内静态对象避免静态初始化顺序问题
+         * @return 统计列表
+         */
+        static std::vector<MutexProfile*>& profiles();
+    };
+} // namespace xjj
+
+#endif
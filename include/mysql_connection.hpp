@@ -5,8 +5,16 @@
 #ifndef _XJJ_MYSQL_CONNECTION_HPP
 #define _XJJ_MYSQL_CONNECTION_HPP
 
+#include <cstdint>
+#include <exception>
+#include <list>
+#include <memory>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #include <mysql/mysql.h>
 #include "mutex.hpp"
 
@@ -53,11 +61,118 @@ namespace sql {
                 const std::string& caller_func,
                 const std::string& error_operation
         );
+
+        /*!
+         * @brief 生成异常
+         * @param [in] stmt 预处理语句句柄
+         * @param [in] caller_func 调用函数名
+         * @param [in] error_operation 出现错误的操作
+         * @return 所生成的异常
+         */
+        static SQLException generateException(
+                MYSQL_STMT *stmt,
+                const std::string& caller_func,
+                const std::string& error_operation
+        );
     };
 
     class Connection;
     class Statement;
     class ResultSet;
+    class AsyncQuery;
+    class PreparedStatement;
+    class PreparedResultSet;
+    class MaterializedResult;
+    struct StatementHandle;
+
+    /*!
+     * @brief 结果集取回方式 \enum
+     */
+    enum class ResultMode {
+        /// 执行后一次性将全部结果行取回客户端内存（mysql_store_result）
+        Buffered,
+
+        /// 逐行从服务器读取（mysql_use_result），内存占用与结果大小无关；
+        /// 结果集析构（未读完的行随之丢弃）前，该连接不能执行其它语句
+        Streaming
+    };
+
+    /*!
+     * @brief 字符串引用 \struct
+     * 指向结果行中的列值而不复制，在结果集光标移到下一行或结果集析构前有效
+     */
+    struct StringRef {
+        /// 数据起始地址，列值为NULL时为空
+        const char* m_data;
+
+        /// 数据长度
+        size_t m_length;
+
+        /*!
+         * @brief 获取数据起始地址
+         * @return 数据起始地址
+         */
+        const char* data() const {
+            return m_data;
+        }
+
+        /*!
+         * @brief 获取数据长度
+         * @return 数据长度
+         */
+        size_t size() const {
+            return m_length;
+        }
+
+        /*!
+         * @brief 复制为std::string
+         * @return 字符串
+         */
+        std::string str() const {
+            return std::string(m_data ? m_data : "", m_length);
+        }
+    };
+
+    /*!
+     * @brief 日期时间 \struct
+     * 由DATE、DATETIME、TIMESTAMP列的文本解析而来，DATE列的时间部分为0
+     */
+    struct DateTime {
+        /// 年
+        int m_year;
+
+        /// 月（1~12）
+        int m_month;
+
+        /// 日（1~31）
+        int m_day;
+
+        /// 时
+        int m_hour;
+
+        /// 分
+        int m_minute;
+
+        /// 秒
+        int m_second;
+
+        /// 微秒
+        int m_microsecond;
+    };
+
+    /*!
+     * @brief 批量执行中单条语句的结果 \struct
+     */
+    struct BatchResult {
+        /// 结果集，语句出错或未执行时为空
+        std::shared_ptr<ResultSet> m_result_set;
+
+        /// 语句出错或因之前的语句出错而未执行时的异常（SQLException）
+        std::exception_ptr m_error;
+    };
+
+    /// MYSQL_BIND中标志字段（is_null、error等）的类型：MySQL 5.7为my_bool，8.0为bool
+    typedef std::remove_pointer<decltype(MYSQL_BIND::is_null)>::type BindFlag;
 
     /*!
      * @brief 数据库连接驱动
@@ -65,8 +180,8 @@ namespace sql {
     class Driver {
     private:
 
-        /// 用于获取驱动单例的互斥量
-        static Mutex m_mutex;
+        /// 保护驱动单例的读写锁，创建后只需读锁
+        static RWMutex m_mutex;
 
         /// 驱动全局单例
         static std::shared_ptr<Driver> m_instance;
@@ -126,17 +241,52 @@ namespace sql {
                 unsigned int port
         );
 
+        // sql表达式类按需开启或关闭连接的多语句模式
+        friend class Statement;
+
+    public:
+
+        /// 预处理语句缓存的默认容量
+        static const size_t DefaultStatementCacheSize = 64;
+
     private:
 
+        /// 预处理语句缓存链表类型，元素为（SQL文本，语句句柄）
+        typedef std::list<std::pair<std::string, std::shared_ptr<StatementHandle>>> StatementList;
+
         /// 数据库连接句柄
         MYSQL *m_mysql;
 
+        /// 预处理语句缓存，最近使用的在前
+        StatementList m_stmt_list;
+
+        /// SQL文本到缓存链表位置的索引
+        std::unordered_map<std::string, StatementList::iterator> m_stmt_index;
+
+        /// 预处理语句缓存容量，为0时不缓存
+        size_t m_stmt_cache_size;
+
+        /// 是否处于多语句模式（MYSQL_OPTION_MULTI_STATEMENTS_ON），由executeBatch开启，执行其它语句前关闭
+        bool m_multi_statements;
+
         /*!
          * @brief 构造函数
          * @param [in] mysql 连接句柄
          */
         explicit Connection(MYSQL *mysql);
 
+        /*!
+         * @brief 淘汰最久未使用的预处理语句，直到缓存不超过容量
+         */
+        void trimStatementCache();
+
+        /*!
+         * @brief 开启或关闭多语句模式，与当前模式相同时不产生网络往返
+         * @param [in] enable 是否开启
+         * @throw SQLException 设置失败，此时模式不变
+         */
+        void setMultiStatements(bool enable);
+
     public:
 
         /*!
@@ -166,6 +316,38 @@ namespace sql {
          * @return sql表达式指针
          */
         std::shared_ptr<Statement> createStatement();
+
+        /*!
+         * @brief 创建预处理语句：以SQL文本为键查找本连接的LRU缓存，未命中时才在服务器端解析（mysql_stmt_prepare），
+         * 因此重复执行同一SQL只需发送参数；缓存满时关闭最久未使用的语句句柄
+         * @param [in] sql 以?为参数占位符的sql语句
+         * @return 预处理语句指针
+         */
+        std::shared_ptr<PreparedStatement> prepareStatement(const std::string& sql);
+
+        /*!
+         * @brief 设置预处理语句缓存容量，超出部分立即淘汰
+         * @param [in] size 容量，为0时不缓存（语句在PreparedStatement释放时关闭）
+         */
+        void setStatementCacheSize(size_t size);
+
+        /*!
+         * @brief 获取预处理语句缓存容量
+         * @return 容量
+         */
+        size_t getStatementCacheSize() const;
+
+        /*!
+         * @brief 检查与服务器的连接是否可用（mysql_ping），会产生一次网络往返
+         * @return 是否可用
+         */
+        bool ping();
+
+        /*!
+         * @brief 根据最近一次操作的错误编号判断连接是否已断开（服务器重启、wait_timeout等），不产生网络往返
+         * @return 是否已断开
+         */
+        bool isConnectionLost() const;
     };
 
     /*!
@@ -178,14 +360,20 @@ namespace sql {
 
     private:
 
+        /// 所属的连接
+        Connection *m_conn;
+
         /// 数据库连接句柄
         MYSQL *m_mysql;
 
+        /// 结果集取回方式
+        ResultMode m_result_mode;
+
         /*!
          * @brief 构造函数
-         * @param [in] mysql 连接句柄
+         * @param [in] conn 所属的连接
          */
-        explicit Statement(MYSQL *mysql);
+        explicit Statement(Connection *conn);
 
     public:
 
@@ -206,6 +394,44 @@ namespace sql {
          * @return 结果集对象指针
          */
         std::shared_ptr<ResultSet> executeQuery(const std::string& sql);
+
+        /*!
+         * @brief 执行sql语句，sql无需以'\0'结尾（可直接使用内存池中的字符串）
+         * @param [in] sql sql语句
+         * @param [in] length sql语句长度
+         * @return 结果集对象指针
+         */
+        std::shared_ptr<ResultSet> executeQuery(const char* sql, size_t length);
+
+        /*!
+         * @brief 设置之后执行的语句的结果集取回方式，默认为ResultMode::Buffered；
+         * 导出大量数据时使用ResultMode::Streaming，边读取边处理
+         * @param [in] mode 取回方式
+         */
+        void setResultMode(ResultMode mode);
+
+        /*!
+         * @brief 获取结果集取回方式
+         * @return 取回方式
+         */
+        ResultMode getResultMode() const;
+
+        /*!
+         * @brief 以非阻塞方式开始执行sql语句，结果一次性取回（不受结果集取回方式影响）；
+         * 返回的异步查询对象析构前连接不能执行其它语句
+         * @param [in] sql sql语句
+         * @return 异步查询对象指针，由调用者在连接套接字就绪时调用poll()推进
+         */
+        std::shared_ptr<AsyncQuery> executeQueryAsync(const std::string& sql);
+
+        /*!
+         * @brief 在一次网络往返中执行多条sql语句，各语句的结果一次性取回（不受结果集取回方式影响）；
+         * 执行前开启连接的多语句模式并保持到执行其它语句前。某条语句出错时服务器不再执行其后的语句
+         * @param [in] sqls sql语句，每个元素为一条语句，不以分号结尾
+         * @return 与sqls一一对应的结果，出错或未执行的语句的结果中记录异常
+         * @throw SQLException 开启多语句模式失败
+         */
+        std::vector<BatchResult> executeBatch(const std::vector<std::string>& sqls);
     };
 
     /*!
@@ -214,7 +440,13 @@ namespace sql {
     class ResultSet {
 
     // 将sql表达式类的sql执行函数声明为友元，可以访问结果集类的构造函数
-    friend std::shared_ptr<ResultSet> Statement::executeQuery(const std::string &sql);
+    friend std::shared_ptr<ResultSet> Statement::executeQuery(const char* sql, size_t length);
+
+    // 批量执行时逐条构造结果集
+    friend std::vector<BatchResult> Statement::executeBatch(const std::vector<std::string>& sqls);
+
+    // 异步查询类在取回结果后构造结果集
+    friend class AsyncQuery;
 
     private:
 
@@ -230,17 +462,51 @@ namespace sql {
         /// 底层结果集对象指针
         MYSQL_RES *m_result;
 
-        /// 当前指向结果行
-        MYSQL_ROW m_row;
+        /// 当前指向结果行，指向底层结果集或物化结果中的列值
+        const char* const* m_row;
+
+        /// 当前行各列值的长度
+        const unsigned long *m_lengths;
+
+        /// 结果集取回方式；一次性取回的结果集构造后不再访问连接，可在连接归还后继续读取
+        ResultMode m_mode;
+
+        /// 列名到列号的索引，构造时建立一次
+        std::unordered_map<std::string, uint32_t> m_column_index;
+
+        /// 读取的物化结果，非空时不访问连接与底层结果集
+        std::shared_ptr<const MaterializedResult> m_materialized;
 
         /*!
          * @brief 构造函数
          * @param [in] mysql 连接句柄
+         * @param [in] mode 结果集取回方式
+         */
+        ResultSet(MYSQL *mysql, ResultMode mode);
+
+        /*!
+         * @brief 构造函数
+         * @param [in] mysql 连接句柄
+         * @param [in] result 已取回的底层结果集对象指针，语句未返回数据或出错时为空
+         * @param [in] mode 结果集取回方式
+         */
+        ResultSet(MYSQL *mysql, MYSQL_RES *result, ResultMode mode);
+
+        /*!
+         * @brief 列值格式错误时抛出异常
+         * @param [in] column_index 列号
+         * @param [in] type_name 目标类型名
          */
-        explicit ResultSet(MYSQL *mysql);
+        [[noreturn]] void throwConversionError(uint32_t column_index, const char* type_name) const;
 
     public:
 
+        /*!
+         * @brief 构造函数：读取物化结果，多个结果集可共享同一物化结果，各自维护光标
+         * @param [in] result 物化结果
+         */
+        explicit ResultSet(std::shared_ptr<const MaterializedResult> result);
+
         /*!
          * @brief 禁止拷贝构造
          */
@@ -253,7 +519,7 @@ namespace sql {
         ResultSet& operator=(const ResultSet&) = delete;
 
         /*!
-         * @brief 析构函数
+         * @brief 析构函数；逐行读取时未读完的行在此读出并丢弃，之后连接才能执行其它语句
          */
         ~ResultSet();
 
@@ -302,6 +568,612 @@ namespace sql {
          * @return 获取到的数据
          */
         std::string getString(const std::string& column_label) const;
+
+        /*!
+         * @brief 根据列名获取列号，列名不存在时抛出异常
+         * @param [in] column_label 列名
+         * @return 列号
+         */
+        uint32_t findColumn(const std::string& column_label) const;
+
+        /*!
+         * @brief 根据列号判断列值是否为NULL
+         * @param [in] column_index 列号
+         * @return 是否为NULL
+         */
+        bool isNull(uint32_t column_index) const;
+
+        /*!
+         * @brief 根据列号获取列值的引用，不复制、不分配内存
+         * @param [in] column_index 列号
+         * @return 列值引用，NULL值的数据地址为空
+         */
+        StringRef getStringRef(uint32_t column_index) const;
+
+        /*!
+         * @brief 根据列名获取列值的引用，不复制、不分配内存
+         * @param [in] column_label 列名
+         * @return 列值引用，NULL值的数据地址为空
+         */
+        StringRef getStringRef(const std::string& column_label) const;
+
+        /*!
+         * @brief 根据列号获取列中64位整数数据，直接解析行数据
+         * @param [in] column_index 列号
+         * @return 获取到的数据，NULL值为0
+         */
+        int64_t getInt64(uint32_t column_index) const;
+
+        /*!
+         * @brief 根据列名获取列中64位整数数据，直接解析行数据
+         * @param [in] column_label 列名
+         * @return 获取到的数据，NULL值为0
+         */
+        int64_t getInt64(const std::string& column_label) const;
+
+        /*!
+         * @brief 根据列号获取列中double数据，直接解析行数据
+         * @param [in] column_index 列号
+         * @return 获取到的数据，NULL值为0
+         */
+        double getDouble(uint32_t column_index) const;
+
+        /*!
+         * @brief 根据列名获取列中double数据，直接解析行数据
+         * @param [in] column_label 列名
+         * @return 获取到的数据，NULL值为0
+         */
+        double getDouble(const std::string& column_label) const;
+
+        /*!
+         * @brief 根据列号获取DECIMAL列的定点数值，不经过浮点数，没有精度损失
+         * @param [in] column_index 列号
+         * @param [in] scale 结果的小数位数，列值多出的小数位被截断
+         * @return 列值乘以10的scale次方，NULL值为0
+         */
+        int64_t getDecimal(uint32_t column_index, unsigned int scale) const;
+
+        /*!
+         * @brief 根据列名获取DECIMAL列的定点数值，不经过浮点数，没有精度损失
+         * @param [in] column_label 列名
+         * @param [in] scale 结果的小数位数，列值多出的小数位被截断
+         * @return 列值乘以10的scale次方，NULL值为0
+         */
+        int64_t getDecimal(const std::string& column_label, unsigned int scale) const;
+
+        /*!
+         * @brief 根据列号获取DATE、DATETIME或TIMESTAMP列的日期时间
+         * @param [in] column_index 列号
+         * @return 获取到的数据，NULL值的各字段为0
+         */
+        DateTime getDateTime(uint32_t column_index) const;
+
+        /*!
+         * @brief 根据列名获取DATE、DATETIME或TIMESTAMP列的日期时间
+         * @param [in] column_label 列名
+         * @return 获取到的数据，NULL值的各字段为0
+         */
+        DateTime getDateTime(const std::string& column_label) const;
+    };
+
+    /*!
+     * @brief 异步sql执行类 \class
+     * 未完成时析构会阻塞等待语句执行完毕
+     */
+    class AsyncQuery {
+
+        // 将sql表达式类的异步执行函数声明为友元，可以访问异步查询类的构造函数
+        friend std::shared_ptr<AsyncQuery> Statement::executeQueryAsync(const std::string& sql);
+
+    private:
+
+        /*!
+         * @brief 执行阶段 \enum
+         */
+        enum class Phase {
+            /// 发送语句并等待服务器响应
+            Query,
+
+            /// 取回结果行
+            StoreResult,
+
+            /// 已完成或已出错
+            Done
+        };
+
+        /// 数据库连接句柄
+        MYSQL *m_mysql;
+
+        /// sql语句；非阻塞接口在完成前每次调用都须传入同一语句
+        std::string m_sql;
+
+        /// 当前执行阶段
+        Phase m_phase;
+
+        /// 执行完成后的结果集
+        std::shared_ptr<ResultSet> m_result;
+
+        /*!
+         * @brief 构造函数
+         * @param [in] mysql 连接句柄
+         * @param [in] sql sql语句
+         */
+        AsyncQuery(MYSQL *mysql, const std::string& sql);
+
+    public:
+
+        /*!
+         * @brief 禁止拷贝构造
+         */
+        AsyncQuery(const AsyncQuery&) = delete;
+
+        /*!
+         * @brief 禁止赋值
+         * @return AsyncQuery&
+         */
+        AsyncQuery& operator=(const AsyncQuery&) = delete;
+
+        /*!
+         * @brief 析构函数；语句尚未完成时以poll系统调用等待套接字就绪直至完成，结果与错误均丢弃
+         */
+        ~AsyncQuery();
+
+        /*!
+         * @brief 推进执行直至需要等待套接字，出错时抛出异常（之后isDone()为真）
+         * @return 是否已完成
+         */
+        bool poll();
+
+        /*!
+         * @brief 判断是否已完成或已出错
+         * @return 是否已完成
+         */
+        bool isDone() const;
+
+        /*!
+         * @brief 获取连接的套接字文件描述符，用于注册到epoll等待就绪
+         * @return 套接字文件描述符
+         */
+        int getSocket() const;
+
+        /*!
+         * @brief 获取结果集；结果已全部取回，可在连接归还后继续读取
+         * @return 结果集对象指针，未完成或出错时为空
+         */
+        std::shared_ptr<ResultSet> getResult() const;
+    };
+
+    /*!
+     * @brief 预处理语句句柄 \struct
+     * 由连接的缓存与相同SQL的预处理语句共享，执行序号用于判断结果集是否仍属于最近一次执行
+     */
+    struct StatementHandle {
+        /// 语句句柄
+        MYSQL_STMT *m_stmt;
+
+        /// 执行序号，每次执行递增
+        uint64_t m_generation;
+
+        /*!
+         * @brief 构造函数
+         * @param [in] stmt 语句句柄，关闭与否由句柄对象负责
+         */
+        explicit StatementHandle(MYSQL_STMT *stmt);
+
+        /*!
+         * @brief 禁止拷贝构造
+         */
+        StatementHandle(const StatementHandle&) = delete;
+
+        /*!
+         * @brief 禁止赋值
+         * @return StatementHandle&
+         */
+        StatementHandle& operator=(const StatementHandle&) = delete;
+
+        /*!
+         * @brief 析构函数：关闭语句句柄
+         */
+        ~StatementHandle();
+    };
+
+    /*!
+     * @brief 预处理语句类 \class
+     * 参数序号从1开始；同一连接上相同SQL的语句共享句柄，再次执行会使此前的结果集失效
+     */
+    class PreparedStatement {
+
+        // 将连接类的预处理语句创建函数声明为友元，可以访问预处理语句类的构造函数
+        friend std::shared_ptr<PreparedStatement> Connection::prepareStatement(const std::string& sql);
+
+    private:
+
+        /*!
+         * @brief 参数值存储 \struct
+         */
+        struct Parameter {
+            union {
+                /// 整数参数值
+                int64_t m_int;
+
+                /// 浮点参数值
+                double m_double;
+            };
+
+            /// 字符串参数值
+            std::string m_string;
+
+            /// 字符串参数长度
+            unsigned long m_length;
+        };
+
+        /// 语句句柄，与连接的缓存共享
+        std::shared_ptr<StatementHandle> m_handle;
+
+        /// 参数绑定，指向m_params中的存储
+        std::vector<MYSQL_BIND> m_binds;
+
+        /// 参数值存储
+        std::vector<Parameter> m_params;
+
+        /*!
+         * @brief 构造函数
+         * @param [in] handle 语句句柄
+         */
+        explicit PreparedStatement(const std::shared_ptr<StatementHandle>& handle);
+
+        /*!
+         * @brief 根据参数序号获取参数绑定，序号越界时抛出异常
+         * @param [in] parameter_index 参数序号
+         * @return 参数绑定
+         */
+        MYSQL_BIND& bindAt(uint32_t parameter_index);
+
+        /*!
+         * @brief 绑定参数并执行
+         * @param [in] caller_func 调用函数名
+         */
+        void execute(const char* caller_func);
+
+    public:
+
+        /*!
+         * @brief 禁止拷贝构造
+         */
+        PreparedStatement(const PreparedStatement&) = delete;
+
+        /*!
+         * @brief 禁止赋值
+         * @return PreparedStatement&
+         */
+        PreparedStatement& operator=(const PreparedStatement&) = delete;
+
+        /*!
+         * @brief 设置int参数
+         * @param [in] parameter_index 参数序号
+         * @param [in] value 参数值
+         */
+        void setInt(uint32_t parameter_index, int value);
+
+        /*!
+         * @brief 设置64位整数参数
+         * @param [in] parameter_index 参数序号
+         * @param [in] value 参数值
+         */
+        void setInt64(uint32_t parameter_index, int64_t value);
+
+        /*!
+         * @brief 设置无符号64位整数参数
+         * @param [in] parameter_index 参数序号
+         * @param [in] value 参数值
+         */
+        void setUInt64(uint32_t parameter_index, uint64_t value);
+
+        /*!
+         * @brief 设置double参数
+         * @param [in] parameter_index 参数序号
+         * @param [in] value 参数值
+         */
+        void setDouble(uint32_t parameter_index, double value);
+
+        /*!
+         * @brief 设置string参数
+         * @param [in] parameter_index 参数序号
+         * @param [in] value 参数值
+         */
+        void setString(uint32_t parameter_index, const std::string& value);
+
+        /*!
+         * @brief 设置string参数，value无需以'\0'结尾
+         * @param [in] parameter_index 参数序号
+         * @param [in] value 参数值
+         * @param [in] length 参数长度
+         */
+        void setString(uint32_t parameter_index, const char* value, size_t length);
+
+        /*!
+         * @brief 设置NULL参数
+         * @param [in] parameter_index 参数序号
+         */
+        void setNull(uint32_t parameter_index);
+
+        /*!
+         * @brief 将所有参数重置为NULL
+         */
+        void clearParameters();
+
+        /*!
+         * @brief 执行语句并获取结果集（结果一次性取回客户端）
+         * @return 结果集对象指针
+         */
+        std::shared_ptr<PreparedResultSet> executeQuery();
+
+        /*!
+         * @brief 执行不返回结果集的语句（INSERT、UPDATE、DELETE等）
+         * @return 影响行数
+         */
+        uint64_t executeUpdate();
+
+        /*!
+         * @brief 获取最近一次执行所生成的自增ID
+         * @return 自增ID
+         */
+        uint64_t getLastInsertId() const;
+    };
+
+    /*!
+     * @brief 预处理语句执行结果集类 \class
+     * 列号从1开始，NULL值读为0或空字符串
+     */
+    class PreparedResultSet {
+
+        // 将预处理语句类的执行函数声明为友元，可以访问结果集类的构造函数
+        friend std::shared_ptr<PreparedResultSet> PreparedStatement::executeQuery();
+
+    public:
+
+        /// 字符串列缓冲区的最小字节数，可容纳日期时间等定长类型的文本形式
+        static const unsigned long MinStringBufferSize = 32;
+
+    private:
+
+        /*!
+         * @brief 列缓冲区 \struct
+         */
+        struct Column {
+            /// 列名
+            std::string m_name;
+
+            union {
+                /// 整数列的值
+                int64_t m_int;
+
+                /// 浮点列的值
+                double m_double;
+            };
+
+            /// 字符串列的缓冲区
+            std::vector<char> m_buffer;
+
+            /// 值的实际长度
+            unsigned long m_length;
+
+            /// 值是否为NULL
+            BindFlag m_is_null;
+
+            /// 值是否被截断
+            BindFlag m_error;
+        };
+
+        /// 语句句柄
+        std::shared_ptr<StatementHandle> m_handle;
+
+        /// 本结果集对应的执行序号
+        uint64_t m_generation;
+
+        /// 执行结果行号（SELECT操作）
+        int m_row_num;
+
+        /// 语句影响行数（非SELECT操作）
+        uint64_t m_affect_row_num;
+
+        /// 结果列绑定，指向m_columns中的缓冲区
+        std::vector<MYSQL_BIND> m_binds;
+
+        /// 结果列缓冲区
+        std::vector<Column> m_columns;
+
+        /*!
+         * @brief 构造函数：取回全部结果行并为各列绑定缓冲区
+         * @param [in] handle 已执行的语句句柄
+         */
+        explicit PreparedResultSet(const std::shared_ptr<StatementHandle>& handle);
+
+        /*!
+         * @brief 扩大被截断列的缓冲区并重新读取该列
+         */
+        void fetchTruncatedColumns();
+
+        /*!
+         * @brief 根据列名获取列号，列名不存在时抛出异常
+         * @param [in] column_label 列名
+         * @return 列号
+         */
+        uint32_t findColumn(const std::string& column_label) const;
+
+    public:
+
+        /*!
+         * @brief 禁止拷贝构造
+         */
+        PreparedResultSet(const PreparedResultSet&) = delete;
+
+        /*!
+         * @brief 禁止赋值
+         * @return PreparedResultSet&
+         */
+        PreparedResultSet& operator=(const PreparedResultSet&) = delete;
+
+        /*!
+         * @brief 析构函数：句柄此后未再执行时释放结果，否则结果已属于新的执行
+         */
+        ~PreparedResultSet();
+
+        /*!
+         * @brief 将结果光标移动到下一行
+         * @return 是否还有数据，句柄已再次执行（本结果集失效）时返回false
+         */
+        bool next();
+
+        /*!
+         * @brief 读出其余各行，生成以文本形式保存列值的物化结果；之后本结果集没有数据
+         * @return 物化结果
+         */
+        std::shared_ptr<const MaterializedResult> materialize();
+
+        /*!
+         * @brief 获取sql操作影响行数
+         * @return 影响行数
+         */
+        uint64_t getAffectedRow() const;
+
+        /*!
+         * @brief 获取当前光标指向行行号
+         * @return 行号
+         */
+        int getRow() const;
+
+        /*!
+         * @brief 根据列号判断列值是否为NULL
+         * @param [in] column_index 列号
+         * @return 是否为NULL
+         */
+        bool isNull(uint32_t column_index) const;
+
+        /*!
+         * @brief 根据列号获取列中int数据
+         * @param [in] column_index 列号
+         * @return 获取到的数据
+         */
+        int getInt(uint32_t column_index) const;
+
+        /*!
+         * @brief 根据列名获取列中int数据
+         * @param [in] column_label 列名
+         * @return 获取到的数据
+         */
+        int getInt(const std::string& column_label) const;
+
+        /*!
+         * @brief 根据列号获取列中64位整数数据
+         * @param [in] column_index 列号
+         * @return 获取到的数据
+         */
+        int64_t getInt64(uint32_t column_index) const;
+
+        /*!
+         * @brief 根据列名获取列中64位整数数据
+         * @param [in] column_label 列名
+         * @return 获取到的数据
+         */
+        int64_t getInt64(const std::string& column_label) const;
+
+        /*!
+         * @brief 根据列号获取列中double数据
+         * @param [in] column_index 列号
+         * @return 获取到的数据
+         */
+        double getDouble(uint32_t column_index) const;
+
+        /*!
+         * @brief 根据列名获取列中double数据
+         * @param [in] column_label 列名
+         * @return 获取到的数据
+         */
+        double getDouble(const std::string& column_label) const;
+
+        /*!
+         * @brief 根据列号获取列中的string数据
+         * @param [in] column_index 列号
+         * @return 获取到的数据
+         */
+        std::string getString(uint32_t column_index) const;
+
+        /*!
+         * @brief 根据列名获取列中的string数据
+         * @param [in] column_label 列名
+         * @return 获取到的数据
+         */
+        std::string getString(const std::string& column_label) const;
+    };
+
+    /*!
+     * @brief 物化结果类 \class
+     * 结果集全部行的只读副本，可在多个线程间共享，通过ResultSet读取
+     */
+    class MaterializedResult {
+
+        // 读取列值与列名索引
+        friend class ResultSet;
+
+        // 预处理语句结果集生成物化结果
+        friend class PreparedResultSet;
+
+    private:
+
+        /// 列数
+        uint32_t m_column_num;
+
+        /// 行数
+        size_t m_row_num;
+
+        /// 列名到列号的索引
+        std::unordered_map<std::string, uint32_t> m_column_index;
+
+        /// 全部列值的存储
+        std::vector<char> m_data;
+
+        /// 各行各列值的地址，按行依次存放，指向m_data
+        std::vector<const char*> m_values;
+
+        /// 各行各列值的长度，与m_values一一对应
+        std::vector<unsigned long> m_lengths;
+
+        /*!
+         * @brief 构造函数
+         */
+        MaterializedResult();
+
+    public:
+
+        /*!
+         * @brief 禁止拷贝构造
+         */
+        MaterializedResult(const MaterializedResult&) = delete;
+
+        /*!
+         * @brief 禁止赋值
+         * @return MaterializedResult&
+         */
+        MaterializedResult& operator=(const MaterializedResult&) = delete;
+
+        /*!
+         * @brief 获取行数
+         * @return 行数
+         */
+        size_t getRowNum() const;
+
+        /*!
+         * @brief 获取列数
+         * @return 列数
+         */
+        uint32_t getColumnNum() const;
+
+        /*!
+         * @brief 获取占用的内存字节数（估计值），用于限制缓存的内存占用
+         * @return 字节数
+         */
+        size_t getMemorySize() const;
     };
 } // namespace sql
 } // namespace xjj
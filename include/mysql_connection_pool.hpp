@@ -5,15 +5,138 @@
 #ifndef _XJJ_MYSQL_CONNECTION_POOL_HPP
 #define _XJJ_MYSQL_CONNECTION_POOL_HPP
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
 #include <memory>
-#include <list>
+#include <string>
+#include <vector>
+#include "condition_variable.hpp"
+#include "histogram.hpp"
 #include "mutex.hpp"
 #include "mysql_connection.hpp"
 
 namespace xjj {
 
+    class MySQLConnectionPool;
+    class Session;
+
+    /*!
+     * @brief 等待连接超时异常类 \class
+     * 错误编号为0，表示并非MySQL返回的错误
+     */
+    class ConnectionTimeoutException : public sql::SQLException {
+    public:
+
+        /*!
+         * @brief 构造函数
+         * @param [in] msg 错误信息
+         */
+        explicit ConnectionTimeoutException(const std::string& msg);
+    };
+
+    /*!
+     * @brief 连接访问方式 \enum
+     */
+    enum class AccessMode {
+        /// 读写，使用主库连接
+        ReadWrite,
+
+        /// 只读，配置了副本时使用副本连接（副本数据可能落后于主库）
+        ReadOnly
+    };
+
+    /*!
+     * @brief 连接租约类 \class
+     * 持有从连接池借出的连接，析构时自动归还；只可移动，不可拷贝
+     */
+    class ConnectionLease {
+
+        // 会话在借出读写连接后登记自己，租约归还时通知会话写入结束
+        friend class Session;
+
+    private:
+
+        /// 连接所属的连接池指针
+        MySQLConnectionPool* m_pool;
+
+        /// 借出的连接对象
+        std::shared_ptr<sql::Connection> m_conn;
+
+        /// 通过会话借出的读写租约所属的会话，归还时通知其写入结束，其它租约为空
+        Session* m_session;
+
+    public:
+
+        /*!
+         * @brief 构造函数，构造空租约
+         */
+        ConnectionLease() noexcept;
+
+        /*!
+         * @brief 构造函数
+         * @param [in] pool 连接所属的连接池指针
+         * @param [in] conn 借出的连接对象
+         */
+        ConnectionLease(MySQLConnectionPool* pool, std::shared_ptr<sql::Connection> conn) noexcept;
+
+        /*!
+         * @brief 移动构造函数
+         * @param [in,out] other 被移动的租约
+         */
+        ConnectionLease(ConnectionLease&& other) noexcept;
+
+        /*!
+         * @brief 移动赋值，先归还本租约原有的连接
+         * @param [in,out] other 被移动的租约
+         * @return ConnectionLease&
+         */
+        ConnectionLease& operator=(ConnectionLease&& other) noexcept;
+
+        /*!
+         * @brief 禁止拷贝构造
+         */
+        ConnectionLease(const ConnectionLease&) = delete;
+
+        /*!
+         * @brief 禁止赋值
+         * @return ConnectionLease&
+         */
+        ConnectionLease& operator=(const ConnectionLease&) = delete;
+
+        /*!
+         * @brief 析构函数：归还连接
+         */
+        ~ConnectionLease();
+
+        /*!
+         * @brief 提前归还连接，之后租约为空
+         */
+        void reset();
+
+        /*!
+         * @brief 获取连接对象
+         * @return 连接对象，租约为空时为空
+         */
+        const std::shared_ptr<sql::Connection>& get() const noexcept;
+
+        /*!
+         * @brief 访问连接对象
+         * @return 连接对象指针
+         */
+        sql::Connection* operator->() const noexcept;
+
+        /*!
+         * @brief 判断租约是否持有连接
+         * @return 是否持有连接
+         */
+        explicit operator bool() const noexcept;
+    };
+
     /*!
      * @brief MySQL数据库连接池类 \class
+     * 连接数在最小与最大值之间伸缩，断开的连接由下一个需要者重新建立
      */
     class MySQLConnectionPool {
     private:
@@ -21,8 +144,8 @@ namespace xjj {
         /// 配置文件名
         static const std::string ConfigFileName;
 
-        /// 用于获取连接池单例的互斥量
-        static Mutex m_instance_mutex;
+        /// 保护连接池单例的读写锁，创建后只需读锁
+        static RWMutex m_instance_mutex;
 
         /// 连接池全局单例
         static std::shared_ptr<MySQLConnectionPool> m_instance;
@@ -30,11 +153,72 @@ namespace xjj {
         /// 数据库驱动对象
         std::shared_ptr<sql::Driver> m_driver;
 
+        /*!
+         * @brief 等待连接的线程 \struct
+         * 位于等待者的栈上，归还连接的线程将连接直接交给队首的等待者
+         */
+        struct Waiter {
+            /// 等待者专用的条件变量
+            ConditionVariable m_cond;
+
+            /// 交给等待者的连接，为空表示尚未得到
+            std::shared_ptr<sql::Connection> m_conn;
+
+            /// 等待者获准自行新建连接（已为其计入打开的连接数）
+            bool m_may_connect = false;
+        };
+
+        /*!
+         * @brief 只读副本 \struct
+         */
+        struct Replica {
+            /// 副本地址
+            std::string m_host;
+
+            /// 副本端口
+            unsigned int m_port;
+
+            /// 权重，按借出连接数与权重之比选择副本
+            uint64_t m_weight;
+
+            /// 副本的连接池
+            std::unique_ptr<MySQLConnectionPool> m_pool;
+        };
+
+        /*!
+         * @brief 空闲连接 \struct
+         */
+        struct IdleConnection {
+            /// 连接对象
+            std::shared_ptr<sql::Connection> m_conn;
+
+            /// 开始闲置的时间点，用于淘汰
+            std::chrono::steady_clock::time_point m_idle_since;
+
+            /// 最近一次确认可用（归还或ping成功）的时间点，用于校验
+            std::chrono::steady_clock::time_point m_checked_at;
+        };
+
         /// 用于获取连接池中连接的互斥量
         Mutex m_list_mutex;
 
-        /// 存放连接对象指针的双头链表
-        std::list<std::shared_ptr<sql::Connection>> m_conn_list;
+        /// 空闲连接，尾部为最近归还的连接；借出取尾部，使多余连接闲置而被淘汰
+        std::deque<IdleConnection> m_idle_list;
+
+        /// 按到达顺序排队的等待者；有等待者时空闲链表必为空，后来者不能插队
+        std::deque<Waiter*> m_waiters;
+
+        /// 已打开及正在打开的连接数（含空闲与借出的连接）
+        size_t m_open_num;
+
+        /// 获取连接的等待时长分布，以纳秒为单位，无需等待时记为0
+        Histogram m_wait_histogram;
+
+        /// 等待超时次数
+        std::atomic<uint64_t> m_timeout_num;
+
+        /// 因断开或ping失败而丢弃的连接数
+        std::atomic<uint64_t> m_broken_num;
 
         /// 数据库地址
         std::string m_host;
@@ -51,8 +235,35 @@ namespace xjj {
         /// 连接端口
         unsigned int m_port;
 
-        /// 连接池大小
-        size_t m_pool_size;
+        /// 连接数下限，启动时建立，不因闲置而淘汰
+        size_t m_min_size;
+
+        /// 连接数上限
+        size_t m_max_size;
+
+        /// 不带超时参数的getConnection的等待时长上限，0表示一直等待
+        std::chrono::milliseconds m_wait_timeout;
+
+        /// 多余连接闲置超过该时长后关闭，0表示不淘汰
+        std::chrono::seconds m_idle_timeout;
+
+        /// 连接闲置超过该时长后借出前先ping
+        std::chrono::milliseconds m_validate_interval;
+
+        /// 借出未归还的连接数，用于在副本间均衡负载
+        std::atomic<size_t> m_outstanding_num;
+
+        /// 新建连接失败后暂不选择本池（副本）的截止时间点，以steady_clock的纳秒数表示
+        std::atomic<int64_t> m_down_until;
+
+        /// 只读副本（仅主库连接池有）
+        std::vector<Replica> m_replicas;
+
+        /// 副本新建连接失败后暂不选择该副本的时长
+        std::chrono::milliseconds m_replica_retry_interval;
+
+        /// Session归还读写连接后读操作仍使用主库的时长，0表示不保证读到自己的写入
+        std::chrono::milliseconds m_read_your_writes_window;
 
         /*!
          * @brief 获取配置文件内容
@@ -60,12 +271,92 @@ namespace xjj {
         void getConfiguration();
 
         /*!
-         * @brief 构造函数
+         * @brief 新建连接，在互斥量外调用
+         * @return 连接对象
+         * @throw sql::SQLException 连接失败
+         */
+        std::shared_ptr<sql::Connection> connect();
+
+        /*!
+         * @brief 将连接交给最早的等待者，没有等待者时放入空闲链表，须持有互斥量
+         * @param [in] conn 连接对象
+         * @param [in] idle_since 开始闲置的时间点
+         * @param [in] checked_at 最近一次确认可用的时间点
+         */
+        void putConnectionLocked(std::shared_ptr<sql::Connection> conn,
+                                 std::chrono::steady_clock::time_point idle_since,
+                                 std::chrono::steady_clock::time_point checked_at);
+
+        /*!
+         * @brief 减少一个打开的连接数，并在有等待者时准许最早的等待者新建连接，须持有互斥量
+         */
+        void dropConnectionLocked();
+
+        /*!
+         * @brief 取出闲置超时的多余连接，须持有互斥量；连接由调用者在互斥量外关闭
+         * @param [in] now 当前时间点
+         * @param [out] evicted 被淘汰的连接
+         */
+        void evictIdleLocked(std::chrono::steady_clock::time_point now,
+                             std::vector<std::shared_ptr<sql::Connection>>& evicted);
+
+        /*!
+         * @brief 获取连接，没有空闲连接时排队等待
+         * @param [in] deadline 截止时间点，为空表示一直等待
+         * @return 连接对象
+         * @throw ConnectionTimeoutException 超过截止时间仍未得到连接
+         */
+        std::shared_ptr<sql::Connection> takeConnection(const std::chrono::steady_clock::time_point* deadline);
+
+        /*!
+         * @brief 选择借出连接数与权重之比最小的可用副本
+         * @return 副本的连接池，没有可用副本时为空
+         */
+        MySQLConnectionPool* chooseReplica();
+
+        /*!
+         * @brief 建立下限数目的连接
+         * @param [in] tolerate_failure 是否容忍连接失败（副本不可用时不影响启动）
+         */
+        void openMinConnections(bool tolerate_failure);
+
+        /*!
+         * @brief 构造函数，读取配置文件，建立主库与各副本的连接池
          */
         MySQLConnectionPool();
 
+        /*!
+         * @brief 构造函数，建立副本的连接池，除地址与端口外的配置与主库相同
+         * @param [in] primary 主库连接池
+         * @param [in] replica 副本
+         */
+        MySQLConnectionPool(const MySQLConnectionPool& primary, const Replica& replica);
+
     public:
 
+        /*!
+         * @brief 连接池等待统计快照 \struct
+         */
+        struct WaitStats {
+            /// 获取连接的等待时长分布，以纳秒为单位
+            Histogram::Snapshot m_wait;
+
+            /// 等待超时次数
+            uint64_t m_timeouts;
+
+            /// 正在等待的线程数
+            size_t m_waiting;
+
+            /// 空闲连接数
+            size_t m_idle;
+
+            /// 当前打开的连接数
+            size_t m_pool_size;
+
+            /// 因断开或ping失败而丢弃的连接数
+            uint64_t m_broken;
+        };
+
         /*!
          * @brief 析构函数
          */
@@ -78,17 +369,126 @@ namespace xjj {
         static std::shared_ptr<MySQLConnectionPool> getInstance();
 
         /*!
-         * @brief 获取连接对象
+         * @brief 获取连接对象，没有空闲连接时按先来先得排队等待，
+         * 等待时长上限由配置项db_pool_timeout_ms指定，缺省时一直等待；须调用returnConnection归还
          * @return 连接对象
+         * @throw ConnectionTimeoutException 等待超时
          */
         std::shared_ptr<sql::Connection> getConnection();
 
         /*!
-         * @brief 返还连接
+         * @brief 获取连接租约，没有空闲连接时按先来先得排队等待，租约析构时自动归还连接
+         * @param [in] timeout 等待时长上限
+         * @return 连接租约
+         * @throw ConnectionTimeoutException 等待超时
+         */
+        ConnectionLease getConnection(std::chrono::nanoseconds timeout);
+
+        /*!
+         * @brief 按访问方式获取连接租约：读写使用主库；只读在可用副本中选择借出连接数与权重之比最小者，
+         * 没有副本或副本新建连接失败时使用主库
+         * @param [in] mode 访问方式
+         * @param [in] timeout 等待时长上限
+         * @return 连接租约
+         * @throw ConnectionTimeoutException 等待超时
+         */
+        ConnectionLease getConnection(AccessMode mode, std::chrono::nanoseconds timeout);
+
+        /*!
+         * @brief 返还连接，有等待者时直接交给最早的等待者；已断开的连接被丢弃
          * @param [in] conn 目标连接对象
          */
         void returnConnection(std::shared_ptr<sql::Connection> conn);
 
+        /*!
+         * @brief 获取等待统计快照，可据此确定连接池大小
+         * @return 等待统计快照
+         */
+        WaitStats getWaitStats();
+
+        /*!
+         * @brief 获取副本数目
+         * @return 副本数目
+         */
+        size_t getReplicaNum() const;
+
+        /*!
+         * @brief 获取副本连接池的等待统计快照
+         * @param [in] index 副本序号，与配置项db_replicas中的顺序相同
+         * @return 等待统计快照
+         */
+        WaitStats getReplicaWaitStats(size_t index);
+
+        /*!
+         * @brief 获取配置的读己之写时长，Session缺省使用该值
+         * @return 读己之写时长
+         */
+        std::chrono::milliseconds getReadYourWritesWindow() const;
+
+        /*!
+         * @brief 维护连接池：淘汰闲置超时的多余连接，ping闲置超过校验间隔的连接并重建不可用的连接，
+         * 补足连接数下限。借出时已会按需完成这些工作，本函数供定期后台调用，
+         * 如 thread_pool.scheduleEvery(std::chrono::seconds(30), [pool] { pool -> maintain(); })；
+         * 同时维护各副本的连接池
+         */
+        void maintain();
+
+    };
+
+    /*!
+     * @brief 会话类 \class
+     * 写入后的读己之写时长内，只读操作也使用主库；不可在多个线程间共享
+     */
+    class Session {
+    private:
+
+        /// 连接池指针
+        MySQLConnectionPool* m_pool;
+
+        /// 读己之写时长
+        std::chrono::milliseconds m_window;
+
+        /// 最近一次归还读写连接（写入结束）的时间点
+        std::chrono::steady_clock::time_point m_last_write;
+
+        /// 是否归还过读写连接
+        bool m_has_written;
+
+        /// 尚未归还的读写连接数
+        size_t m_writing_num;
+
+        // 读写租约归还时调用finishWrite
+        friend class ConnectionLease;
+
+        /*!
+         * @brief 读写租约归还时调用，记录写入结束的时间点
+         */
+        void finishWrite();
+
+    public:
+
+        /*!
+         * @brief 构造函数，读己之写时长取配置项db_read_your_writes_ms
+         * @param [in] pool 连接池指针
+         */
+        explicit Session(MySQLConnectionPool* pool);
+
+        /*!
+         * @brief 构造函数
+         * @param [in] pool 连接池指针
+         * @param [in] window 读己之写时长，应大于副本的复制延迟
+         */
+        Session(MySQLConnectionPool* pool, std::chrono::milliseconds window);
+
+        /*!
+         * @brief 按访问方式获取连接租约；读写租约未归还期间及归还后的读己之写时长内，只读操作使用主库；
+         * 读写租约须在会话析构前归还
+         * @param [in] mode 访问方式
+         * @param [in] timeout 等待时长上限
+         * @return 连接租约
+         * @throw ConnectionTimeoutException 等待超时
+         */
+        ConnectionLease getConnection(AccessMode mode, std::chrono::nanoseconds timeout);
     };
 } // namespace xjj
 
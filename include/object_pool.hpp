@@ -0,0 +1,275 @@
+//
+// created by agent on 2026-10-19
+//
+
+#ifndef _XJJ_OBJECT_POOL_HPP
+#define _XJJ_OBJECT_POOL_HPP
+
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "mutex.hpp"
+
+namespace xjj {
+    /*!
+     * @brief 对象池模板类 \class
+     * 每个线程缓存一条空闲链表，与全局溢出链表整批交换；申请的内存不再归还系统
+     * @tparam T 对象类型，对齐要求不超过std::max_align_t
+     */
+    template <typename T>
+    class ObjectPool {
+    public:
+
+        /// 线程缓存与全局溢出链表之间一次交换的对象数，也是一次申请内存的对象数
+        static const size_t BatchSize = 32;
+
+        /// 线程缓存的空闲对象数上限，超过时将BatchSize个交还全局链表
+        static const size_t MaxLocalNum = 2 * BatchSize;
+
+        /*!
+         * @brief 销毁对象并归还池的删除器 \struct
+         */
+        struct Deleter {
+            void operator() (T* object) const {
+                destroy(object);
+            }
+        };
+
+        /// 自动归还池的对象指针类型
+        typedef std::unique_ptr<T, Deleter> Ptr;
+
+        /*!
+         * @brief 从池中取内存并构造对象
+         * @tparam Args 构造参数类型
+         * @param [in] args 构造参数
+         * @return 对象指针，须以destroy销毁
+         */
+        template <typename... Args>
+        static T* create(Args&&... args) {
+            Slot* slot = acquireSlot();
+            try {
+                return new (&slot -> m_storage) T(std::forward<Args>(args)...);
+            } catch (...) {
+                releaseSlot(slot);
+                throw;
+            }
+        }
+
+        /*!
+         * @brief 从池中取内存并构造对象，返回自动归还池的对象指针
+         * @tparam Args 构造参数类型
+         * @param [in] args 构造参数
+         * @return 对象指针
+         */
+        template <typename... Args>
+        static Ptr makeUnique(Args&&... args) {
+            return Ptr(create(std::forward<Args>(args)...));
+        }
+
+        /*!
+         * @brief 析构对象并将内存归还池
+         * @param [in] object create返回的对象指针，为空时不做任何事
+         */
+        static void destroy(T* object) {
+            if (!object)
+                return;
+            object -> ~T();
+            releaseSlot(reinterpret_cast<Slot*>(object));
+        }
+
+    private:
+
+        static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned types are not supported");
+
+        /*!
+         * @brief 对象存储单元，空闲时存放链表指针 \union
+         */
+        union Slot {
+            /*!
+             * @brief 空闲链表指针 \struct
+             */
+            struct Link {
+                /// 同一批中的下一个空闲单元
+                Slot* m_next;
+
+                /// 全局链表中的下一批（只在每批的首个单元中有效）
+                Slot* m_next_batch;
+
+                /// 本批的单元数（只在每批的首个单元中有效）
+                size_t m_batch_num;
+            } m_link;
+
+            /// 对象存储区
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type m_storage;
+        };
+
+        /*!
+         * @brief 线程缓存 \struct
+         * 可平凡析构，线程退出过程中（其它thread_local对象析构时）仍可访问
+         */
+        struct LocalCache {
+            /// 空闲链表
+            Slot* m_free;
+
+            /// 空闲单元数
+            size_t m_num;
+
+            /// 是否已登记线程退出时的归还
+            bool m_registered;
+
+            /// 线程是否正在退出：缓存已归还，之后的创建与销毁直接操作全局链表
+            bool m_exited;
+        };
+
+        /*!
+         * @brief 线程退出时归还线程缓存 \struct
+         */
+        struct LocalCacheFlusher {
+            ~LocalCacheFlusher() {
+                LocalCache& cache = localCache();
+                if (cache.m_free)
+                    pushBatch(cache.m_free, cache.m_num);
+                cache.m_free = nullptr;
+                cache.m_num = 0;
+                cache.m_exited = true;
+            }
+        };
+
+        /*!
+         * @brief 全局溢出链表 \struct
+         */
+        struct Global {
+            Global() : m_mutex("ObjectPool", true), m_batches(nullptr) {}
+
+            /// 保护批链表的互斥量
+            Mutex m_mutex;
+
+            /// 批链表，每批是一条空闲链表
+            Slot* m_batches;
+        };
+
+        /*!
+         * @brief 获取全局溢出链表；不析构，因为线程缓存可能在静态析构之后才归还
+         * @return 全局溢出链表
+         */
+        static Global& global() {
+            static Global* global_ptr = new Global();
+            return *global_ptr;
+        }
+
+        /*!
+         * @brief 获取当前线程的缓存
+         * @return 线程缓存
+         */
+        static LocalCache& localCache() {
+            static thread_local LocalCache cache = {nullptr, 0, false, false};
+            if (!cache.m_registered) {
+                cache.m_registered = true;
+                static thread_local LocalCacheFlusher flusher;
+                (void) flusher;
+            }
+            return cache;
+        }
+
+        /*!
+         * @brief 取一个空闲单元，线程缓存为空时先补充
+         * @return 空闲单元
+         */
+        static Slot* acquireSlot() {
+            LocalCache& cache = localCache();
+            if (cache.m_exited) {
+                // 线程正在退出：借用临时缓存取一批，剩余的立即交还全局链表
+                LocalCache exit_cache = {nullptr, 0, true, true};
+                refill(exit_cache);
+                Slot* slot = exit_cache.m_free;
+                if (slot -> m_link.m_next)
+                    pushBatch(slot -> m_link.m_next, exit_cache.m_num - 1);
+                return slot;
+            }
+            if (!cache.m_free)
+                refill(cache);
+            Slot* slot = cache.m_free;
+            cache.m_free = slot -> m_link.m_next;
+            cache.m_num--;
+            return slot;
+        }
+
+        /*!
+         * @brief 归还空闲单元，线程缓存超过上限时交还一批
+         * @param [in] slot 空闲单元
+         */
+        static void releaseSlot(Slot* slot) {
+            LocalCache& cache = localCache();
+            if (cache.m_exited) {  // 线程正在退出，单个单元作为一批交还全局链表
+                slot -> m_link.m_next = nullptr;
+                pushBatch(slot, 1);
+                return;
+            }
+            slot -> m_link.m_next = cache.m_free;
+            cache.m_free = slot;
+            if (++cache.m_num <= MaxLocalNum)
+                return;
+
+            // 切下链表前BatchSize个单元交还全局链表
+            Slot* batch = cache.m_free;
+            Slot* last = batch;
+            for (size_t i = 1; i < BatchSize; i++)
+                last = last -> m_link.m_next;
+            cache.m_free = last -> m_link.m_next;
+            cache.m_num -= BatchSize;
+            last -> m_link.m_next = nullptr;
+            pushBatch(batch, BatchSize);
+        }
+
+        /*!
+         * @brief 为空的线程缓存补充一批空闲单元：优先取全局链表，否则申请内存
+         * @param [in,out] cache 线程缓存
+         */
+        static void refill(LocalCache& cache) {
+            Global& pool = global();
+            {
+                AutoLockMutex lock(&pool.m_mutex);
+                if (pool.m_batches) {
+                    Slot* batch = pool.m_batches;
+                    pool.m_batches = batch -> m_link.m_next_batch;
+                    cache.m_free = batch;
+                    cache.m_num = batch -> m_link.m_batch_num;
+                    return;
+                }
+            }
+
+            auto chunk = static_cast<Slot*>(malloc(sizeof(Slot) * BatchSize));
+            if (!chunk)
+                throw std::bad_alloc();
+            for (size_t i = 0; i + 1 < BatchSize; i++)
+                chunk[i].m_link.m_next = &chunk[i + 1];
+            chunk[BatchSize - 1].m_link.m_next = nullptr;
+            cache.m_free = chunk;
+            cache.m_num = BatchSize;
+        }
+
+        /*!
+         * @brief 将一批空闲单元放入全局链表
+         * @param [in] batch 空闲链表
+         * @param [in] num 单元数
+         */
+        static void pushBatch(Slot* batch, size_t num) {
+            Global& pool = global();
+            AutoLockMutex lock(&pool.m_mutex);
+            batch -> m_link.m_batch_num = num;
+            batch -> m_link.m_next_batch = pool.m_batches;
+            pool.m_batches = batch;
+        }
+    };
+
+    template <typename T>
+    const size_t ObjectPool<T>::BatchSize;
+
+    template <typename T>
+    const size_t ObjectPool<T>::MaxLocalNum;
+} // namespace xjj
+
+#endif
@@ -0,0 +1,421 @@
+//
+// created by agent on 2026-10-19
+//
+
+#ifndef _XJJ_QUERY_CACHE_HPP
+#define _XJJ_QUERY_CACHE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "mutex.hpp"
+#include "mysql_connection.hpp"
+#include "mysql_connection_pool.hpp"
+
+namespace xjj {
+
+    /*!
+     * @brief 查询参数类 \class
+     * 按顺序记录预处理语句的参数值（序号从1开始），同时编码为缓存键的一部分
+     */
+    class QueryParameters {
+    public:
+
+        /*!
+         * @brief 添加整数参数
+         * @param [in] value 参数值
+         * @return 本对象
+         */
+        QueryParameters& addInt64(int64_t value);
+
+        /*!
+         * @brief 添加浮点参数
+         * @param [in] value 参数值
+         * @return 本对象
+         */
+        QueryParameters& addDouble(double value);
+
+        /*!
+         * @brief 添加字符串参数
+         * @param [in] value 参数值
+         * @return 本对象
+         */
+        QueryParameters& addString(const std::string& value);
+
+        /*!
+         * @brief 添加字符串参数
+         * @param [in] value 字符串起始地址
+         * @param [in] length 字符串长度
+         * @return 本对象
+         */
+        QueryParameters& addString(const char* value, size_t length);
+
+        /*!
+         * @brief 添加NULL参数
+         * @return 本对象
+         */
+        QueryParameters& addNull();
+
+        /*!
+         * @brief 将参数依次设置到预处理语句
+         * @param [in] stmt 预处理语句
+         */
+        void bind(sql::PreparedStatement& stmt) const;
+
+        /*!
+         * @brief 获取参数的编码，不同的参数序列编码不同
+         * @return 编码
+         */
+        const std::string& getEncoded() const;
+
+    private:
+
+        /*!
+         * @brief 参数类型标记 \enum
+         */
+        enum Tag : char {
+            /// 整数，其后为8字节数值
+            IntTag = 'i',
+
+            /// 浮点数，其后为8字节数值
+            DoubleTag = 'd',
+
+            /// 字符串，其后为8字节长度与内容
+            StringTag = 's',
+
+            /// NULL
+            NullTag = 'n'
+        };
+
+        /*!
+         * @brief 在编码末尾追加类型标记与定长数值
+         * @tparam T 数值类型
+         * @param [in] tag 类型标记
+         * @param [in] value 数值
+         */
+        template <typename T>
+        void append(Tag tag, T value);
+
+        /*!
+         * @brief 从编码中读出定长数值
+         * @tparam T 数值类型
+         * @param [in,out] pos 读取位置，读出后后移
+         * @return 数值
+         */
+        template <typename T>
+        T read(size_t& pos) const;
+
+        /// 参数编码：每个参数为类型标记加定长数值，字符串参数为长度加内容
+        std::string m_encoded;
+    };
+
+    /*!
+     * @brief 查询结果缓存类 \class
+     * 经本缓存执行的写语句使所涉及表的结果失效，其它途径的写入只能等待结果过期
+     */
+    class QueryCache {
+    public:
+
+        /*!
+         * @brief 缓存统计 \struct
+         */
+        struct Stats {
+            /// 命中次数
+            uint64_t m_hit;
+
+            /// 未命中次数（含不可缓存的查询）
+            uint64_t m_miss;
+
+            /// 因容量不足淘汰的结果数
+            uint64_t m_eviction;
+
+            /// 写语句使表失效的次数
+            uint64_t m_invalidation;
+
+            /// 当前缓存的结果数
+            size_t m_entry_num;
+
+            /// 当前缓存占用的内存字节数（估计值）
+            size_t m_memory_size;
+        };
+
+        /// 默认的分片数目
+        static const size_t DefaultShardNum = 16;
+
+        /// 表写入后未命中的查询仍使用主库的最短时长，避免从复制延迟的副本读到旧数据并缓存整个存活时长；
+        /// 连接池的db_read_your_writes_ms更长时取后者
+        static constexpr std::chrono::milliseconds MinReadYourWritesWindow{1000};
+
+        /*!
+         * @brief 构造函数
+         * @param [in] pool 连接池指针
+         * @param [in] capacity 缓存占用的内存字节数上限，平均分配给各分片；超过分片容量的结果不缓存
+         * @param [in] ttl 结果的默认存活时长
+         * @param [in] connection_timeout 获取连接的等待时长上限
+         * @param [in] shard_num 分片数目，默认为DefaultShardNum
+         */
+        QueryCache(MySQLConnectionPool* pool, size_t capacity, std::chrono::milliseconds ttl,
+                   std::chrono::nanoseconds connection_timeout, size_t shard_num = DefaultShardNum);
+
+        /*!
+         * @brief 禁止拷贝构造
+         */
+        QueryCache(const QueryCache&) = delete;
+
+        /*!
+         * @brief 禁止赋值
+         * @return QueryCache&
+         */
+        QueryCache& operator=(const QueryCache&) = delete;
+
+        /*!
+         * @brief 执行查询，命中时直接返回缓存的结果；SELECT ... FOR UPDATE等不可缓存的语句直接执行，
+         * 写语句执行后使相关表失效
+         * @param [in] sql 以?为参数占位符的sql语句
+         * @param [in] params 参数
+         * @param [in] ttl 本次缓存结果的存活时长，0表示使用默认存活时长
+         * @return 结果集
+         * @throw SQLException 查询出错、获取连接超时等
+         */
+        std::shared_ptr<sql::ResultSet> executeQuery(const std::string& sql,
+                                                     const QueryParameters& params = QueryParameters(),
+                                                     std::chrono::milliseconds ttl = std::chrono::milliseconds::zero());
+
+        /*!
+         * @brief 在主库上执行写语句，之后使所涉及表的缓存结果失效
+         * @param [in] sql 以?为参数占位符的sql语句
+         * @param [in] params 参数
+         * @return 影响行数
+         * @throw SQLException 执行出错、获取连接超时等
+         */
+        uint64_t executeUpdate(const std::string& sql, const QueryParameters& params = QueryParameters());
+
+        /*!
+         * @brief 使某个表的全部缓存结果失效，用于其它途径写入后
+         * @param [in] table 表名，不区分数据库名
+         */
+        void invalidate(const std::string& table);
+
+        /*!
+         * @brief 使全部缓存结果失效
+         */
+        void invalidateAll();
+
+        /*!
+         * @brief 获取缓存统计
+         * @return 缓存统计
+         */
+        Stats getStats() const;
+
+    private:
+
+        /*!
+         * @brief 表的失效状态 \struct
+         * 创建后不删除，缓存结果保存其指针
+         */
+        struct Table {
+            /// 版本号，每次写入后递增
+            std::atomic<uint64_t> m_version;
+
+            /// 最近一次写入的时间点（steady_clock的计数）
+            std::atomic<int64_t> m_written_at;
+        };
+
+        /*!
+         * @brief 语句类别 \enum
+         */
+        enum class StatementKind {
+            /// 可缓存的SELECT
+            Cacheable,
+
+            /// 不可缓存的只读语句（SELECT ... FOR UPDATE、SHOW等）
+            Uncacheable,
+
+            /// 已识别所涉及表的写语句
+            Write,
+
+            /// 其它语句（DDL等），执行后使全部结果失效
+            Other
+        };
+
+        /*!
+         * @brief 语句的分析结果 \struct
+         */
+        struct StatementInfo {
+            /// 语句类别
+            StatementKind m_kind;
+
+            /// 规整后的语句，作为缓存键的前缀
+            std::string m_normalized;
+
+            /// 所涉及的表
+            std::vector<Table*> m_tables;
+        };
+
+        /*!
+         * @brief 缓存的结果 \struct
+         */
+        struct Entry {
+            /// 缓存键
+            std::string m_key;
+
+            /// 物化结果
+            std::shared_ptr<const sql::MaterializedResult> m_result;
+
+            /// 过期时间点
+            std::chrono::steady_clock::time_point m_expire_time;
+
+            /// 查询前所涉及各表的版本号
+            std::vector<std::pair<Table*, uint64_t>> m_versions;
+
+            /// 占用的内存字节数
+            size_t m_size;
+        };
+
+        /*!
+         * @brief 缓存分片 \struct
+         */
+        struct Shard {
+            /*!
+             * @brief 构造函数
+             */
+            Shard();
+
+            /// 保护本分片的互斥量
+            Mutex m_mutex;
+
+            /// LRU链表，表头为最近使用的结果
+            std::list<Entry> m_lru;
+
+            /// 缓存键到链表节点的索引
+            std::unordered_map<std::string, std::list<Entry>::iterator> m_index;
+
+            /// 本分片占用的内存字节数
+            size_t m_size;
+        };
+
+        /// 语句分析结果的缓存数目上限，超出后（sql中拼接了参数值）每次重新分析
+        static const size_t MaxStatementNum = 1024;
+
+        /*!
+         * @brief 获取语句的分析结果，分析过的语句直接返回
+         * @param [in] sql sql语句
+         * @return 分析结果
+         */
+        std::shared_ptr<const StatementInfo> getStatementInfo(const std::string& sql);
+
+        /*!
+         * @brief 分析语句：规整空白、识别类别与所涉及的表
+         * @param [in] sql sql语句
+         * @return 分析结果
+         */
+        std::shared_ptr<const StatementInfo> analyze(const std::string& sql);
+
+        /*!
+         * @brief 获取表的失效状态，首次出现时创建
+         * @param [in] table 表名
+         * @return 失效状态
+         */
+        Table* getTable(const std::string& table);
+
+        /*!
+         * @brief 获取缓存键所在的分片
+         * @param [in] key 缓存键
+         * @return 分片
+         */
+        Shard& getShard(const std::string& key);
+
+        /*!
+         * @brief 查找未过期且所涉及表未写入过的结果
+         * @param [in] key 缓存键
+         * @return 物化结果，未命中时为空
+         */
+        std::shared_ptr<const sql::MaterializedResult> lookup(const std::string& key);
+
+        /*!
+         * @brief 放入结果，查询期间所涉及表有写入时放弃
+         * @param [in] entry 待放入的结果
+         */
+        void insert(Entry&& entry);
+
+        /*!
+         * @brief 从分片中移除结果；调用时须持有分片的互斥量
+         * @param [in] shard 分片
+         * @param [in] it 结果所在的链表节点
+         */
+        static void eraseLocked(Shard& shard, std::list<Entry>::iterator it);
+
+        /*!
+         * @brief 执行查询并取回全部结果，归还连接前生成物化结果
+         * @param [in] sql sql语句
+         * @param [in] params 参数
+         * @param [in] mode 访问方式
+         * @return 物化结果
+         */
+        std::shared_ptr<const sql::MaterializedResult> query(const std::string& sql, const QueryParameters& params,
+                                                             AccessMode mode);
+
+        /*!
+         * @brief 写语句执行后使所涉及的表失效
+         * @param [in] info 语句的分析结果
+         */
+        void invalidate(const StatementInfo& info);
+
+        /*!
+         * @brief 判断所涉及的表是否在读己之写的时间窗口内写入过
+         * @param [in] info 语句的分析结果
+         * @return 是否写入过
+         */
+        bool isRecentlyWritten(const StatementInfo& info) const;
+
+        /// 连接池指针
+        MySQLConnectionPool* m_pool;
+
+        /// 每个分片占用的内存字节数上限
+        size_t m_shard_capacity;
+
+        /// 结果的默认存活时长
+        std::chrono::milliseconds m_ttl;
+
+        /// 获取连接的等待时长上限
+        std::chrono::nanoseconds m_connection_timeout;
+
+        /// 表写入后未命中的查询仍使用主库的时长
+        std::chrono::milliseconds m_read_your_writes_window;
+
+        /// 缓存分片
+        std::vector<std::unique_ptr<Shard>> m_shards;
+
+        /// 语句分析结果，以原始sql为键
+        std::unordered_map<std::string, std::shared_ptr<const StatementInfo>> m_statements;
+
+        /// 保护语句分析结果的读写锁，分析过的语句只需读锁
+        RWMutex m_statement_mutex;
+
+        /// 表名到失效状态的映射
+        std::unordered_map<std::string, std::unique_ptr<Table>> m_tables;
+
+        /// 保护表映射的互斥量
+        Mutex m_table_mutex;
+
+        /// 命中次数
+        std::atomic<uint64_t> m_hit_num;
+
+        /// 未命中次数
+        std::atomic<uint64_t> m_miss_num;
+
+        /// 淘汰的结果数
+        std::atomic<uint64_t> m_eviction_num;
+
+        /// 失效次数
+        std::atomic<uint64_t> m_invalidation_num;
+    };
+}
+
+#endif //_XJJ_QUERY_CACHE_HPP
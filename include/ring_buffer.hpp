@@ -0,0 +1,176 @@
+//
+// created by agent on 2026-10-18
+//
+
+#ifndef _XJJ_RING_BUFFER_HPP
+#define _XJJ_RING_BUFFER_HPP
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace xjj {
+    /*!
+     * @brief 环形缓冲区模板类 \class
+     * 接口同std::queue，存储区满时翻倍且不收缩
+     * @tparam T 元素类型
+     */
+    template <typename T>
+    class RingBuffer {
+    public:
+        /// 队列长度数据类型
+        typedef size_t size_type;
+
+        /// 默认初始容量
+        static const size_type DefaultCapacity = 16;
+
+        /*!
+         * @brief 构造函数
+         * @param [in] capacity 初始容量，向上取整为2的幂
+         */
+        explicit RingBuffer(size_type capacity = DefaultCapacity)
+                : m_buffer(nullptr), m_capacity(1), m_head(0), m_size(0) {
+            while (m_capacity < capacity)
+                m_capacity <<= 1;
+            m_buffer = static_cast<T*>(::operator new(m_capacity * sizeof(T)));
+        }
+
+        /*!
+         * @brief 禁止拷贝构造
+         */
+        RingBuffer(const RingBuffer&) = delete;
+
+        /*!
+         * @brief 禁止赋值
+         * @return RingBuffer&
+         */
+        RingBuffer& operator=(const RingBuffer&) = delete;
+
+        /*!
+         * @brief 析构函数
+         */
+        ~RingBuffer() {
+            clear();
+            ::operator delete(m_buffer);
+        }
+
+        /*!
+         * @brief 拷贝入队
+         * @param [in] element 入队对象
+         */
+        void push(const T& element) {
+            emplace(element);
+        }
+
+        /*!
+         * @brief 移动入队
+         * @param [in] element 入队对象
+         */
+        void push(T&& element) {
+            emplace(std::move(element));
+        }
+
+        /*!
+         * @brief 在队尾原地构造对象
+         * @param [in] args 构造参数
+         */
+        template <typename... Args>
+        void emplace(Args&&... args) {
+            if (m_size == m_capacity)
+                grow();
+            new (m_buffer + ((m_head + m_size) & (m_capacity - 1))) T(std::forward<Args>(args)...);
+            ++m_size;
+        }
+
+        /*!
+         * @brief 获取队头对象
+         * @return 队头对象引用
+         */
+        T& front() {
+            return m_buffer[m_head];
+        }
+
+        /*!
+         * @brief 获取队尾对象
+         * @return 队尾对象引用
+         */
+        T& back() {
+            return m_buffer[(m_head + m_size - 1) & (m_capacity - 1)];
+        }
+
+        /*!
+         * @brief 弹出队头对象
+         */
+        void pop() {
+            m_buffer[m_head].~T();
+            m_head = (m_head + 1) & (m_capacity - 1);
+            --m_size;
+        }
+
+        /*!
+         * @brief 判断队列是否为空
+         * @return 是否为空
+         */
+        bool empty() const {
+            return 0 == m_size;
+        }
+
+        /*!
+         * @brief 获取队列长度
+         * @return 队列长度
+         */
+        size_type size() const {
+            return m_size;
+        }
+
+        /*!
+         * @brief 获取当前容量
+         * @return 容量
+         */
+        size_type capacity() const {
+            return m_capacity;
+        }
+
+        /*!
+         * @brief 清空队列，保留存储区
+         */
+        void clear() {
+            while (m_size > 0)
+                pop();
+            m_head = 0;
+        }
+
+    private:
+
+        /*!
+         * @brief 容量翻倍，将原有元素按顺序移动到新存储区头部
+         */
+        void grow() {
+            size_type new_capacity = m_capacity << 1;
+            T* new_buffer = static_cast<T*>(::operator new(new_capacity * sizeof(T)));
+            for (size_type i = 0; i < m_size; i++) {
+                T* element = m_buffer + ((m_head + i) & (m_capacity - 1));
+                new (new_buffer + i) T(std::move(*element));
+                element -> ~T();
+            }
+            ::operator delete(m_buffer);
+            m_buffer = new_buffer;
+            m_capacity = new_capacity;
+            m_head = 0;
+        }
+
+        /// 存储区
+        T* m_buffer;
+
+        /// 容量，总为2的幂
+        size_type m_capacity;
+
+        /// 队头下标
+        size_type m_head;
+
+        /// 元素个数
+        size_type m_size;
+    };
+} // namespace xjj
+
+#endif
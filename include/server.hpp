@@ -14,10 +14,15 @@
 #ifndef _XJJ_SERVER_HPP
 #define _XJJ_SERVER_HPP
 
+#include <atomic>
 #include <cstdarg>
 #include <functional>
+#include <utility>
+#include <vector>
 #include <sys/epoll.h>
+#include "arena.hpp"
 #include "mutex.hpp"
+#include "strand.hpp"
 #include "thread_pool.hpp"
 
 /// 缓冲区大小
@@ -40,58 +45,105 @@ namespace xjj {
         class Request {
         private:
 
-            /// 请求体
-            std::string m_body;
+            /// 请求体，引用连接上下文中的缓冲区，请求对象不复制请求体
+            const std::string& m_body;
+
+            /// 本次请求的内存池指针
+            Arena* m_arena;
 
         public:
 
             /*!
              * @brief 构造函数
-             * @param [in] body 初始化请求体参数
+             * @param [in] body 初始化请求体参数，须在请求对象销毁前有效
+             * @param [in] arena 本次请求的内存池指针
              */
-            explicit Request(const std::string& body);
+            Request(const std::string& body, Arena* arena);
 
             /*!
              * @brief 获取请求体
              * @return 请求体
              */
             const std::string& getBody() const;
+
+            /*!
+             * @brief 获取本次请求的内存池：业务逻辑函数返回后一次性归还，
+             * 其中的内存不可在post的任务或其它线程中使用
+             * @return 内存池引用
+             */
+            Arena& getArena() const;
         };
 
         /*!
          * @brief 响应类 \class
          */
         class Response {
-        private:
+        public:
 
-            /// 完整响应报文
-            std::string m_packet;
+            /// 客户端不读取导致发送缓冲区持续已满时的等待时长上限（毫秒），超时后关闭连接
+            static const int SendTimeoutMs;
 
-            /// 响应发送偏移量
-            int m_send_offset;
+        private:
 
             /// 响应的套接字文件描述符
             int m_sock_fd;
 
+            /// 连接所属的Strand指针
+            Strand* m_strand;
+
             /*!
-             * @brief 将报文体的长度转换成字符表示，用于做为响应报文头
+             * @brief 发送一个报文（4字节小端序长度头加报文体）：套接字保持非阻塞，
+             * 发送缓冲区已满时以poll等待可写，客户端读取多快就发送多快
+             * @param [in] body 报文体
              * @param [in] length 报文体长度
-             * @return 转换结果
+             * @return 是否发送成功，失败时连接已关闭读写，由之后的读事件回收
              */
-            inline std::string lenToString(int length);
+            bool sendFrame(const char* body, size_t length);
+
         public:
 
             /*!
              * @brief 构造函数
              * @param [in] sock_fd 初始化响应的套接字文件描述符
+             * @param [in] strand 连接所属的Strand指针，为空时post直接执行任务
              */
-            explicit Response(int sock_fd);
+            explicit Response(int sock_fd, Strand* strand = nullptr);
 
             /*!
              * @brief 发送响应报文
              * @param [in] body 响应报文体
              */
             void sendResponse(const std::string& body);
+
+            /*!
+             * @brief 发送响应报文，报文体无需以'\0'结尾（可直接使用内存池中的缓冲区）
+             * @param [in] body 响应报文体
+             * @param [in] length 响应报文体长度
+             */
+            void sendResponse(const char* body, size_t length);
+
+            /*!
+             * @brief 发送分块响应的一个数据块，用于逐步生成的大响应（如流式导出查询结果）：
+             * 每块是一个独立的报文，所有数据块发送完毕后须调用endChunks。
+             * 发送缓冲区已满时阻塞至客户端读取，故生成方的内存占用不超过一个数据块
+             * @param [in] data 数据块
+             * @param [in] length 数据块长度，为0时不发送（长度为0的报文表示响应结束）
+             * @return 是否发送成功，失败时应停止生成后续数据块
+             */
+            bool sendChunk(const char* data, size_t length);
+
+            /*!
+             * @brief 结束分块响应：发送长度为0的报文
+             * @return 是否发送成功
+             */
+            bool endChunks();
+
+            /*!
+             * @brief 在连接所属的Strand上执行后续工作：与该连接之后的请求处理按投递顺序串行执行，
+             * 无需再对连接加锁。任务执行时本Response已销毁、连接可能已关闭，任务不应捕获本对象
+             * @param [in] task 任务对象
+             */
+            void post(Task task);
         };
 
         /*!
@@ -112,6 +164,12 @@ namespace xjj {
             /// 包长数据缓冲区
             std::string m_packet_len_buf;
 
+            /// 切分出的完整请求报文体，在同一连接的请求间复用容量
+            std::string m_request_body;
+
+            /// 线程池拒绝了该连接的读事件，由epoll线程在重新提交排空任务前设置
+            bool m_shed;
+
             /// 需要执行的用户业务逻辑
             // std::function<void(const Request&, Response&)>& m_business_logic;
 
@@ -141,13 +199,26 @@ namespace xjj {
              */
             PacketProcessor();
 
+            /*!
+             * @brief 标记连接被线程池拒绝，其排队中的读事件改为关闭连接
+             */
+            void shed();
+
+            /*!
+             * @brief 判断连接是否被线程池拒绝
+             * @return 是否被拒绝
+             */
+            bool isShed() const;
+
             /*!
              * @brief 读取并处理缓冲区数据
              * @param [in] sock_fd 欲读取的socket文件描述符
              * @param [in] business_logic 需要对请求执行的业务逻辑
-             * @return 操作完成状态码，包括 ResetOneShotStatusCode 和 CloseSockFdStatusCode
+             * @param [in] strand 连接所属的Strand指针
+             * @return 操作完成状态码，包括 ReadLaterStatusCode 和 CloseSockFdStatusCode
              */
-            int readBuffer(int sock_fd, const std::function<void(const Request&, Response&)>& business_logic);
+            int readBuffer(int sock_fd, const std::function<void(const Request&, Response&)>& business_logic,
+                           Strand* strand);
         };
 
         /*!
@@ -171,6 +242,14 @@ namespace xjj {
          */
         void run();
 
+        /*!
+         * @brief 添加事件源，须在run()之前调用；文件描述符以水平触发方式注册到服务器的epoll中，
+         * 可读时在epoll线程中调用回调（如异步查询执行器的processEvents），回调应简短
+         * @param [in] fd 事件源文件描述符
+         * @param [in] callback 可读时的回调
+         */
+        void addEventSource(int fd, std::function<void()> callback);
+
         /*!
          * @brief 将文件描述符设置为非阻塞读写模式
          * @param [in] fd 目标文件描述符
@@ -190,15 +269,15 @@ namespace xjj {
         /*!
          * @brief 讲文件描述符fd添加到epoll监听列表中
          * @param [in] fd 目标文件描述符
-         * @param [in] enable_one_shot 使用EPOLLONESHOT模式（避免线程竞争读fd）
          */
-        void addFd(int fd, bool enable_one_shot);
+        void addFd(int fd);
 
         /*!
-         * @brief 对socket文件描述符的EPOLLONESHOT选项进行重置，使后续读事件到来时其他线程可以进行读操作
-         * @param [in] fd 目标socket文件描述符
+         * @brief 若文件描述符是用户添加的事件源，调用其回调
+         * @param [in] fd 就绪的文件描述符
+         * @return 是否为事件源
          */
-        void resetOneShot(int fd);
+        bool dispatchEventSource(int fd);
 
         /*!
          * @brief 关闭socket连接
@@ -207,11 +286,23 @@ namespace xjj {
         void closeSocketConnection(int sock_fd);
 
         /*!
-         * @brief epoll事件触发函数
+         * @brief epoll事件触发函数，本轮所有可读事件的任务收集后一次性批量交给线程池
          * @param [in] number 就绪文件描述符数目
          */
         void edgeTriggerEventFunc(int number);
 
+        /*!
+         * @brief 标记本轮读事件落在被拒绝的Strand上的连接
+         * @param [in] first 第一个被拒绝的排空任务在m_ready_tasks中的下标
+         */
+        void shedRejectedConnections(size_t first);
+
+        /*!
+         * @brief 处理连接可读事件，在连接所属的Strand中执行，同一连接的读写不会并发
+         * @param [in] sock_fd 可读的socket文件描述符
+         */
+        void processReadEvent(int sock_fd);
+
         /*!
          * @brief 初始化服务器：包括配置文件加载、服务端监听套接字准备、启动线程池
          */
@@ -222,12 +313,6 @@ namespace xjj {
          */
         void getConfiguration();
 
-        /*!
-         * @brief 任务Id生成，用于标识即将加入线程池任务队列的任务
-         * @return 任务Id
-         */
-        inline int32_t generateTaskId();
-
         /*!
          * @brief 打印调试信息（使用宏 _XJJ_DEBUG 开启调试模式），采用 printf 实现
          * @param [in] format 格式字符指针常量
@@ -247,8 +332,14 @@ namespace xjj {
         /// 套接字文件描述符关闭状态码
         static const int CloseSockFdStatusCode;
 
-        /// 重置套接字文件描述符OneShot状态码
-        static const int ResetOneShotStatusCode;
+        /// 暂无数据可读状态码
+        static const int ReadLaterStatusCode;
+
+        /// 连接上下文表大小上限，实际大小取进程文件描述符数目上限与该值的较小者
+        static const size_t MaxConnectionNum;
+
+        /// 有被拒绝的排空任务时epoll_wait的超时（毫秒），到期后重新提交
+        static const int DeferredRetryMs;
 
         /// epoll文件描述符
         int m_epoll_fd;
@@ -256,12 +347,30 @@ namespace xjj {
         /// epoll事件数组
         epoll_event m_events[MAX_EVENT_COUNT];
 
+        /// 本轮epoll_wait收集到的Strand排空任务，批量交给线程池
+        std::vector<Task> m_ready_tasks;
+
+        /// m_ready_tasks中各排空任务所属的Strand，之前被拒绝的排空任务为空
+        std::vector<Strand*> m_ready_strands;
+
+        /// 本轮的读事件：连接的socket文件描述符与其所属的Strand
+        std::vector<std::pair<int, Strand*>> m_read_events;
+
+        /// 被线程池拒绝的排空任务，留待下一轮重新提交
+        std::vector<Task> m_deferred_tasks;
+
         /// 用户业务逻辑函数对象
         std::function<void(const Request&, Response&)> m_business_logic;
 
         /// 线程池对象指针
         std::unique_ptr<ThreadPool> m_thread_pool;
 
+        /// 连接的串行执行器组，以socket文件描述符为键
+        std::unique_ptr<StrandGroup> m_connection_strands;
+
+        /// 连接上下文表，以socket文件描述符为下标；上下文取自对象池，接受连接时放入，关闭连接时归还
+        std::vector<std::atomic<PacketProcessor*>> m_connections;
+
         /// 服务器IP
         std::string m_ip;
 
@@ -274,9 +383,18 @@ namespace xjj {
         /// 线程池是否允许过载
         bool m_thread_pool_overload;
 
+        /// 线程池等待队列容量，0表示不限制
+        size_t m_thread_pool_capacity;
+
+        /// 线程池等待队列已满时的处理策略
+        ThreadPool::RejectionPolicy m_thread_pool_rejection_policy;
+
         /// 服务器监听套接字文件描述符
         int m_listen_fd;
 
+        /// 用户添加的事件源及其可读回调
+        std::vector<std::pair<int, std::function<void()>>> m_event_sources;
+
         /// 服务器运行状态标识
         bool m_is_running;
     };
@@ -0,0 +1,182 @@
+//
+// created by agent on 2026-10-18
+//
+
+#ifndef _XJJ_STRAND_HPP
+#define _XJJ_STRAND_HPP
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "thread_pool.hpp"
+
+namespace xjj {
+    /*!
+     * @brief 串行执行器类 \class
+     * 同一Strand的任务按投递顺序在线程池中串行执行；线程池不可使用DropOldest策略
+     */
+    class Strand {
+    public:
+
+        /// 排空任务一次连续执行的任务数上限
+        static const size_t BatchSize = 64;
+
+        /*!
+         * @brief 构造函数
+         * @param [in] pool_ptr 执行任务的线程池指针
+         * @param [in] priority 排空任务的优先级，默认为Normal
+         */
+        explicit Strand(ThreadPool* pool_ptr, ThreadPool::Priority priority = ThreadPool::Priority::Normal);
+
+        /*!
+         * @brief 投递任务；线程池无空位接收排空任务时在调用线程上执行
+         * @param [in] task 任务对象
+         */
+        void post(Task task);
+
+        /*!
+         * @brief 只将任务放入队列，不提交排空任务，便于调用者批量提交
+         * @param [in] task 任务对象
+         * @return Strand原本空闲时返回排空任务，调用者必须将其交给线程池或自行执行；否则返回空任务
+         */
+        Task enqueue(Task task);
+
+        /*!
+         * @brief 判断调用线程当前是否正在执行本Strand的任务
+         * @return 是否正在执行
+         */
+        bool runningInThisThread() const;
+
+    private:
+
+        /*!
+         * @brief 任务链表节点 \struct
+         */
+        struct Node {
+            /// 后继节点
+            std::atomic<Node*> m_next;
+
+            /// 任务
+            Task m_task;
+        };
+
+        /*!
+         * @brief 执行器共享状态 \struct
+         * 链表头部为最近投递的节点（生产者端），尾部为已执行的哨兵节点（消费者端）
+         */
+        struct State {
+            /*!
+             * @brief 构造函数
+             * @param [in] pool_ptr 执行任务的线程池指针
+             * @param [in] priority 排空任务的优先级
+             */
+            State(ThreadPool* pool_ptr, ThreadPool::Priority priority);
+
+            /*!
+             * @brief 析构函数：释放链表节点
+             */
+            ~State();
+
+            /// 执行任务的线程池指针
+            ThreadPool* m_pool_ptr;
+
+            /// 排空任务的优先级
+            ThreadPool::Priority m_priority;
+
+            /// 已投递而未执行完的任务数
+            std::atomic<size_t> m_count;
+
+            /// 链表头部，生产者交换写入
+            std::atomic<Node*> m_head;
+
+            /// 链表尾部哨兵，只由排空任务访问
+            Node* m_tail;
+        };
+
+        /*!
+         * @brief 排空任务 \struct
+         */
+        struct DrainTask {
+            /// 执行器共享状态
+            std::shared_ptr<State> m_state;
+
+            void operator() () {
+                drain(m_state);
+            }
+        };
+
+        /*!
+         * @brief 将任务放入链表
+         * @param [in] state 执行器共享状态
+         * @param [in] task 任务对象
+         * @return 执行器原本是否空闲
+         */
+        static bool push(State& state, Task task);
+
+        /*!
+         * @brief 依次执行链表中的任务，直到执行器空闲或剩余任务交给新的排空任务；
+         * 任务抛出的异常在返回前重新抛出，交接失败而继续执行时只保留第一个异常
+         * @param [in] state 执行器共享状态
+         */
+        static void drain(const std::shared_ptr<State>& state);
+
+        /*!
+         * @brief 向线程池提交排空任务，不阻塞、不在调用线程执行
+         * @param [in] state 执行器共享状态
+         * @return 是否提交成功（线程池未运行或无空位时返回false）
+         */
+        static bool submitDrain(const std::shared_ptr<State>& state);
+
+        /// 执行器共享状态
+        std::shared_ptr<State> m_state;
+    };
+
+    /*!
+     * @brief 按键分组的串行执行器类 \class
+     * 键按取模映射到固定数目的Strand之一，不同键可能被串行执行
+     */
+    class StrandGroup {
+    public:
+
+        /// 默认Strand数目
+        static const size_t DefaultStrandNum = 256;
+
+        /*!
+         * @brief 构造函数
+         * @param [in] pool_ptr 执行任务的线程池指针
+         * @param [in] strand_num Strand数目，默认为DefaultStrandNum
+         * @param [in] priority 排空任务的优先级，默认为Normal
+         */
+        explicit StrandGroup(ThreadPool* pool_ptr, size_t strand_num = DefaultStrandNum,
+                             ThreadPool::Priority priority = ThreadPool::Priority::Normal);
+
+        /*!
+         * @brief 获取键对应的Strand
+         * @param [in] key 键，如连接的socket文件描述符、用户id或分片号
+         * @return Strand引用
+         */
+        Strand& get(size_t key);
+
+        /*!
+         * @brief 向键对应的Strand投递任务
+         * @param [in] key 键
+         * @param [in] task 任务对象
+         */
+        void post(size_t key, Task task);
+
+        /*!
+         * @brief 只将任务放入键对应的Strand，见Strand::enqueue
+         * @param [in] key 键
+         * @param [in] task 任务对象
+         * @return 排空任务或空任务
+         */
+        Task enqueue(size_t key, Task task);
+
+    private:
+
+        /// 所有Strand
+        std::vector<Strand> m_strands;
+    };
+} // namespace xjj
+
+#endif
@@ -0,0 +1,225 @@
+//
+// created by agent on 2026-10-18
+//
+
+#ifndef _XJJ_TASK_HPP
+#define _XJJ_TASK_HPP
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace xjj {
+    /*!
+     * @brief 线程池任务类 \class
+     * 只可移动的std::function<void()>替代，小对象存放在内置存储区中
+     */
+    class Task {
+    public:
+
+        /// 内置存储区大小，足以容纳捕获若干指针与整数的lambda、shared_ptr、std::function等
+        static const size_t InlineSize = 64;
+
+        /*!
+         * @brief 构造函数，构造空任务
+         */
+        Task() noexcept : m_ops(nullptr) {}
+
+        /*!
+         * @brief 构造函数，包装可执行对象
+         * @tparam F 可执行对象类型
+         * @param [in] function 可执行对象
+         */
+        template <typename F,
+                  typename = typename std::enable_if<
+                          !std::is_same<typename std::decay<F>::type, Task>::value>::type>
+        Task(F&& function) : m_ops(nullptr) {
+            typedef typename std::decay<F>::type function_type;
+            construct<function_type>(std::forward<F>(function), StoredInline<function_type>());
+        }
+
+        /*!
+         * @brief 移动构造函数
+         * @param [in,out] other 被移动的任务
+         */
+        Task(Task&& other) noexcept : m_ops(other.m_ops) {
+            if (m_ops) {
+                m_ops -> move(&m_storage, &other.m_storage);
+                other.m_ops = nullptr;
+            }
+        }
+
+        /*!
+         * @brief 移动赋值
+         * @param [in,out] other 被移动的任务
+         * @return Task&
+         */
+        Task& operator=(Task&& other) noexcept {
+            if (this != &other) {
+                reset();
+                if (other.m_ops) {
+                    m_ops = other.m_ops;
+                    m_ops -> move(&m_storage, &other.m_storage);
+                    other.m_ops = nullptr;
+                }
+            }
+            return *this;
+        }
+
+        /*!
+         * @brief 禁止拷贝构造
+         */
+        Task(const Task&) = delete;
+
+        /*!
+         * @brief 禁止赋值
+         * @return Task&
+         */
+        Task& operator=(const Task&) = delete;
+
+        /*!
+         * @brief 析构函数
+         */
+        ~Task() {
+            reset();
+        }
+
+        /*!
+         * @brief 判断任务是否非空
+         * @return 是否非空
+         */
+        explicit operator bool() const noexcept {
+            return m_ops != nullptr;
+        }
+
+        /*!
+         * @brief 执行任务
+         */
+        void operator() () {
+            m_ops -> invoke(&m_storage);
+        }
+
+        /*!
+         * @brief 销毁包装的可执行对象，任务置空
+         */
+        void reset() noexcept {
+            if (m_ops) {
+                m_ops -> destroy(&m_storage);
+                m_ops = nullptr;
+            }
+        }
+
+    private:
+
+        /// 内置存储区类型
+        typedef typename std::aligned_storage<InlineSize>::type storage_type;
+
+        /*!
+         * @brief 可执行对象的类型擦除操作表 \struct
+         */
+        struct Operations {
+            /// 执行
+            void (*invoke)(void* storage);
+
+            /// 从src移动构造到dst，并销毁src
+            void (*move)(void* dst, void* src);
+
+            /// 销毁
+            void (*destroy)(void* storage);
+        };
+
+        /*!
+         * @brief 判断可执行对象能否放入内置存储区 \struct
+         * @tparam F 可执行对象类型
+         */
+        template <typename F>
+        struct StoredInline : std::integral_constant<bool,
+                sizeof(F) <= sizeof(storage_type) &&
+                std::alignment_of<storage_type>::value % std::alignment_of<F>::value == 0 &&
+                std::is_nothrow_move_constructible<F>::value> {};
+
+        /*!
+         * @brief 内置存储的操作实现 \struct
+         * @tparam F 可执行对象类型
+         */
+        template <typename F>
+        struct InlineOperations {
+            static void invoke(void* storage) {
+                (*static_cast<F*>(storage))();
+            }
+
+            static void move(void* dst, void* src) {
+                new (dst) F(std::move(*static_cast<F*>(src)));
+                static_cast<F*>(src) -> ~F();
+            }
+
+            static void destroy(void* storage) {
+                static_cast<F*>(storage) -> ~F();
+            }
+
+            static const Operations table;
+        };
+
+        /*!
+         * @brief 堆存储的操作实现，存储区中只存放对象指针 \struct
+         * @tparam F 可执行对象类型
+         */
+        template <typename F>
+        struct HeapOperations {
+            static void invoke(void* storage) {
+                (**static_cast<F**>(storage))();
+            }
+
+            static void move(void* dst, void* src) {
+                *static_cast<F**>(dst) = *static_cast<F**>(src);
+            }
+
+            static void destroy(void* storage) {
+                delete *static_cast<F**>(storage);
+            }
+
+            static const Operations table;
+        };
+
+        /*!
+         * @brief 在内置存储区中构造可执行对象
+         */
+        template <typename F, typename Arg>
+        void construct(Arg&& function, std::true_type) {
+            new (&m_storage) F(std::forward<Arg>(function));
+            m_ops = &InlineOperations<F>::table;
+        }
+
+        /*!
+         * @brief 在堆上构造可执行对象
+         */
+        template <typename F, typename Arg>
+        void construct(Arg&& function, std::false_type) {
+            *reinterpret_cast<F**>(&m_storage) = new F(std::forward<Arg>(function));
+            m_ops = &HeapOperations<F>::table;
+        }
+
+        /// 内置存储区
+        storage_type m_storage;
+
+        /// 操作表指针，为空表示空任务
+        const Operations* m_ops;
+    };
+
+    template <typename F>
+    const Task::Operations Task::InlineOperations<F>::table = {
+            &Task::InlineOperations<F>::invoke,
+            &Task::InlineOperations<F>::move,
+            &Task::InlineOperations<F>::destroy
+    };
+
+    template <typename F>
+    const Task::Operations Task::HeapOperations<F>::table = {
+            &Task::HeapOperations<F>::invoke,
+            &Task::HeapOperations<F>::move,
+            &Task::HeapOperations<F>::destroy
+    };
+} // namespace xjj
+
+#endif
@@ -0,0 +1,641 @@
+//
+// created by agent on 2026-10-18
+//
+
+#ifndef _XJJ_TASK_FUTURE_HPP
+#define _XJJ_TASK_FUTURE_HPP
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "condition_variable.hpp"
+
+namespace xjj {
+
+    /*!
+     * @brief 任务执行结果模板类 \class
+     * 保存任务的返回值或任务抛出的异常，二者只会存在其一
+     * @tparam R 任务返回值类型
+     */
+    template <typename R>
+    class TaskResult {
+    public:
+
+        /*!
+         * @brief 构造函数，初始状态既无返回值也无异常
+         */
+        TaskResult() : m_has_value(false) {}
+
+        /*!
+         * @brief 禁止拷贝构造
+         */
+        TaskResult(const TaskResult&) = delete;
+
+        /*!
+         * @brief 禁止赋值
+         * @return TaskResult&
+         */
+        TaskResult& operator=(const TaskResult&) = delete;
+
+        /*!
+         * @brief 析构函数，销毁保存的返回值
+         */
+        ~TaskResult() {
+            if (m_has_value)
+                valuePtr() -> ~R();
+        }
+
+        /*!
+         * @brief 执行可执行对象，保存其返回值或抛出的异常
+         * @tparam F 可执行对象类型
+         * @param [in] function 可执行对象
+         */
+        template <typename F>
+        void setFrom(F& function) {
+            try {
+                new (&m_storage) R(function());
+                m_has_value = true;
+            } catch (...) {
+                m_exception = std::current_exception();
+            }
+        }
+
+        /*!
+         * @brief 直接设置异常（例如任务被线程池拒绝时）
+         * @param [in] exception 异常指针
+         */
+        void setException(std::exception_ptr exception) {
+            m_exception = std::move(exception);
+        }
+
+        /*!
+         * @brief 判断任务是否抛出了异常
+         * @return 是否存在异常
+         */
+        bool hasException() const {
+            return static_cast<bool>(m_exception);
+        }
+
+        /*!
+         * @brief 获取返回值引用，任务抛出异常时重新抛出该异常
+         * @return 返回值引用
+         */
+        R& get() {
+            if (m_exception)
+                std::rethrow_exception(m_exception);
+            return *valuePtr();
+        }
+
+        /*!
+         * @brief 移出返回值，任务抛出异常时重新抛出该异常
+         * @return 返回值
+         */
+        R take() {
+            return std::move(get());
+        }
+
+    private:
+
+        /*!
+         * @brief 获取返回值存储区指针
+         * @return 返回值指针
+         */
+        R* valuePtr() {
+            return reinterpret_cast<R*>(&m_storage);
+        }
+
+        /// 返回值存储区，避免要求R可默认构造
+        typename std::aligned_storage<sizeof(R), std::alignment_of<R>::value>::type m_storage;
+
+        /// 存储区中是否已构造返回值
+        bool m_has_value;
+
+        /// 任务抛出的异常
+        std::exception_ptr m_exception;
+    };
+
+    /*!
+     * @brief 返回引用的任务的执行结果模板类 \class
+     * @tparam R 被引用的类型
+     */
+    template <typename R>
+    class TaskResult<R&> {
+    public:
+
+        /*!
+         * @brief 构造函数，初始状态既无返回值也无异常
+         */
+        TaskResult() : m_value(nullptr) {}
+
+        /*!
+         * @brief 禁止拷贝构造
+         */
+        TaskResult(const TaskResult&) = delete;
+
+        /*!
+         * @brief 禁止赋值
+         * @return TaskResult&
+         */
+        TaskResult& operator=(const TaskResult&) = delete;
+
+        /*!
+         * @brief 执行可执行对象，保存其返回的引用或抛出的异常
+         * @tparam F 可执行对象类型
+         * @param [in] function 可执行对象
+         */
+        template <typename F>
+        void setFrom(F& function) {
+            try {
+                m_value = &function();
+            } catch (...) {
+                m_exception = std::current_exception();
+            }
+        }
+
+        /*!
+         * @brief 直接设置异常
+         * @param [in] exception 异常指针
+         */
+        void setException(std::exception_ptr exception) {
+            m_exception = std::move(exception);
+        }
+
+        /*!
+         * @brief 判断任务是否抛出了异常
+         * @return 是否存在异常
+         */
+        bool hasException() const {
+            return static_cast<bool>(m_exception);
+        }
+
+        /*!
+         * @brief 获取返回的引用，任务抛出异常时重新抛出该异常
+         * @return 返回的引用
+         */
+        R& get() {
+            if (m_exception)
+                std::rethrow_exception(m_exception);
+            return *m_value;
+        }
+
+        /*!
+         * @brief 同get，与TaskResult<R>::take保持一致的接口
+         * @return 返回的引用
+         */
+        R& take() {
+            return get();
+        }
+
+    private:
+
+        /// 返回的引用所指向的对象
+        R* m_value;
+
+        /// 任务抛出的异常
+        std::exception_ptr m_exception;
+    };
+
+    /*!
+     * @brief 无返回值任务的执行结果类 \class
+     */
+    template <>
+    class TaskResult<void> {
+    public:
+
+        /*!
+         * @brief 构造函数
+         */
+        TaskResult() = default;
+
+        /*!
+         * @brief 禁止拷贝构造
+         */
+        TaskResult(const TaskResult&) = delete;
+
+        /*!
+         * @brief 禁止赋值
+         * @return TaskResult&
+         */
+        TaskResult& operator=(const TaskResult&) = delete;
+
+        /*!
+         * @brief 执行可执行对象，保存其抛出的异常
+         * @tparam F 可执行对象类型
+         * @param [in] function 可执行对象
+         */
+        template <typename F>
+        void setFrom(F& function) {
+            try {
+                function();
+            } catch (...) {
+                m_exception = std::current_exception();
+            }
+        }
+
+        /*!
+         * @brief 直接设置异常
+         * @param [in] exception 异常指针
+         */
+        void setException(std::exception_ptr exception) {
+            m_exception = std::move(exception);
+        }
+
+        /*!
+         * @brief 判断任务是否抛出了异常
+         * @return 是否存在异常
+         */
+        bool hasException() const {
+            return static_cast<bool>(m_exception);
+        }
+
+        /*!
+         * @brief 任务抛出异常时重新抛出该异常
+         */
+        void get() {
+            if (m_exception)
+                std::rethrow_exception(m_exception);
+        }
+
+        /*!
+         * @brief 同get，与TaskResult<R>::take保持一致的接口
+         */
+        void take() {
+            get();
+        }
+
+    private:
+
+        /// 任务抛出的异常
+        std::exception_ptr m_exception;
+    };
+
+    /*!
+     * @brief 任务共享状态模板类 \class
+     * 完成回调先于结果就绪执行，等待结果的线程被唤醒时回调已经返回
+     * @tparam R 任务返回值类型
+     */
+    template <typename R>
+    class TaskSharedState {
+    public:
+
+        /// 完成回调函数类型
+        typedef std::function<void(TaskResult<R>&)> callback_type;
+
+        /*!
+         * @brief 构造函数
+         */
+        TaskSharedState() : m_completing(false), m_ready(false) {}
+
+        /*!
+         * @brief 禁止拷贝构造
+         */
+        TaskSharedState(const TaskSharedState&) = delete;
+
+        /*!
+         * @brief 禁止赋值
+         * @return TaskSharedState&
+         */
+        TaskSharedState& operator=(const TaskSharedState&) = delete;
+
+        /*!
+         * @brief 虚析构函数
+         */
+        virtual ~TaskSharedState() = default;
+
+        /*!
+         * @brief 以异常结束任务（任务未被执行）
+         * @param [in] exception 异常指针
+         */
+        void setException(std::exception_ptr exception) {
+            m_result.setException(std::move(exception));
+            complete();
+        }
+
+        /*!
+         * @brief 判断结果是否就绪
+         * @return 是否就绪
+         */
+        bool isReady() const {
+            return m_ready.load(std::memory_order_acquire);
+        }
+
+        /*!
+         * @brief 等待结果就绪
+         */
+        void wait() {
+            if (isReady())  // 快速路径：结果已就绪，无需加锁
+                return;
+            AutoLockMutex autoLockMutex(&m_mutex);
+            while (!m_ready.load(std::memory_order_relaxed))
+                m_ready_cond_var.wait(&m_mutex);
+        }
+
+        /*!
+         * @brief 获取结果对象，调用前须确保结果已就绪
+         * @return 结果对象引用
+         */
+        TaskResult<R>& getResult() {
+            return m_result;
+        }
+
+        /*!
+         * @brief 设置完成回调，任务已结束时等待结果就绪后在当前线程立即调用
+         * @param [in] callback 完成回调
+         */
+        void setCallback(callback_type callback) {
+            {
+                AutoLockMutex autoLockMutex(&m_mutex);
+                if (!m_completing) {
+                    m_callback = std::move(callback);
+                    return;
+                }
+                while (!m_ready.load(std::memory_order_relaxed))  // 先设置的回调正在执行
+                    m_ready_cond_var.wait(&m_mutex);
+            }
+            callback(m_result);
+        }
+
+    protected:
+
+        /*!
+         * @brief 执行可执行对象并写入结果
+         * @tparam F 可执行对象类型
+         * @param [in] function 可执行对象
+         */
+        template <typename F>
+        void runFunction(F& function) {
+            m_result.setFrom(function);
+            complete();
+        }
+
+    private:
+
+        /*!
+         * @brief 调用完成回调，之后标记结果就绪并唤醒等待线程；
+         * 回调抛出的异常被忽略，以免结果永不就绪或异常逃逸到工作线程、析构函数中
+         */
+        void complete() {
+            callback_type callback;
+            {
+                AutoLockMutex autoLockMutex(&m_mutex);
+                m_completing = true;
+                callback.swap(m_callback);
+            }
+            if (callback) {
+                try {
+                    callback(m_result);
+                } catch (...) {}
+            }
+            {
+                AutoLockMutex autoLockMutex(&m_mutex);
+                m_ready.store(true, std::memory_order_release);
+            }
+            m_ready_cond_var.broadcast();  // 等待者可能是get/wait与迟到的setCallback
+        }
+
+        /// 任务执行结果
+        TaskResult<R> m_result;
+
+        /// 任务是否已结束（回调已取出），由m_mutex保护
+        bool m_completing;
+
+        /// 结果是否就绪，完成回调返回后才置位
+        std::atomic<bool> m_ready;
+
+        /// 保护回调及等待的互斥量
+        Mutex m_mutex;
+
+        /// 结果就绪 条件变量
+        ConditionVariable m_ready_cond_var;
+
+        /// 完成回调
+        callback_type m_callback;
+    };
+
+    /*!
+     * @brief 携带可执行对象的任务共享状态类 \class
+     * 可执行对象与共享状态放在同一对象中，配合make_shared只需一次内存分配
+     * @tparam R 任务返回值类型
+     * @tparam F 可执行对象类型
+     */
+    template <typename R, typename F>
+    class TaskFunctionState : public TaskSharedState<R> {
+    public:
+
+        /*!
+         * @brief 构造函数
+         * @param [in] function 可执行对象
+         */
+        explicit TaskFunctionState(F&& function)
+                : m_function(std::move(function)) {}
+
+        /*!
+         * @brief 执行任务
+         */
+        void run() {
+            this -> runFunction(m_function);
+        }
+
+    private:
+
+        /// 可执行对象
+        F m_function;
+    };
+
+    /*!
+     * @brief 任务共享状态执行器 \class
+     * 作为线程池任务的可执行对象，仅持有共享状态指针；
+     * 若在执行前被销毁（被线程池拒绝、丢弃或清空），则以异常结束任务，避免future永久等待
+     * @tparam State 共享状态类型
+     */
+    template <typename State>
+    class TaskStateRunner {
+    public:
+
+        /*!
+         * @brief 构造函数
+         * @param [in] state 共享状态指针
+         */
+        explicit TaskStateRunner(std::shared_ptr<State> state)
+                : m_state(std::move(state)) {}
+
+        /*!
+         * @brief 移动构造函数
+         */
+        TaskStateRunner(TaskStateRunner&&) noexcept = default;
+
+        /*!
+         * @brief 禁止拷贝构造
+         */
+        TaskStateRunner(const TaskStateRunner&) = delete;
+
+        /*!
+         * @brief 禁止赋值
+         * @return TaskStateRunner&
+         */
+        TaskStateRunner& operator=(const TaskStateRunner&) = delete;
+
+        /*!
+         * @brief 析构函数，任务未执行时写入异常
+         */
+        ~TaskStateRunner() {
+            if (m_state)
+                m_state -> setException(std::make_exception_ptr(
+                        std::runtime_error("task was rejected or discarded by thread pool.")));
+        }
+
+        /*!
+         * @brief 执行任务
+         */
+        void operator() () {
+            std::shared_ptr<State> state(std::move(m_state));
+            state -> run();
+        }
+
+    private:
+
+        /// 共享状态指针，执行后置空
+        std::shared_ptr<State> m_state;
+    };
+
+    /*!
+     * @brief 带完成回调的任务 \struct
+     * 结果保存在任务执行栈上，执行完立即交给回调，不需要任何共享状态
+     * @tparam R 任务返回值类型
+     * @tparam F 可执行对象类型
+     * @tparam Callback 完成回调类型，调用形式为 callback(TaskResult<R>&)
+     */
+    template <typename R, typename F, typename Callback>
+    struct CallbackTask {
+
+        /// 可执行对象
+        F m_function;
+
+        /// 完成回调
+        Callback m_callback;
+
+        /*!
+         * @brief 执行任务并调用完成回调
+         */
+        void operator() () {
+            TaskResult<R> result;
+            result.setFrom(m_function);
+            m_callback(result);
+        }
+    };
+
+    /*!
+     * @brief 任务future模板类 \class
+     * 由ThreadPool::submit返回，用于获取任务的返回值或异常
+     * @tparam R 任务返回值类型
+     */
+    template <typename R>
+    class TaskFuture {
+    public:
+
+        /*!
+         * @brief 构造函数
+         * @param [in] state 共享状态指针，默认为空（无效future）
+         */
+        explicit TaskFuture(std::shared_ptr<TaskSharedState<R>> state = nullptr)
+                : m_state(std::move(state)) {}
+
+        /*!
+         * @brief 移动构造函数
+         */
+        TaskFuture(TaskFuture&&) = default;
+
+        /*!
+         * @brief 移动赋值
+         * @return TaskFuture&
+         */
+        TaskFuture& operator=(TaskFuture&&) = default;
+
+        /*!
+         * @brief 禁止拷贝构造
+         */
+        TaskFuture(const TaskFuture&) = delete;
+
+        /*!
+         * @brief 禁止赋值
+         * @return TaskFuture&
+         */
+        TaskFuture& operator=(const TaskFuture&) = delete;
+
+        /*!
+         * @brief 判断future是否关联了任务
+         * @return 是否有效
+         */
+        bool valid() const {
+            return static_cast<bool>(m_state);
+        }
+
+        /*!
+         * @brief 判断任务是否已经完成
+         * @return 是否完成
+         */
+        bool isReady() const {
+            return checkedState() -> isReady();
+        }
+
+        /*!
+         * @brief 等待任务完成
+         */
+        void wait() const {
+            checkedState() -> wait();
+        }
+
+        /*!
+         * @brief 等待任务完成并获取返回值，任务抛出异常时重新抛出该异常；只能调用一次，
+         * 设置了完成回调时在回调返回后才返回
+         * @return 任务返回值
+         */
+        R get() {
+            checkedState() -> wait();
+            std::shared_ptr<TaskSharedState<R>> state(std::move(m_state));
+            return state -> getResult().take();
+        }
+
+        /*!
+         * @brief 设置完成回调，任务已完成时在当前线程立即调用，否则在执行任务的工作线程中调用；
+         * 与get同时使用时回调不应移出结果，在工作线程中调用时回调抛出的异常被忽略
+         * @param [in] callback 完成回调，调用形式为 callback(TaskResult<R>&)
+         */
+        void then(typename TaskSharedState<R>::callback_type callback) {
+            checkedState() -> setCallback(std::move(callback));
+        }
+
+    private:
+
+        /*!
+         * @brief 获取共享状态指针，future无效（默认构造、已被移动或已get）时抛出异常
+         * @return 共享状态指针
+         */
+        TaskSharedState<R>* checkedState() const {
+            if (!m_state)
+                throw std::logic_error("future has no associated task.");
+            return m_state.get();
+        }
+
+        /// 共享状态指针
+        std::shared_ptr<TaskSharedState<R>> m_state;
+    };
+
+    /*!
+     * @brief 推导任务返回值类型：可执行对象以左值形式接收已绑定的参数 \struct
+     * 不可调用时不定义type，使依赖它的重载在替换阶段被排除
+     * @tparam F 可执行对象类型
+     * @tparam Args 参数类型
+     */
+    template <typename F, typename... Args>
+    struct TaskResultOf : std::result_of<
+            typename std::decay<F>::type(typename std::decay<Args>::type&...)> {};
+
+} // namespace xjj
+
+#endif
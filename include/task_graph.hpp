@@ -0,0 +1,167 @@
+//
+// created by agent on 2026-10-18
+//
+
+#ifndef _XJJ_TASK_GRAPH_HPP
+#define _XJJ_TASK_GRAPH_HPP
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "ring_buffer.hpp"
+#include "thread_pool.hpp"
+
+namespace xjj {
+    /*!
+     * @brief 任务依赖图类 \class
+     * 主要流程：
+     * 1. 使用addNode添加节点，使用addEdge声明节点间的先后依赖
+     * 2. 使用run提交没有前驱的节点
+     * 3. 使用wait等待所有节点完成，重新抛出第一个异常
+     */
+    class TaskGraph {
+    public:
+
+        /// 节点id类型
+        typedef size_t node_id;
+
+        /*!
+         * @brief 构造函数
+         * @param [in] pool_ptr 执行节点的线程池指针
+         * @param [in] priority 节点任务的优先级，默认为Normal
+         */
+        explicit TaskGraph(ThreadPool* pool_ptr,
+                           ThreadPool::Priority priority = ThreadPool::Priority::Normal);
+
+        /*!
+         * @brief 禁止拷贝构造
+         */
+        TaskGraph(const TaskGraph&) = delete;
+
+        /*!
+         * @brief 禁止赋值
+         * @return TaskGraph&
+         */
+        TaskGraph& operator=(const TaskGraph&) = delete;
+
+        /*!
+         * @brief 析构函数：若已run而未wait，先等待所有节点完成（忽略异常）
+         */
+        ~TaskGraph();
+
+        /*!
+         * @brief 添加节点，须在首次run之前调用
+         * @param [in] function 节点执行的可执行对象
+         * @return 节点id
+         */
+        node_id addNode(std::function<void()> function);
+
+        /*!
+         * @brief 声明before须在after之前完成，须在首次run之前调用
+         * @param [in] before 前驱节点id
+         * @param [in] after 后继节点id
+         */
+        void addEdge(node_id before, node_id after);
+
+        /*!
+         * @brief 开始执行，提交所有没有前驱的节点
+         * 图中存在环时抛出std::invalid_argument
+         */
+        void run();
+
+        /*!
+         * @brief 等待所有节点完成，期间帮助执行；有节点抛出异常时重新抛出第一个异常
+         */
+        void wait();
+
+        /*!
+         * @brief 获取节点数
+         * @return 节点数
+         */
+        size_t size() const;
+
+    private:
+
+        /*!
+         * @brief 节点 \struct
+         */
+        struct Node {
+            /// 节点执行的可执行对象
+            std::function<void()> m_function;
+
+            /// 后继节点id
+            std::vector<node_id> m_successors;
+
+            /// 前驱节点数
+            size_t m_predecessor_num;
+
+            /// 本次执行中尚未完成的前驱节点数
+            std::atomic<size_t> m_remaining;
+
+            /// 最近一次领取该节点的执行轮次，领取即由上一轮次CAS为本轮次
+            std::atomic<size_t> m_claimed_generation;
+        };
+
+        /*!
+         * @brief 执行共享状态 \struct
+         * 节点任务可能在wait返回后才被取出，故由shared_ptr持有
+         */
+        struct State {
+            /// 所有节点
+            std::vector<std::unique_ptr<Node>> m_nodes;
+
+            /// 执行节点的线程池指针
+            ThreadPool* m_pool_ptr;
+
+            /// 节点任务的优先级
+            ThreadPool::Priority m_priority;
+
+            /// 当前执行轮次，每次run加一；上一轮遗留在线程池中的节点任务据此失效
+            size_t m_generation;
+
+            /// 本次执行中已完成的节点数
+            std::atomic<size_t> m_finished_num;
+
+            /// 是否已有节点抛出异常
+            std::atomic<bool> m_failed;
+
+            /// 第一个异常
+            std::exception_ptr m_exception;
+
+            /// 保护就绪队列、异常与完成通知的互斥量
+            Mutex m_mutex;
+
+            /// 就绪节点队列，供等待线程领取
+            RingBuffer<node_id> m_ready;
+
+            /// 有新就绪节点或全部完成 条件变量
+            ConditionVariable m_cond_var;
+        };
+
+        /*!
+         * @brief 节点就绪：放入就绪队列并尝试提交到线程池
+         * @param [in] state 执行共享状态
+         * @param [in] id 节点id
+         * @param [in] generation 执行轮次
+         */
+        static void makeReady(const std::shared_ptr<State>& state, node_id id, size_t generation);
+
+        /*!
+         * @brief 领取并执行节点，节点已被其它线程领取时直接返回
+         * @param [in] state 执行共享状态
+         * @param [in] id 节点id
+         * @param [in] generation 执行轮次
+         */
+        static void runNode(const std::shared_ptr<State>& state, node_id id, size_t generation);
+
+        /// 执行共享状态
+        std::shared_ptr<State> m_state;
+
+        /// 是否已run而未wait
+        bool m_running;
+    };
+} // namespace xjj
+
+#endif
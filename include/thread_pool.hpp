@@ -5,9 +5,28 @@
 #ifndef _XJJ_THREAD_POOL_HPP
 #define _XJJ_THREAD_POOL_HPP
 
+/// 任务等待队列实现：为1时使用无锁队列LockFreeQueue，为0时使用BlockingQueue，可通过make LOCK_FREE_QUEUE=1设置
+#ifndef _XJJ_LOCK_FREE_TASK_QUEUE
+#define _XJJ_LOCK_FREE_TASK_QUEUE 0
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iterator>
+#include <limits>
+#include <string>
 #include <vector>
 #include <functional>
+#if _XJJ_LOCK_FREE_TASK_QUEUE
+#include "lock_free_queue.hpp"
+#else
 #include "blocking_queue.hpp"
+#endif
+#include "histogram.hpp"
+#include "task.hpp"
+#include "task_future.hpp"
+#include "timer_queue.hpp"
 
 namespace xjj {
     /*!
@@ -15,29 +34,77 @@ namespace xjj {
      * 主要流程：
      * 1. 构造线程池
      * 2. 使用start启动线程池
-     * 3. 往线程池中加入任务，多个线程争抢执行
-     * 4. 使用terminate终止线程池
+     * 3. 往线程池中加入任务（addTask或submit），多个线程争抢执行
+     * 4. 通过submit返回的TaskFuture或完成回调获取任务结果
+     * 5. 使用terminate终止线程池
+     * 延时与周期任务由内部的定时器线程在到期时提交，等待期间不占用工作线程
+     * parallelFor、parallelReduce与TaskGraph的等待线程会帮助执行等待队列中的任务，嵌套调用不会死锁
+     * 任务分为High、Normal、Background三个优先级，各有线程数配额
      */
     class ThreadPool {
-    private:
+    public:
         /*!
-         * @brief 任务类 \struct
+         * @brief 任务优先级 \enum
          */
-        struct Task {
-            /// 任务可执行对象
-            std::function<void()> m_function;
+        enum class Priority {
+            High = 0,  ///< 延迟敏感任务（管理、健康检查等），总是最先调度
+            Normal = 1,  ///< 普通任务
+            Background = 2  ///< 后台批量任务
+        };
 
-            /// 任务id
-            int32_t m_task_id;
+        /// 优先级数目
+        static const size_t PriorityNum = 3;
 
-            /*!
-             * @brief 任务类构造函数
-             * @param [in] function 任务可执行对象，默认为nullptr
-             * @param [in] task_id 任务id，默认为-1
-             */
-            explicit Task(std::function<void()> function = nullptr, int32_t task_id = -1);
+        /*!
+         * @brief 等待队列已满时的处理策略 \enum
+         */
+        enum class RejectionPolicy {
+            Block,  ///< 阻塞提交线程，直到有空位
+            Reject,  ///< 拒绝任务，addTask返回false
+            CallerRuns,  ///< 在提交线程中直接执行任务
+            DropOldest  ///< 丢弃最低优先级队列中最老的任务（交给丢弃回调），再加入新任务
         };
-    public:
+
+        /// 任务丢弃回调类型
+        typedef std::function<void(Task&)> drop_callback_type;
+
+        /*!
+         * @brief 单个工作线程的运行统计 \struct
+         */
+        struct WorkerStats {
+            /// 线程名
+            std::string m_name;
+
+            /// 已执行任务数
+            uint64_t m_tasks_run;
+
+            /// 执行任务的累计时长，以纳秒为单位
+            uint64_t m_busy_ns;
+
+            /// 等待任务的累计时长，以纳秒为单位
+            uint64_t m_idle_ns;
+        };
+
+        /*!
+         * @brief 线程池运行统计快照 \struct
+         */
+        struct Stats {
+            /// 各工作线程统计
+            std::vector<WorkerStats> m_workers;
+
+            /// 任务从入队到开始执行的等待时长分布，以纳秒为单位
+            Histogram::Snapshot m_queue_wait;
+
+            /// 任务执行时长分布，以纳秒为单位
+            Histogram::Snapshot m_run_time;
+
+            /// 等待中的任务数
+            size_t m_pending;
+
+            /// 各优先级执行中的任务数
+            size_t m_running[PriorityNum];
+        };
+
         /*!
          * @brief 内部线程类 \class
          */
@@ -45,15 +112,11 @@ namespace xjj {
         public:
             /*!
              * @brief 构造函数
-             * @param [in,out] waiting_queue_ptr 等待队列指针
-             * @param [in,out] working_queue_ptr 工作队列指针
-             * @param [in,out] finished_queue_ptr 任务完成队列指针
+             * @param [in] pool_ptr 所属线程池指针
+             * @param [in] index 线程序号，用于线程命名
              * @param [in] wait_finish 线程池发出终止指令时，是否选择继续执行等待队列中的任务，默认为true
              */
-            Thread(BlockingQueue<Task> *waiting_queue_ptr,
-                   BlockingQueue<int> *working_queue_ptr,
-                   BlockingQueue<int32_t> *finished_queue_ptr,
-                   bool wait_finish = true);
+            Thread(ThreadPool *pool_ptr, size_t index, bool wait_finish = true);
 
             /*!
              * @brief 析构函数
@@ -88,6 +151,12 @@ namespace xjj {
              */
             void exit();
 
+            /*!
+             * @brief 将本线程的统计累加到线程池统计快照中
+             * @param [in,out] stats 线程池统计快照
+             */
+            void collectStats(Stats& stats) const;
+
         private:
             /// 线程id
             pthread_t m_thread_id;
@@ -98,14 +167,29 @@ namespace xjj {
             /// 线程池发出终止指令时，是否选择继续执行等待队列中的任务
             bool m_wait_finish;
 
-            /// 等待队列指针
-            BlockingQueue<Task> *m_waiting_queue_ptr;
+            /// 所属线程池指针
+            ThreadPool *m_pool_ptr;
+
+            /// 线程名，形如"workerbee-0"（pthread_setname_np限制为15个字符）
+            std::string m_name;
+
+            /// 已执行任务数
+            std::atomic<uint64_t> m_tasks_run;
+
+            /// 执行任务的累计时长，以纳秒为单位
+            std::atomic<uint64_t> m_busy_ns;
+
+            /// 等待任务的累计时长，以纳秒为单位（不含正在进行中的这段）
+            std::atomic<uint64_t> m_idle_ns;
+
+            /// 正在进行中的这段空闲的起点（steady_clock计数），执行任务时为0
+            std::atomic<std::chrono::steady_clock::rep> m_idle_since;
 
-            /// 工作队列指针
-            BlockingQueue<int> *m_working_queue_ptr;
+            /// 本线程所取任务的排队时长分布
+            Histogram m_queue_wait;
 
-            /// 任务完成队列指针
-            BlockingQueue<int32_t > *m_finished_queue_ptr;
+            /// 本线程所执行任务的执行时长分布
+            Histogram m_run_time;
         };
 
         /*!
@@ -130,28 +214,443 @@ namespace xjj {
          */
         void start();
 
+        /*!
+         * @brief 设置Normal与Background优先级的调度份额，须在start之前调用
+         * 两者都有挂起任务时，每 normal_share + background_share 次调度中
+         * Normal占 normal_share 次；某一级为空时另一级可用满所有调度机会
+         * @param [in] normal_share Normal份额，默认为4
+         * @param [in] background_share Background份额，默认为1
+         */
+        void setPriorityShares(size_t normal_share, size_t background_share);
+
+        /*!
+         * @brief 设置某优先级同时占用的线程数上限，须在start之前调用
+         * 例如将Background配额设为线程总数减一，可保证总有线程能及时处理High任务
+         * @param [in] priority 目标优先级
+         * @param [in] max_running 同时执行该优先级任务的线程数上限，默认为线程总数
+         */
+        void setPriorityQuota(Priority priority, thread_num_type max_running);
+
+        /*!
+         * @brief 设置等待队列容量（所有优先级合计）及队满时的处理策略，须在start之前调用
+         * 容量通过原子计数预留，检查是精确的且无需加锁；使用无锁队列时容量至多为MaxCapacity
+         * @param [in] capacity 等待任务数上限
+         * @param [in] policy 队满处理策略，默认为Block
+         * @param [in] drop_callback DropOldest策略下被丢弃任务的回调，可为空
+         */
+        void setCapacity(size_t capacity,
+                         RejectionPolicy policy = RejectionPolicy::Block,
+                         drop_callback_type drop_callback = nullptr);
+
         /*!
          * @brief 往线程池添加任务
-         * @param [in] function 任务可执行对象
-         * @param [in] task_id 任务id
+         * @param [in] task 任务对象，可由任意无参可执行对象隐式构造，小对象不分配堆内存
+         * @param [in] priority 任务优先级，默认为Normal
+         * @return 添加成功与否（非过载模式下已满，或Reject策略下队列已满时返回false）
+         */
+        bool addTask(Task task, Priority priority = Priority::Normal);
+
+        /*!
+         * @brief 尝试往线程池添加任务，不阻塞、不在调用线程执行、不丢弃其它任务
+         * @param [in] task 任务对象
+         * @param [in] priority 任务优先级，默认为Normal
+         * @return 添加成功与否（线程池未运行、已满或等待队列已满时返回false）
+         */
+        bool tryAddTask(Task task, Priority priority = Priority::Normal);
+
+        /*!
+         * @brief 在调用线程上执行一个等待中的任务（遵守优先级调度与配额），用于等待时帮助执行
+         * @return 是否执行了任务
+         */
+        bool runPendingTask();
+
+        /*!
+         * @brief 往线程池批量添加任务：整批预留队列位置、在一次加锁内入队，并只唤醒所需数目的空闲线程
+         * 预留不足的部分按队满处理策略逐个处理；非过载模式下或Reject策略下则在此停止，
+         * 未被加入的任务保持原样（不被移出）
+         * @tparam Iterator 前向迭代器类型，元素可为Task或可构造Task的可执行对象，被加入的元素会被移出
+         * @param [in] first 起始迭代器
+         * @param [in] last 结束迭代器
+         * @param [in] priority 任务优先级，默认为Normal
+         * @return 被接受的任务数，即[first, first + 返回值)中的任务被加入或已执行
+         */
+        template <typename Iterator>
+        size_t addTasks(Iterator first, Iterator last, Priority priority = Priority::Normal) {
+            if (!m_running) // 线程池未在运行，此时添加任务会抛异常
+                throw std::runtime_error("thread pool is not running.");
+
+            auto count = static_cast<size_t>(std::distance(first, last));
+            size_t reserved = reserveSlots(count);
+            Iterator middle = first;
+            std::advance(middle, reserved);
+            if (reserved > 0) {
+                m_waiting_queues[static_cast<size_t>(priority)].pushRange(first, middle);
+                notifyIdleThreads(reserved);
+            }
+            if (reserved == count || !m_overload || m_rejection_policy == RejectionPolicy::Reject)
+                return reserved;
+
+            // 剩余任务按Block、CallerRuns或DropOldest策略逐个处理，均会被接受
+            for (; middle != last; ++middle)
+                addTask(std::move(*middle), priority);
+            return count;
+        }
+
+        /*!
+         * @brief 以Normal优先级往线程池提交任务，通过返回的TaskFuture获取返回值或异常
+         * @tparam F 可执行对象类型
+         * @tparam Args 参数类型
+         * @param [in] function 可执行对象
+         * @param [in] args 调用参数
+         * @return 任务future
+         */
+        template <typename F, typename... Args>
+        TaskFuture<typename TaskResultOf<F, Args...>::type> submit(F&& function, Args&&... args) {
+            return submit(Priority::Normal, std::forward<F>(function), std::forward<Args>(args)...);
+        }
+
+        /*!
+         * @brief 往线程池提交任务，通过返回的TaskFuture获取返回值或异常
+         * 可执行对象、参数与结果共用一次内存分配；任务被拒绝或丢弃而未执行时，
+         * future中保存一个std::runtime_error
+         * @tparam F 可执行对象类型
+         * @tparam Args 参数类型
+         * @param [in] priority 任务优先级
+         * @param [in] function 可执行对象
+         * @param [in] args 调用参数
+         * @return 任务future
+         */
+        template <typename F, typename... Args>
+        TaskFuture<typename TaskResultOf<F, Args...>::type> submit(
+                Priority priority, F&& function, Args&&... args) {
+            typedef typename TaskResultOf<F, Args...>::type result_type;
+            typedef decltype(std::bind(std::forward<F>(function), std::forward<Args>(args)...)) bind_type;
+            typedef TaskFunctionState<result_type, bind_type> state_type;
+
+            std::shared_ptr<state_type> state = std::make_shared<state_type>(
+                    std::bind(std::forward<F>(function), std::forward<Args>(args)...));
+            addTask(TaskStateRunner<state_type>(state), priority);  // 被拒绝时执行器析构，向future写入异常
+            return TaskFuture<result_type>(std::move(state));
+        }
+
+        /*!
+         * @brief 往线程池提交带完成回调的任务，回调在工作线程中以 callback(TaskResult<R>&) 形式调用，
+         * 结果不经过任何共享状态
+         * @tparam F 可执行对象类型
+         * @tparam Callback 完成回调类型
+         * @param [in] function 可执行对象
+         * @param [in] callback 完成回调
+         * @param [in] priority 任务优先级，默认为Normal
          * @return 添加成功与否
          */
-        bool addTask(std::function<void()> function, int32_t task_id);
+        template <typename F, typename Callback>
+        bool submitWithCallback(F&& function, Callback&& callback, Priority priority = Priority::Normal) {
+            typedef typename TaskResultOf<F>::type result_type;
+            return addTask(CallbackTask<result_type,
+                    typename std::decay<F>::type,
+                    typename std::decay<Callback>::type>{
+                    std::forward<F>(function), std::forward<Callback>(callback)}, priority);
+        }
 
         /*!
-         * @brief 获取一个已经完成的任务的id
-         * @return 获取到的id（已完成任务队列为空时返回-1）
+         * @brief 并行执行 function(i)，i取遍[first, last)；返回时所有调用均已完成
+         * 区间按grain个一组划分，调用线程与线程池中的线程共同领取执行；
+         * 某次调用抛出异常时不再领取新的分组，异常在所有已领取的分组完成后重新抛出
+         * @tparam Index 下标类型，整数类型
+         * @tparam F 可执行对象类型，以 void(Index) 形式调用
+         * @param [in] first 起始下标
+         * @param [in] last 结束下标
+         * @param [in] grain 每组下标数，为0时按1处理
+         * @param [in] function 可执行对象
+         * @param [in] priority 帮助线程所提交任务的优先级，默认为Normal
          */
-        int32_t getFinishedTaskId();
+        template <typename Index, typename F>
+        void parallelFor(Index first, Index last, size_t grain, F&& function,
+                         Priority priority = Priority::Normal) {
+            if (!(first < last))
+                return;
+            grain = std::max<size_t>(grain, 1);
+            auto length = static_cast<size_t>(last - first);
+            runChunks((length + grain - 1) / grain, [&](size_t chunk) {
+                Index begin = first + static_cast<Index>(chunk * grain);
+                Index end = first + static_cast<Index>(std::min(length, (chunk + 1) * grain));
+                for (Index i = begin; i < end; ++i)
+                    function(i);
+            }, priority);
+        }
 
         /*!
-         * @brief 终止线程池
+         * @brief 并行归约：每组以 function(begin, end) 求得部分结果，再按分组顺序以reduce合并，
+         * 因此结果与执行顺序无关
+         * @tparam Index 下标类型，整数类型
+         * @tparam T 结果类型
+         * @tparam F 可执行对象类型，以 T(Index begin, Index end) 形式调用
+         * @tparam Reduce 合并函数类型，以 T(const T&, const T&) 形式调用
+         * @param [in] first 起始下标
+         * @param [in] last 结束下标
+         * @param [in] grain 每组下标数，为0时按1处理
+         * @param [in] identity 合并的单位元，区间为空时直接返回
+         * @param [in] function 求部分结果的可执行对象
+         * @param [in] reduce 合并函数
+         * @param [in] priority 帮助线程所提交任务的优先级，默认为Normal
+         * @return 归约结果
+         */
+        template <typename Index, typename T, typename F, typename Reduce>
+        T parallelReduce(Index first, Index last, size_t grain, T identity, F&& function, Reduce&& reduce,
+                         Priority priority = Priority::Normal) {
+            if (!(first < last))
+                return identity;
+            grain = std::max<size_t>(grain, 1);
+            auto length = static_cast<size_t>(last - first);
+            std::vector<T> partials((length + grain - 1) / grain, identity);
+            runChunks(partials.size(), [&](size_t chunk) {
+                Index begin = first + static_cast<Index>(chunk * grain);
+                Index end = first + static_cast<Index>(std::min(length, (chunk + 1) * grain));
+                partials[chunk] = function(begin, end);
+            }, priority);
+
+            T result = std::move(identity);
+            for (auto& partial : partials)
+                result = reduce(result, partial);
+            return result;
+        }
+
+        /*!
+         * @brief 安排延时任务，到期后按addTask的规则提交
+         * （Block策略下队满会阻塞定时器线程，被拒绝的任务直接丢弃）
+         * @param [in] delay 延时时长
+         * @param [in] task 任务对象
+         * @param [in] priority 任务优先级，默认为Normal
+         * @return 定时器句柄，可用于取消
+         */
+        TimerHandle scheduleAfter(std::chrono::nanoseconds delay, Task task,
+                                  Priority priority = Priority::Normal);
+
+        /*!
+         * @brief 安排周期任务，首次在一个周期后提交；上一次提交尚未执行完时跳过本次
+         * @param [in] period 触发周期，须为正
+         * @param [in] function 每次执行的可执行对象
+         * @param [in] priority 任务优先级，默认为Normal
+         * @return 定时器句柄，可用于取消
+         */
+        TimerHandle scheduleEvery(std::chrono::nanoseconds period, std::function<void()> function,
+                                  Priority priority = Priority::Normal);
+
+        /*!
+         * @brief 获取运行统计快照，运行中可随时调用（但不可与terminate并发），不会暂停工作线程
+         * 工作线程按"workerbee-序号"命名，可在top -H、gdb等工具中对应
+         * @return 统计快照
+         */
+        Stats getStats() const;
+
+        /*!
+         * @brief 终止线程池，未到期的延时与周期任务被丢弃
          * @param [in] wait_finish 线程池发出终止指令时，是否选择继续执行等待队列中的任务，默认为true
          */
         void terminate(bool wait_finish = true);
 
     private:
 
+        /*!
+         * @brief 等待队列元素：任务及其入队时间 \struct
+         */
+        struct QueuedTask {
+            /// 时钟类型
+            typedef std::chrono::steady_clock clock_type;
+
+            /*!
+             * @brief 构造函数，构造空元素
+             */
+            QueuedTask() = default;
+
+            /*!
+             * @brief 构造函数，以当前时间为入队时间
+             * @tparam F 任务或可构造任务的可执行对象类型
+             * @param [in] task 任务
+             */
+            template <typename F,
+                      typename = typename std::enable_if<
+                              !std::is_same<typename std::decay<F>::type, QueuedTask>::value>::type>
+            QueuedTask(F&& task)
+                    : m_task(std::forward<F>(task)), m_enqueue_time(clock_type::now()) {}
+
+            /// 任务
+            Task m_task;
+
+            /// 入队时间
+            clock_type::time_point m_enqueue_time;
+        };
+
+        /*!
+         * @brief 延时任务到期时在定时器线程上执行，将实际任务提交到线程池 \struct
+         */
+        struct DelayedTask {
+            /// 所属线程池指针
+            ThreadPool* m_pool_ptr;
+
+            /// 实际任务
+            Task m_task;
+
+            /// 任务优先级
+            Priority m_priority;
+
+            void operator() () {
+                m_pool_ptr -> addTask(std::move(m_task), m_priority);
+            }
+        };
+
+        /*!
+         * @brief 周期任务的一次执行，析构时（执行完、被丢弃或被清空）清除执行中标记 \struct
+         */
+        struct PeriodicRun {
+            /// 周期执行的可执行对象
+            std::shared_ptr<std::function<void()>> m_function;
+
+            /// 执行中标记
+            std::shared_ptr<std::atomic<bool>> m_in_flight;
+
+            PeriodicRun(std::shared_ptr<std::function<void()>> function,
+                        std::shared_ptr<std::atomic<bool>> in_flight)
+                    : m_function(std::move(function)), m_in_flight(std::move(in_flight)) {}
+
+            PeriodicRun(PeriodicRun&&) = default;
+
+            ~PeriodicRun() {
+                if (m_in_flight)
+                    m_in_flight -> store(false);
+            }
+
+            void operator() () {
+                (*m_function)();
+            }
+        };
+
+        /*!
+         * @brief 分组并行执行的共享状态 \struct
+         * 帮助任务可能在调用返回后才被执行，因此由shared_ptr持有；
+         * 只有领取到分组的线程会访问body，而调用线程在所有领取的分组完成后才返回
+         */
+        struct ChunkState {
+            /// 分组总数
+            size_t m_chunk_num;
+
+            /// 分组执行函数，指向调用线程栈上的对象
+            const std::function<void(size_t)>* m_body;
+
+            /// 下一个待领取的分组
+            std::atomic<size_t> m_next_chunk;
+
+            /// 已完成的分组数
+            std::atomic<size_t> m_done_num;
+
+            /// 是否已有分组抛出异常
+            std::atomic<bool> m_failed;
+
+            /// 第一个异常
+            std::exception_ptr m_exception;
+
+            /// 保护异常与完成通知的互斥量
+            Mutex m_mutex;
+
+            /// 全部完成 条件变量
+            ConditionVariable m_done_cond_var;
+        };
+
+        /*!
+         * @brief 由调用线程与线程池共同执行chunk_num个分组，返回时全部完成
+         * @param [in] chunk_num 分组总数
+         * @param [in] body 分组执行函数，参数为分组下标
+         * @param [in] priority 帮助任务的优先级
+         */
+        void runChunks(size_t chunk_num, const std::function<void(size_t)>& body, Priority priority);
+
+        /*!
+         * @brief 循环领取并执行分组，直到没有剩余分组
+         * @param [in,out] state 共享状态
+         */
+        static void executeChunks(ChunkState& state);
+
+        /*!
+         * @brief 工作线程获取任务，没有可执行任务时定时等待，超时1秒返回
+         * @param [out] task 获取到的任务
+         * @param [out] priority 获取到的任务的优先级
+         * @return 是否获取到任务
+         */
+        bool takeTask(QueuedTask& task, Priority& priority);
+
+        /*!
+         * @brief 按优先级与份额尝试获取一个任务，不阻塞
+         * @param [out] task 获取到的任务
+         * @param [out] priority 获取到的任务的优先级
+         * @return 是否获取到任务
+         */
+        bool tryTakeTask(QueuedTask& task, Priority& priority);
+
+        /*!
+         * @brief 在配额允许的情况下尝试从指定优先级的队列获取一个任务
+         * @param [in] index 优先级下标
+         * @param [out] task 获取到的任务
+         * @return 是否获取到任务
+         */
+        bool tryTakeTaskFrom(size_t index, QueuedTask& task);
+
+        /*!
+         * @brief 工作线程执行完任务后调用，归还配额
+         * @param [in] priority 所执行任务的优先级
+         */
+        void finishTask(Priority priority);
+
+        /*!
+         * @brief 在计数未达上限时将其加一
+         * @param [in,out] counter 目标计数
+         * @param [in] limit 上限
+         * @return 是否加一成功
+         */
+        static bool tryIncrease(std::atomic<size_t>& counter, size_t limit);
+
+        /*!
+         * @brief 在不超过上限的前提下将计数至多增加amount
+         * @param [in,out] counter 目标计数
+         * @param [in] amount 欲增加的量
+         * @param [in] limit 上限
+         * @return 实际增加的量
+         */
+        static size_t increaseUpTo(std::atomic<size_t>& counter, size_t amount, size_t limit);
+
+        /*!
+         * @brief Block策略下等待队列出现空位并预留
+         */
+        void waitForPendingSlot();
+
+        /*!
+         * @brief DropOldest策略下丢弃最低优先级队列中最老的任务
+         * @return 是否丢弃了任务（队列均为空时返回false）
+         */
+        bool dropOldestTask();
+
+        /*!
+         * @brief 工作线程取出任务后调用，若有因队满而阻塞的提交线程，唤醒其中一个
+         */
+        void notifyBlockedSubmitter();
+
+        /*!
+         * @brief 若有空闲等待的工作线程，唤醒其中一个
+         */
+        void notifyIdleThread();
+
+        /*!
+         * @brief 唤醒至多task_num个空闲等待的工作线程
+         * @param [in] task_num 新加入的任务数
+         */
+        void notifyIdleThreads(size_t task_num);
+
+        /*!
+         * @brief 为批量添加一次性预留队列位置，能预留多少就预留多少
+         * @param [in] task_num 欲预留的位置数
+         * @return 实际预留的位置数
+         */
+        size_t reserveSlots(size_t task_num);
+
         /// 线程池是否处于运行状态
         bool m_running;
 
@@ -164,14 +663,73 @@ namespace xjj {
         /// 线程指针数组
         std::vector<std::shared_ptr<Thread>> m_thread_ptr_set;
 
-        /// 任务等待队列：存放任务
-        BlockingQueue<Task> m_waiting_queue;
+        /// 延时与周期任务的定时器队列
+        TimerQueue m_timer_queue;
+
+#if _XJJ_LOCK_FREE_TASK_QUEUE
+        /// 任务等待队列类型，每个队列容量为LockFreeQueue<QueuedTask>::DefaultCapacity
+        typedef LockFreeQueue<QueuedTask> task_queue_type;
+
+        /// 等待队列容量上限：所有优先级合计不超过单个队列容量，预留到位置后入队总能成功
+        static const size_t MaxCapacity = task_queue_type::DefaultCapacity;
+#else
+        /// 任务等待队列类型
+        typedef BlockingQueue<QueuedTask> task_queue_type;
+
+        /// 等待队列容量上限
+        static const size_t MaxCapacity = std::numeric_limits<size_t>::max();
+#endif
+
+        /// 任务等待队列：每个优先级一个
+        task_queue_type m_waiting_queues[PriorityNum];
+
+        /// 各优先级等待中的任务总数
+        std::atomic<size_t> m_pending_count;
+
+        /// 等待中与执行中的任务总数，用于非过载模式
+        std::atomic<size_t> m_active_count;
+
+        /// 等待任务数上限
+        size_t m_capacity;
+
+        /// 队满处理策略
+        RejectionPolicy m_rejection_policy;
+
+        /// 任务丢弃回调
+        drop_callback_type m_drop_callback;
+
+        /// 因队满而阻塞的提交线程数
+        std::atomic<size_t> m_blocked_count;
+
+        /// 队满阻塞互斥量
+        Mutex m_full_mutex;
+
+        /// 队列未满 条件变量
+        ConditionVariable m_not_full_cond_var;
+
+        /// 各优先级正在执行的任务数
+        std::atomic<size_t> m_running_counts[PriorityNum];
+
+        /// 各优先级同时执行的任务数上限
+        thread_num_type m_priority_quotas[PriorityNum];
+
+        /// Normal优先级调度份额
+        size_t m_normal_share;
+
+        /// Background优先级调度份额
+        size_t m_background_share;
+
+        /// Normal与Background之间的加权轮转计数
+        std::atomic<size_t> m_schedule_tick;
+
+        /// 空闲等待中的工作线程数
+        std::atomic<size_t> m_idle_count;
 
-        /// 工作队列：只需记录工作中的任务的数目
-        BlockingQueue<int> m_working_queue;
+        /// 空闲等待互斥量
+        Mutex m_idle_mutex;
 
-        /// 任务完成队列：存放已经完成的任务id
-        BlockingQueue<int32_t> m_finished_queue;
+        /// 有新任务 条件变量
+        ConditionVariable m_idle_cond_var;
 
         /// 线程池最大线程数目
         static const thread_num_type MaxThreadNum;
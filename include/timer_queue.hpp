@@ -0,0 +1,233 @@
+//
+// created by agent on 2026-10-18
+//
+
+#ifndef _XJJ_TIMER_QUEUE_HPP
+#define _XJJ_TIMER_QUEUE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <pthread.h>
+#include "condition_variable.hpp"
+#include "task.hpp"
+
+namespace xjj {
+    /*!
+     * @brief 定时器共享状态 \struct
+     * 由定时器队列与定时器句柄共同持有
+     */
+    struct TimerState {
+        /*!
+         * @brief 定时器状态 \enum
+         */
+        enum Status {
+            Pending = 0,  ///< 等待触发（周期定时器在取消前一直处于该状态）
+            Fired = 1,  ///< 单次定时器已触发
+            Cancelled = 2  ///< 已取消
+        };
+
+        /*!
+         * @brief 构造函数
+         * @param [in] task 到期时在定时器线程上执行的任务
+         * @param [in] period 触发周期，为0表示单次定时器
+         */
+        TimerState(Task task, std::chrono::nanoseconds period)
+                : m_status(Pending), m_task(std::move(task)), m_period(period) {}
+
+        /// 定时器状态
+        std::atomic<int> m_status;
+
+        /// 到期时执行的任务
+        Task m_task;
+
+        /// 触发周期
+        std::chrono::nanoseconds m_period;
+    };
+
+    /*!
+     * @brief 定时器句柄类 \class
+     * 用于取消已安排的定时器，可拷贝，句柄销毁不影响定时器
+     */
+    class TimerHandle {
+    public:
+
+        /*!
+         * @brief 构造函数，构造空句柄
+         */
+        TimerHandle() = default;
+
+        /*!
+         * @brief 构造函数
+         * @param [in] state 定时器共享状态
+         */
+        explicit TimerHandle(std::shared_ptr<TimerState> state);
+
+        /*!
+         * @brief 取消定时器；周期定时器取消后不再触发，已提交的那一次仍会执行
+         * @return 取消前定时器是否仍在等待触发
+         */
+        bool cancel();
+
+        /*!
+         * @brief 判断定时器是否仍在等待触发
+         * @return 是否等待触发
+         */
+        bool pending() const;
+
+        /*!
+         * @brief 判断句柄是否关联定时器
+         * @return 是否非空
+         */
+        bool valid() const;
+
+    private:
+
+        /// 定时器共享状态
+        std::shared_ptr<TimerState> m_state;
+    };
+
+    /*!
+     * @brief 定时器队列类 \class
+     * 以一个定时器线程和最小堆管理定时器，到期任务在定时器线程上执行，应当很快返回
+     */
+    class TimerQueue {
+    public:
+
+        /// 时钟类型，不受系统时间调整影响
+        typedef std::chrono::steady_clock clock_type;
+
+        /// 时间点类型
+        typedef clock_type::time_point time_point;
+
+        /*!
+         * @brief 构造函数
+         */
+        TimerQueue();
+
+        /*!
+         * @brief 禁止拷贝构造
+         */
+        TimerQueue(const TimerQueue&) = delete;
+
+        /*!
+         * @brief 禁止赋值
+         * @return TimerQueue&
+         */
+        TimerQueue& operator=(const TimerQueue&) = delete;
+
+        /*!
+         * @brief 析构函数：调用stop停止定时器线程
+         */
+        ~TimerQueue();
+
+        /*!
+         * @brief 启动定时器线程
+         * @return 创建线程是否成功
+         */
+        bool start();
+
+        /*!
+         * @brief 停止定时器线程，丢弃所有未触发的定时器
+         */
+        void stop();
+
+        /*!
+         * @brief 安排单次定时器
+         * @param [in] deadline 到期时间
+         * @param [in] task 到期时执行的任务
+         * @return 定时器句柄
+         */
+        TimerHandle scheduleAt(time_point deadline, Task task);
+
+        /*!
+         * @brief 安排周期定时器；错过的触发不会补执行
+         * @param [in] first 首次到期时间
+         * @param [in] period 触发周期，须为正
+         * @param [in] task 每次到期时执行的任务
+         * @return 定时器句柄
+         */
+        TimerHandle scheduleEvery(time_point first, std::chrono::nanoseconds period, Task task);
+
+        /*!
+         * @brief 获取堆中的定时器数目（包括已取消但尚未到期的）
+         * @return 定时器数目
+         */
+        size_t size();
+
+    private:
+
+        /*!
+         * @brief 堆元素 \struct
+         */
+        struct Entry {
+            /// 到期时间
+            time_point m_deadline;
+
+            /// 安排顺序，到期时间相同时先安排的先触发
+            uint64_t m_sequence;
+
+            /// 定时器共享状态
+            std::shared_ptr<TimerState> m_state;
+        };
+
+        /*!
+         * @brief 堆元素比较函数对象，使堆顶为最早到期的元素 \struct
+         */
+        struct EntryLater {
+            bool operator() (const Entry& lhs, const Entry& rhs) const {
+                return lhs.m_deadline != rhs.m_deadline ?
+                       lhs.m_deadline > rhs.m_deadline : lhs.m_sequence > rhs.m_sequence;
+            }
+        };
+
+        /*!
+         * @brief 将定时器加入堆
+         * @param [in] deadline 到期时间
+         * @param [in] period 触发周期，为0表示单次定时器
+         * @param [in] task 到期时执行的任务
+         * @return 定时器句柄
+         */
+        TimerHandle schedule(time_point deadline, std::chrono::nanoseconds period, Task task);
+
+        /*!
+         * @brief 将堆元素加入堆，调用者须持有互斥量
+         * @param [in] entry 堆元素
+         */
+        void pushEntry(Entry entry);
+
+        /*!
+         * @brief 定时器线程主循环
+         */
+        void run();
+
+        /*!
+         * @brief 定时器线程入口函数
+         * @param [in] arg 定时器队列指针
+         * @return nullptr
+         */
+        static void* threadFunction(void* arg);
+
+        /// 互斥量，保护堆与运行状态
+        Mutex m_mutex;
+
+        /// 堆顶变化或停止 条件变量
+        ConditionVariable m_cond_var;
+
+        /// 按到期时间排列的最小堆
+        std::vector<Entry> m_heap;
+
+        /// 下一个安排顺序号
+        uint64_t m_next_sequence;
+
+        /// 定时器线程是否运行
+        bool m_running;
+
+        /// 定时器线程id
+        pthread_t m_thread_id;
+    };
+} // namespace xjj
+
+#endif
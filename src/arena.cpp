@@ -0,0 +1,168 @@
+//
+// created by agent on 2026-10-18
+//
+
+#include <algorithm>
+#include <cstdlib>
+#include "arena.hpp"
+
+namespace xjj {
+
+    /// 线程缓存的内存块大小
+    const size_t Arena::SlabSize;
+
+    /// 每个线程缓存的内存块数目上限
+    const size_t Arena::MaxCachedSlabs;
+
+    /*!
+     * @brief 当前线程的当前内存池，设为static以限制只能在本文件内使用
+     */
+    static thread_local Arena* t_current_arena = nullptr;
+
+    /*!
+     * @brief 当前线程缓存的定长内存块链表（以块头首字段链接），设为static以限制只能在本文件内使用
+     */
+    static thread_local void* t_cached_slabs = nullptr;
+
+    /*!
+     * @brief 当前线程缓存的定长内存块数目，设为static以限制只能在本文件内使用
+     */
+    static thread_local size_t t_cached_slab_num = 0;
+
+    /*!
+     * @brief 当前线程是否已登记退出时释放缓存，设为static以限制只能在本文件内使用
+     */
+    static thread_local bool t_slab_cache_registered = false;
+
+    /*!
+     * @brief 当前线程是否正在退出（缓存已释放），之后归还的内存块直接释放
+     */
+    static thread_local bool t_slab_cache_exited = false;
+
+    /*!
+     * @brief 线程退出时释放线程缓存的内存块 \struct
+     */
+    struct SlabCacheFlusher {
+        ~SlabCacheFlusher() {
+            while (t_cached_slabs) {
+                void* next = *static_cast<void**>(t_cached_slabs);
+                free(t_cached_slabs);
+                t_cached_slabs = next;
+            }
+            t_cached_slab_num = 0;
+            t_slab_cache_exited = true;
+        }
+    };
+
+    /*!
+     * @brief 构造函数，不申请内存，首次分配时才取内存块
+     */
+    Arena::Arena()
+            : m_blocks(nullptr),
+              m_cursor(nullptr),
+              m_end(nullptr),
+              m_finalizers(nullptr),
+              m_used(0),
+              m_previous(t_current_arena) {
+        t_current_arena = this;
+    }
+
+    /*!
+     * @brief 析构函数：执行登记的析构函数并归还全部内存块
+     */
+    Arena::~Arena() {
+        reset();
+        t_current_arena = m_previous;
+    }
+
+    /*!
+     * @brief 执行登记的析构函数并归还全部内存块，之后可继续分配
+     */
+    void Arena::reset() {
+        for (Finalizer* finalizer = m_finalizers; finalizer; finalizer = finalizer -> m_next)
+            finalizer -> m_destroy(finalizer -> m_object);
+        m_finalizers = nullptr;
+
+        while (m_blocks) {
+            Block* next = m_blocks -> m_next;
+            releaseBlock(m_blocks);
+            m_blocks = next;
+        }
+        m_cursor = nullptr;
+        m_end = nullptr;
+        m_used = 0;
+    }
+
+    /*!
+     * @brief 获取已分配的字节数
+     * @return 已分配的字节数
+     */
+    size_t Arena::used() const {
+        return m_used;
+    }
+
+    /*!
+     * @brief 获取当前线程的当前内存池（最近构造且尚未析构的内存池）
+     * @return 内存池指针，没有时为空
+     */
+    Arena* Arena::current() {
+        return t_current_arena;
+    }
+
+    /*!
+     * @brief 当前内存块空间不足时取新内存块再分配
+     * @param [in] size 字节数
+     * @param [in] alignment 对齐字节数
+     * @return 内存地址
+     */
+    void* Arena::allocateSlow(size_t size, size_t alignment) {
+        Block* block = acquireBlock(sizeof(Block) + size + alignment);
+        block -> m_next = m_blocks;
+        m_blocks = block;
+        m_cursor = reinterpret_cast<char*>(block + 1);
+        m_end = reinterpret_cast<char*>(block) + block -> m_size;
+        return allocate(size, alignment);  // 新内存块空间足够，不会再次进入本函数
+    }
+
+    /*!
+     * @brief 从线程缓存中取内存块，缓存为空或所需空间超过SlabSize时申请内存
+     * @param [in] min_size 所需的最小块大小（含块头）
+     * @return 内存块
+     */
+    Arena::Block* Arena::acquireBlock(size_t min_size) {
+        Block* block = nullptr;
+        if (min_size <= SlabSize && t_cached_slabs) {
+            block = static_cast<Block*>(t_cached_slabs);
+            t_cached_slabs = block -> m_next;
+            t_cached_slab_num--;
+            return block;
+        }
+
+        size_t block_size = std::max(min_size, SlabSize);
+        block = static_cast<Block*>(malloc(block_size));
+        if (!block)
+            throw std::bad_alloc();
+        block -> m_size = block_size;
+        return block;
+    }
+
+    /*!
+     * @brief 归还内存块到线程缓存，缓存已满、非定长内存块或线程正在退出时释放
+     * @param [in] block 内存块
+     */
+    void Arena::releaseBlock(Block* block) {
+        if (block -> m_size == SlabSize && t_cached_slab_num < MaxCachedSlabs && !t_slab_cache_exited) {
+            if (!t_slab_cache_registered) {
+                t_slab_cache_registered = true;
+                static thread_local SlabCacheFlusher flusher;
+                (void) flusher;
+            }
+            block -> m_next = static_cast<Block*>(t_cached_slabs);
+            t_cached_slabs = block;
+            t_cached_slab_num++;
+        } else {
+            free(block);
+        }
+    }
+
+} // namespace xjj
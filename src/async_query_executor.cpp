@@ -0,0 +1,183 @@
+//
+// created by agent on 2026-10-19
+//
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <utility>
+#include "async_query_executor.hpp"
+
+namespace xjj {
+
+    /*!
+     * @brief 构造函数
+     */
+    AsyncQueryExecutor::AsyncQueryExecutor()
+            : m_epoll_fd(epoll_create1(EPOLL_CLOEXEC)),
+              m_mutex("AsyncQueryExecutor::m_mutex", true) {  // 临界区只有查表，先自旋再睡眠
+        assert(m_epoll_fd != -1);
+    }
+
+    /*!
+     * @brief 析构函数；未完成的查询等待其执行完毕后归还连接，不调用回调
+     */
+    AsyncQueryExecutor::~AsyncQueryExecutor() {
+        // 异步查询对象析构时阻塞至语句执行完毕，须先于租约析构
+        for (auto& item : m_pending)
+            item.second -> m_query.reset();
+        m_pending.clear();
+        close(m_epoll_fd);
+    }
+
+    /*!
+     * @brief 开始执行sql语句；语句在本调用中即完成时（包括出错）回调在调用线程中执行，
+     * 否则在调用processEvents()的线程中执行。回调应简短且不可抛出异常
+     * @param [in] lease 执行语句的连接租约，查询完成后归还
+     * @param [in] sql sql语句
+     * @param [in] callback 查询完成回调
+     */
+    void AsyncQueryExecutor::execute(ConnectionLease lease, const std::string& sql, Callback callback) {
+        std::unique_ptr<PendingQuery> pending(new PendingQuery());
+        pending -> m_query = lease -> createStatement() -> executeQueryAsync(sql);
+        pending -> m_lease = std::move(lease);
+        pending -> m_callback = std::move(callback);
+
+        std::exception_ptr error;
+        if (advance(*pending -> m_query, error)) {
+            complete(std::move(pending), error);
+            return;
+        }
+
+        // 先放入表中再注册，processEvents()取到事件时必能查到；
+        // ET模式下注册时已就绪的套接字同样会报告一次，不会丢失在两次调用之间到来的数据。
+        // 同时监听可写，发送大语句时写缓冲区满也能得到推进
+        int sock_fd = pending -> m_query -> getSocket();
+        {
+            AutoLockMutex lock(&m_mutex);
+            m_pending[sock_fd] = std::move(pending);
+        }
+        epoll_event event{};
+        event.data.fd = sock_fd;
+        event.events = EPOLLIN | EPOLLOUT | EPOLLET;
+        if (-1 == epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, sock_fd, &event)) {
+            // 注册失败时查询永远不会被推进：移出表并以异常完成，异步查询对象析构时等待语句执行完毕
+            std::exception_ptr error = std::make_exception_ptr(sql::SQLException(
+                    std::string("cannot register query socket to epoll: ") + strerror(errno) +
+                    " (in function xjj::AsyncQueryExecutor::execute)", 0));
+            {
+                AutoLockMutex lock(&m_mutex);
+                auto it = m_pending.find(sock_fd);
+                pending = std::move(it -> second);
+                m_pending.erase(it);
+            }
+            complete(std::move(pending), error);
+        }
+    }
+
+    /*!
+     * @brief 开始执行sql语句
+     * @param [in] lease 执行语句的连接租约，查询完成后归还
+     * @param [in] sql sql语句
+     * @return 结果集的future，出错时get()抛出SQLException；须有线程调用processEvents()才能完成
+     */
+    std::future<std::shared_ptr<sql::ResultSet>> AsyncQueryExecutor::execute(
+            ConnectionLease lease, const std::string& sql) {
+        // Callback须可拷贝，promise以shared_ptr持有
+        auto promise = std::make_shared<std::promise<std::shared_ptr<sql::ResultSet>>>();
+        std::future<std::shared_ptr<sql::ResultSet>> future = promise -> get_future();
+        execute(std::move(lease), sql,
+                [promise] (std::shared_ptr<sql::ResultSet> result, std::exception_ptr error) {
+                    if (error)
+                        promise -> set_exception(error);
+                    else
+                        promise -> set_value(std::move(result));
+                });
+        return future;
+    }
+
+    /*!
+     * @brief 推进套接字已就绪的查询并调用已完成查询的回调；同一时间只应有一个线程调用
+     * @param [in] timeout_ms 没有就绪查询时的等待时长，单位为毫秒，-1表示一直等待，默认为0
+     * @return 本次完成的查询数目
+     */
+    size_t AsyncQueryExecutor::processEvents(int timeout_ms) {
+        int number = epoll_wait(m_epoll_fd, m_events, MaxEventCount, timeout_ms);
+        size_t completed = 0;
+        for (int i = 0; i < number; i++) {
+            int sock_fd = m_events[i].data.fd;
+            PendingQuery* pending = nullptr;
+            {
+                AutoLockMutex lock(&m_mutex);
+                auto it = m_pending.find(sock_fd);
+                if (it != m_pending.end())
+                    pending = it -> second.get();
+            }
+            // 只有本线程移除表项，推进期间无需持有互斥量
+            std::exception_ptr error;
+            if (!pending || !advance(*pending -> m_query, error))
+                continue;
+
+            // 先注销并移出表，归还连接后它可能立即被另一个查询使用
+            epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, sock_fd, nullptr);
+            std::unique_ptr<PendingQuery> done;
+            {
+                AutoLockMutex lock(&m_mutex);
+                auto it = m_pending.find(sock_fd);
+                done = std::move(it -> second);
+                m_pending.erase(it);
+            }
+            complete(std::move(done), error);
+            ++completed;
+        }
+        return completed;
+    }
+
+    /*!
+     * @brief 获取执行器的epoll文件描述符，有查询套接字就绪时可读
+     * @return epoll文件描述符
+     */
+    int AsyncQueryExecutor::getEventFd() const {
+        return m_epoll_fd;
+    }
+
+    /*!
+     * @brief 获取未完成的查询数目
+     * @return 未完成的查询数目
+     */
+    size_t AsyncQueryExecutor::getPendingNum() const {
+        AutoLockMutex lock(&m_mutex);
+        return m_pending.size();
+    }
+
+    /*!
+     * @brief 推进查询一次
+     * @param [in] query 异步查询对象
+     * @param [out] error 出错时的异常
+     * @return 是否已完成（包括出错）
+     */
+    bool AsyncQueryExecutor::advance(sql::AsyncQuery& query, std::exception_ptr& error) {
+        try {
+            return query.poll();
+        } catch (...) {
+            error = std::current_exception();
+            return true;
+        }
+    }
+
+    /*!
+     * @brief 归还已完成查询的连接并调用其回调
+     * @param [in] pending 已完成的查询
+     * @param [in] error 出错时的异常
+     */
+    void AsyncQueryExecutor::complete(std::unique_ptr<PendingQuery> pending, std::exception_ptr error) {
+        // 结果已全部取回，结果集不再访问连接，可先归还连接
+        std::shared_ptr<sql::ResultSet> result;
+        if (!error)
+            result = pending -> m_query -> getResult();
+        pending -> m_query.reset();
+        pending -> m_lease.reset();
+        pending -> m_callback(std::move(result), error);
+    }
+}
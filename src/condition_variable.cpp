@@ -11,7 +11,11 @@ namespace xjj {
      * @brief 构造函数
      */
     ConditionVariable::ConditionVariable() {
-        pthread_cond_init(&m_cond, nullptr);
+        pthread_condattr_t attr;
+        pthread_condattr_init(&attr);
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);  // 定时等待不受系统时间调整影响
+        pthread_cond_init(&m_cond, &attr);
+        pthread_condattr_destroy(&attr);
     }
 
     /*!
@@ -27,7 +31,14 @@ namespace xjj {
      * @return 成功与否
      */
     bool ConditionVariable::wait(Mutex* mutex_ptr) {
+#if _XJJ_MUTEX_PROFILING
+        mutex_ptr -> releaseForWait();
+        int ret = pthread_cond_wait(&m_cond, mutex_ptr -> getMutex());
+        mutex_ptr -> reacquireAfterWait();
+        return 0 == ret;
+#else
         return 0 == pthread_cond_wait(&m_cond, mutex_ptr -> getMutex());
+#endif
     }
 
     /*!
@@ -38,17 +49,81 @@ namespace xjj {
         return 0 == pthread_cond_signal(&m_cond);
     }
 
+    /*!
+     * @brief 条件为真，唤醒所有等候条件变量变为真的线程
+     * @return 成功与否
+     */
+    bool ConditionVariable::broadcast() {
+        return 0 == pthread_cond_broadcast(&m_cond);
+    }
+
     /*!
      * @brief 定时等待条件变量为真
      * @param [in] mutex_ptr 用于锁住条件变量的互斥量指针
      * @param [in] seconds 等候时间长度，以秒为单位
-     * @return 成功与否
+     * @return 成功与否（超时返回false）
      */
     bool ConditionVariable::timedWait(Mutex *mutex_ptr, long seconds) {
-        timespec now;
-        clock_gettime(CLOCK_REALTIME, &now);  // 获取当前绝对时间
-        now.tv_sec += seconds;  // 将当前时间加上等候的时间，作为等候条件变量变为真的时间
-        return 0 == pthread_cond_timedwait(&m_cond, mutex_ptr -> getMutex(), &now);
+        // 直接转换为纳秒会溢出
+        const long max_seconds = static_cast<long>(std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::nanoseconds::max()).count());
+        if (seconds >= max_seconds)
+            return timedWait(mutex_ptr, std::chrono::nanoseconds::max());
+        return timedWait(mutex_ptr, std::chrono::seconds(seconds));
+    }
+
+    /*!
+     * @brief 定时等待条件变量为真，精确到纳秒，
+     * 可直接传入std::chrono::microseconds、std::chrono::milliseconds等时长
+     * @param [in] mutex_ptr 用于锁住条件变量的互斥量指针
+     * @param [in] duration 等候时间长度
+     * @return 成功与否（超时返回false）
+     */
+    bool ConditionVariable::timedWait(Mutex *mutex_ptr, std::chrono::nanoseconds duration) {
+        return timedWaitUntil(mutex_ptr, deadlineAfter(duration));
+    }
+
+    /*!
+     * @brief 计算从现在起经过duration后的截止时间点，超出time_point表示范围时取最大值，
+     * 负的时长视为0
+     * @param [in] duration 时间长度，可为std::chrono::nanoseconds::max()表示一直等待
+     * @return 截止时间点
+     */
+    std::chrono::steady_clock::time_point ConditionVariable::deadlineAfter(std::chrono::nanoseconds duration) {
+        typedef std::chrono::steady_clock clock_type;
+        clock_type::time_point now = clock_type::now();
+        if (duration.count() <= 0)
+            return now;
+        // now + duration溢出时取最大值
+        auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                clock_type::time_point::max() - now);
+        if (duration >= remaining)
+            return clock_type::time_point::max();
+        return now + std::chrono::duration_cast<clock_type::duration>(duration);
+    }
+
+    /*!
+     * @brief 等待条件变量为真，直到绝对时间点
+     * @param [in] mutex_ptr 用于锁住条件变量的互斥量指针
+     * @param [in] deadline 截止时间点（steady_clock与CLOCK_MONOTONIC同源）
+     * @return 成功与否（超时返回false）
+     */
+    bool ConditionVariable::timedWaitUntil(Mutex* mutex_ptr, std::chrono::steady_clock::time_point deadline) {
+        const long nanoseconds_per_second = 1000000000L;
+        auto since_epoch = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch());
+        if (since_epoch.count() < 0)
+            since_epoch = std::chrono::nanoseconds::zero();
+        timespec abs_time{};
+        abs_time.tv_sec = static_cast<time_t>(since_epoch.count() / nanoseconds_per_second);
+        abs_time.tv_nsec = static_cast<long>(since_epoch.count() % nanoseconds_per_second);
+#if _XJJ_MUTEX_PROFILING
+        mutex_ptr -> releaseForWait();
+        int ret = pthread_cond_timedwait(&m_cond, mutex_ptr -> getMutex(), &abs_time);
+        mutex_ptr -> reacquireAfterWait();
+        return 0 == ret;
+#else
+        return 0 == pthread_cond_timedwait(&m_cond, mutex_ptr -> getMutex(), &abs_time);
+#endif
     }
 
-} // namespace xjj
\ No newline at end of file
+} // namespace xjj
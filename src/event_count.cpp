@@ -0,0 +1,119 @@
+//
+// created by agent on 2026-10-18
+//
+
+#include <cerrno>
+#include <climits>
+#include <ctime>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include "event_count.hpp"
+
+namespace xjj {
+
+    /*!
+     * @brief 构造函数
+     */
+    EventCount::EventCount()
+            : m_epoch(0), m_waiters(0) {}
+
+    /*!
+     * @brief 登记为等待者并获取等待凭据
+     * @return 等待凭据
+     */
+    EventCount::key_type EventCount::prepareWait() {
+        m_waiters.fetch_add(1);  // seq_cst，与doNotify中的读取配对
+        return m_epoch.load();
+    }
+
+    /*!
+     * @brief 条件已满足，取消等待登记
+     */
+    void EventCount::cancelWait() {
+        m_waiters.fetch_sub(1);
+    }
+
+    /*!
+     * @brief 等待通知，返回时已取消等待登记
+     * @param [in] key prepareWait返回的等待凭据
+     */
+    void EventCount::wait(key_type key) {
+        while (m_epoch.load() == key) {
+            futexWait(key, nullptr);
+        }
+        m_waiters.fetch_sub(1);
+    }
+
+    /*!
+     * @brief 定时等待通知，返回时已取消等待登记
+     * @param [in] key prepareWait返回的等待凭据
+     * @param [in] seconds 等候时间长度，以秒为单位
+     * @return 是否在超时前收到通知
+     */
+    bool EventCount::timedWait(key_type key, long seconds) {
+        return timedWait(key, std::chrono::seconds(seconds));
+    }
+
+    /*!
+     * @brief 定时等待通知，精确到纳秒，返回时已取消等待登记
+     * @param [in] key prepareWait返回的等待凭据
+     * @param [in] timeout 等候时间长度（futex以CLOCK_MONOTONIC计时）
+     * @return 是否在超时前收到通知
+     */
+    bool EventCount::timedWait(key_type key, std::chrono::nanoseconds timeout) {
+        const long nanoseconds_per_second = 1000000000L;
+        if (timeout.count() < 0)
+            timeout = std::chrono::nanoseconds::zero();
+        timespec relative{};
+        relative.tv_sec = static_cast<time_t>(timeout.count() / nanoseconds_per_second);
+        relative.tv_nsec = static_cast<long>(timeout.count() % nanoseconds_per_second);
+
+        bool notified = true;
+        if (m_epoch.load() == key)
+            notified = !futexWait(key, &relative) || m_epoch.load() != key;
+        m_waiters.fetch_sub(1);
+        return notified;
+    }
+
+    /*!
+     * @brief 唤醒一个等待者
+     */
+    void EventCount::notify() {
+        doNotify(1);
+    }
+
+    /*!
+     * @brief 唤醒所有等待者
+     */
+    void EventCount::notifyAll() {
+        doNotify(INT_MAX);
+    }
+
+    /*!
+     * @brief 若有等待者，推进事件序号并唤醒至多count个等待者
+     * @param [in] count 唤醒数目
+     */
+    void EventCount::doNotify(int count) {
+        // 通知方先使条件成立再读取等待者数目，等待方先登记再检查条件，二者至少一方能看到对方
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_waiters.load() > 0) {
+            m_epoch.fetch_add(1);
+            syscall(SYS_futex, reinterpret_cast<key_type*>(&m_epoch),
+                    FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+        }
+    }
+
+    /*!
+     * @brief 在事件序号仍等于key时进入futex等待
+     * @param [in] key 等待凭据
+     * @param [in] timeout 等候时间长度，为空表示不限时
+     * @return 是否因超时返回
+     */
+    bool EventCount::futexWait(key_type key, const timespec* timeout) {
+        long ret = syscall(SYS_futex, reinterpret_cast<key_type*>(&m_epoch),
+                           FUTEX_WAIT_PRIVATE, key, timeout, nullptr, 0);
+        return ret == -1 && errno == ETIMEDOUT;
+    }
+
+} // namespace xjj
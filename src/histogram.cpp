@@ -0,0 +1,122 @@
+//
+// created by agent on 2026-10-18
+//
+
+#include <algorithm>
+#include <limits>
+#include "histogram.hpp"
+
+namespace xjj {
+
+    /*!
+     * @brief 构造函数，构造空快照
+     */
+    Histogram::Snapshot::Snapshot()
+            : m_count(0), m_sum(0), m_max(0) {
+        std::fill(m_buckets, m_buckets + BucketNum, 0);
+    }
+
+    /*!
+     * @brief 合并另一快照
+     * @param [in] other 另一快照
+     */
+    void Histogram::Snapshot::merge(const Snapshot& other) {
+        for (size_t i = 0; i < BucketNum; i++)
+            m_buckets[i] += other.m_buckets[i];
+        m_count += other.m_count;
+        m_sum += other.m_sum;
+        m_max = std::max(m_max, other.m_max);
+    }
+
+    /*!
+     * @brief 获取平均值
+     * @return 平均值，没有记录时为0
+     */
+    double Histogram::Snapshot::mean() const {
+        return 0 == m_count ? 0.0 : static_cast<double>(m_sum) / m_count;
+    }
+
+    /*!
+     * @brief 获取分位数的近似值（所在桶的上界，且不超过最大值）
+     * @param [in] ratio 分位，取值[0, 1]，如0.99
+     * @return 分位数近似值
+     */
+    uint64_t Histogram::Snapshot::percentile(double ratio) const {
+        uint64_t total = 0;
+        for (size_t i = 0; i < BucketNum; i++)
+            total += m_buckets[i];
+        if (0 == total)
+            return 0;
+
+        ratio = std::min(std::max(ratio, 0.0), 1.0);
+        auto rank = static_cast<uint64_t>(ratio * total);
+        rank = std::max<uint64_t>(rank, 1);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BucketNum; i++) {
+            seen += m_buckets[i];
+            if (seen >= rank)
+                return std::min(bucketUpperBound(i), m_max);
+        }
+        return m_max;
+    }
+
+    /*!
+     * @brief 构造函数
+     */
+    Histogram::Histogram()
+            : m_count(0), m_sum(0), m_max(0) {
+        for (auto& bucket : m_buckets)
+            bucket.store(0, std::memory_order_relaxed);
+    }
+
+    /*!
+     * @brief 记录一个值
+     * @param [in] value 记录值
+     */
+    void Histogram::record(uint64_t value) {
+        m_buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        m_sum.fetch_add(value, std::memory_order_relaxed);
+        uint64_t current_max = m_max.load(std::memory_order_relaxed);
+        while (value > current_max &&
+               !m_max.compare_exchange_weak(current_max, value, std::memory_order_relaxed)) {}
+    }
+
+    /*!
+     * @brief 读取快照，与记录操作并发时各字段之间可能略有出入
+     * @return 快照
+     */
+    Histogram::Snapshot Histogram::snapshot() const {
+        Snapshot result;
+        for (size_t i = 0; i < BucketNum; i++)
+            result.m_buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+        result.m_count = m_count.load(std::memory_order_relaxed);
+        result.m_sum = m_sum.load(std::memory_order_relaxed);
+        result.m_max = m_max.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    /*!
+     * @brief 获取值所在的桶下标
+     * @param [in] value 值
+     * @return 桶下标
+     */
+    size_t Histogram::bucketIndex(uint64_t value) {
+        if (0 == value)
+            return 0;
+        auto index = static_cast<size_t>(64 - __builtin_clzll(value));  // 值的二进制位数
+        return std::min(index, BucketNum - 1);
+    }
+
+    /*!
+     * @brief 获取桶的上界（桶内值均小于该上界）
+     * @param [in] index 桶下标
+     * @return 上界
+     */
+    uint64_t Histogram::bucketUpperBound(size_t index) {
+        if (index >= BucketNum - 1)
+            return std::numeric_limits<uint64_t>::max();
+        return static_cast<uint64_t>(1) << index;
+    }
+
+} // namespace xjj
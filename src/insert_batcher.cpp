@@ -0,0 +1,224 @@
+//
+// created by agent on 2026-10-19
+//
+
+#include <algorithm>
+#include <memory>
+#include <mysql/errmsg.h>
+#include "insert_batcher.hpp"
+
+namespace xjj {
+
+    /// 默认的批次等待时长上限
+    constexpr std::chrono::microseconds InsertBatcher::DefaultMaxDelay;
+
+    /*!
+     * @brief 构造函数
+     * @param [in] pool 连接池指针
+     * @param [in] table 表名
+     * @param [in] columns 插入的列名
+     * @param [in] max_rows 一批的行数上限，默认为DefaultMaxRows；语句按行数缓存于连接中，
+     * 连接的预处理语句缓存容量应足以容纳各种行数
+     * @param [in] max_delay 最早的行等待凑批的时长上限，默认为DefaultMaxDelay
+     * @param [in] connection_timeout 获取连接的等待时长上限，默认为0，表示按连接池配置项db_pool_timeout_ms等待
+     */
+    InsertBatcher::InsertBatcher(MySQLConnectionPool* pool, const std::string& table,
+                                 const std::vector<std::string>& columns, size_t max_rows,
+                                 std::chrono::microseconds max_delay, std::chrono::nanoseconds connection_timeout)
+            : m_pool(pool),
+              m_column_num(static_cast<uint32_t>(columns.size())),
+              m_max_rows(std::max<size_t>(max_rows, 1)),
+              m_max_delay(max_delay),
+              m_connection_timeout(connection_timeout),
+              m_mutex("InsertBatcher::m_mutex", true),  // 临界区只有出入队，先自旋再睡眠
+              m_has_leader(false),
+              m_batch_num(0),
+              m_row_num(0),
+              m_retried_batch_num(0) {
+        // 预先生成插入max_rows行的语句，插入n行的语句取其前缀
+        m_sql_text = "INSERT INTO " + table + "(";
+        std::string row = "(";
+        for (size_t i = 0; i < columns.size(); i++) {
+            if (i > 0) {
+                m_sql_text.append(", ");
+                row.append(", ");
+            }
+            m_sql_text.append(columns[i]);
+            row.append("?");
+        }
+        m_sql_text.append(") VALUES ");
+        row.append(")");
+        m_header_length = m_sql_text.length();
+        m_row_length = row.length();
+
+        m_sql_text.reserve(m_header_length + m_max_rows * (m_row_length + 2));
+        for (size_t i = 0; i < m_max_rows; i++) {
+            if (i > 0)
+                m_sql_text.append(", ");
+            m_sql_text.append(row);
+        }
+    }
+
+    /*!
+     * @brief 插入一行，阻塞至该行所在的批次执行完毕；该行插入失败时抛出该行的异常（SQLException等）
+     * @param [in] binder 为该行设置参数的函数对象
+     */
+    void InsertBatcher::insert(const Binder& binder) {
+        Waiter waiter;
+        waiter.m_binder = &binder;
+        waiter.m_state = Waiter::State::Queued;
+        waiter.m_enqueue_time = std::chrono::steady_clock::now();
+
+        std::vector<Waiter*> batch;
+        bool queued = false;
+        while (true) {
+            {
+                AutoLockMutex lock(&m_mutex);
+                if (!queued) {
+                    m_queue.push_back(&waiter);
+                    queued = true;
+                    if (m_has_leader && m_queue.size() >= m_max_rows)  // 凑满一批，领导者无需再等
+                        m_leader_cond.signal();
+                } else {
+                    // 作为领导者执行完一批：交还结果，仍持有互斥量，等待者被唤醒前不会离开
+                    for (Waiter* member : batch) {
+                        member -> m_state = Waiter::State::Done;
+                        member -> m_cond.signal();
+                    }
+                    batch.clear();
+                }
+
+                // 等待本行执行完毕，或没有领导者时自己成为领导者
+                waiter.m_cond.wait(&m_mutex, [this, &waiter] () {
+                    return Waiter::State::Done == waiter.m_state ||
+                           (Waiter::State::Queued == waiter.m_state && !m_has_leader);
+                });
+                if (Waiter::State::Done == waiter.m_state)
+                    break;
+                collectBatchLocked(batch);
+            }
+            // 本行可能不在取出的批次中（队列中更早的行多于一批），执行后继续等待或再次领导
+            executeBatch(batch);
+        }
+
+        if (waiter.m_error)
+            std::rethrow_exception(waiter.m_error);
+    }
+
+    /*!
+     * @brief 获取已执行的批次数
+     * @return 批次数
+     */
+    uint64_t InsertBatcher::getBatchNum() const {
+        return m_batch_num.load(std::memory_order_relaxed);
+    }
+
+    /*!
+     * @brief 获取已插入的行数（含失败的行）
+     * @return 行数
+     */
+    uint64_t InsertBatcher::getRowNum() const {
+        return m_row_num.load(std::memory_order_relaxed);
+    }
+
+    /*!
+     * @brief 获取整批失败而逐行重试的批次数
+     * @return 批次数
+     */
+    uint64_t InsertBatcher::getRetriedBatchNum() const {
+        return m_retried_batch_num.load(std::memory_order_relaxed);
+    }
+
+    /*!
+     * @brief 获取插入若干行的语句
+     * @param [in] row_num 行数
+     * @return sql语句
+     */
+    std::string InsertBatcher::sqlText(size_t row_num) const {
+        return m_sql_text.substr(0, m_header_length + row_num * m_row_length + (row_num - 1) * 2);
+    }
+
+    /*!
+     * @brief 作为领导者等待批次凑满或超时，取出一批并让出领导者身份；调用时须持有互斥量
+     * @param [out] batch 取出的行
+     */
+    void InsertBatcher::collectBatchLocked(std::vector<Waiter*>& batch) {
+        m_has_leader = true;
+        m_leader_cond.timedWaitUntil(&m_mutex, m_queue.front() -> m_enqueue_time + m_max_delay, [this] () {
+            return m_queue.size() >= m_max_rows;
+        });
+
+        size_t row_num = std::min(m_queue.size(), m_max_rows);
+        batch.assign(m_queue.begin(), m_queue.begin() + row_num);
+        m_queue.erase(m_queue.begin(), m_queue.begin() + row_num);
+        for (Waiter* member : batch)
+            member -> m_state = Waiter::State::Taken;
+        m_batch_num.fetch_add(1, std::memory_order_relaxed);
+        m_row_num.fetch_add(row_num, std::memory_order_relaxed);
+
+        // 让出领导者身份，由最早的等待者收集下一批，与本批的执行重叠
+        m_has_leader = false;
+        if (!m_queue.empty())
+            m_queue.front() -> m_cond.signal();
+    }
+
+    /*!
+     * @brief 执行一批，将各行的异常记录在其等待者中；不持有互斥量
+     * @param [in] batch 待执行的行
+     */
+    void InsertBatcher::executeBatch(const std::vector<Waiter*>& batch) {
+        try {
+            ConnectionLease conn = m_connection_timeout.count() > 0 ?
+                                   m_pool -> getConnection(m_connection_timeout) :
+                                   ConnectionLease(m_pool, m_pool -> getConnection());
+            try {
+                std::shared_ptr<sql::PreparedStatement> stmt(conn -> prepareStatement(sqlText(batch.size())));
+                for (size_t i = 0; i < batch.size(); i++)
+                    (*batch[i] -> m_binder)(*stmt, static_cast<uint32_t>(i) * m_column_num + 1);
+                stmt -> executeUpdate();
+                return;
+            } catch (sql::SQLException& e) {
+                if (1 == batch.size() || !isStatementError(e))
+                    throw;
+            } catch (...) {  // 参数设置函数抛出的异常只与该行有关
+                if (1 == batch.size())
+                    throw;
+            }
+
+            // 整批因语句错误失败（已整体回滚）：逐行重新执行，找出失败的行，其余行照常插入
+            m_retried_batch_num.fetch_add(1, std::memory_order_relaxed);
+            std::shared_ptr<sql::PreparedStatement> stmt(conn -> prepareStatement(sqlText(1)));
+            for (size_t i = 0; i < batch.size(); i++) {
+                try {
+                    stmt -> clearParameters();
+                    (*batch[i] -> m_binder)(*stmt, 1);
+                    stmt -> executeUpdate();
+                } catch (sql::SQLException& e) {
+                    if (isStatementError(e)) {
+                        batch[i] -> m_error = std::current_exception();
+                        continue;
+                    }
+                    for (size_t j = i; j < batch.size(); j++)  // 连接已不可用，其余行均失败
+                        batch[j] -> m_error = std::current_exception();
+                    return;
+                } catch (...) {
+                    batch[i] -> m_error = std::current_exception();
+                }
+            }
+        } catch (...) {  // 未得到连接、连接断开等，整批均失败
+            for (Waiter* member : batch)
+                member -> m_error = std::current_exception();
+        }
+    }
+
+    /*!
+     * @brief 判断异常是否只与语句本身有关（如重复键、数据错误），逐行重试可以找出失败的行；
+     * 连接断开等客户端错误（CR_*）时逐行重试同样会失败
+     * @param [in] e sql异常
+     * @return 是否为语句错误
+     */
+    bool InsertBatcher::isStatementError(sql::SQLException& e) {
+        unsigned int error_code = e.getErrorCode();
+        return error_code < CR_MIN_ERROR || error_code > CR_MAX_ERROR;
+    }
+}
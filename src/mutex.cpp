@@ -2,14 +2,72 @@
 // created by xujijun on 2018-03-19
 //
 
+#include <algorithm>
+#include <chrono>
+#include <thread>
 #include <mutex.hpp>
 
 namespace xjj {
 
+    /// 自适应模式下自旋尝试次数上限
+    const int Mutex::MaxSpinNum;
+
+    /// 自适应模式下两次尝试之间的最大退避（pause指令数）
+    const int Mutex::MaxBackoff;
+
+    /*!
+     * @brief 是否为多核机器，单核机器上自旋等待没有意义，设为static以限制只能在本文件内使用
+     */
+    static const bool s_multi_core = std::thread::hardware_concurrency() > 1;
+
+    /*!
+     * @brief 自旋等待时提示CPU降低功耗、让出流水线给同核的其它超线程，设为static以限制只能在本文件内使用
+     */
+    static inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield" ::: "memory");
+#else
+        asm volatile("" ::: "memory");
+#endif
+    }
+
+#if _XJJ_MUTEX_PROFILING
+    /*!
+     * @brief 获取竞争分析使用的单调时间，设为static以限制只能在本文件内使用
+     * @return 时间（纳秒）
+     */
+    static inline uint64_t profilingNow() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+#endif
+
     /*!
      * @brief 构造函数
+     * @param [in] adaptive 是否使用自适应（先自旋后睡眠）模式，默认为否
      */
-    Mutex::Mutex() {
+    Mutex::Mutex(bool adaptive)
+            : Mutex(nullptr, adaptive) {}
+
+    /*!
+     * @brief 构造函数，竞争分析模式下按名称统计，同名互斥量的统计合并
+     * @param [in] name 互斥量名称，为空时不统计
+     * @param [in] adaptive 是否使用自适应（先自旋后睡眠）模式，默认为否
+     */
+    Mutex::Mutex(const char* name, bool adaptive)
+            : m_adaptive(adaptive && s_multi_core),
+              m_spin_estimate(0)
+#if _XJJ_MUTEX_PROFILING
+              , m_profile(name ? MutexProfiler::getProfile(name) : nullptr),
+              m_locked_at(0),
+              m_hold_tick(0)
+#endif
+    {
+#if !_XJJ_MUTEX_PROFILING
+        (void) name;
+#endif
         pthread_mutex_init(&m_mutex, nullptr);
     }
 
@@ -25,7 +83,27 @@ namespace xjj {
      * @return 成功与否
      */
     bool Mutex::lock() {
-        return 0 == pthread_mutex_lock(&m_mutex);
+#if _XJJ_MUTEX_PROFILING
+        return lockFrom(__builtin_return_address(0));
+#else
+        return acquire();
+#endif
+    }
+
+    /*!
+     * @brief 尝试互斥量加锁，不阻塞
+     * @return 是否加锁成功
+     */
+    bool Mutex::tryLock() {
+        if (0 != pthread_mutex_trylock(&m_mutex))
+            return false;
+#if _XJJ_MUTEX_PROFILING
+        if (m_profile) {
+            beginHold(0);
+            m_profile -> recordAcquire(0, __builtin_return_address(0));
+        }
+#endif
+        return true;
     }
 
     /*!
@@ -33,9 +111,85 @@ namespace xjj {
      * @return 成功与否
      */
     bool Mutex::unlock() {
+#if _XJJ_MUTEX_PROFILING
+        if (m_profile)
+            endHold();
+#endif
         return 0 == pthread_mutex_unlock(&m_mutex);
     }
 
+    /*!
+     * @brief 加锁（自适应模式下先自旋），不做统计
+     * @return 成功与否
+     */
+    bool Mutex::acquire() {
+        if (m_adaptive && spinLock())
+            return true;
+        return 0 == pthread_mutex_lock(&m_mutex);
+    }
+
+#if _XJJ_MUTEX_PROFILING
+    /*!
+     * @brief 加锁并统计
+     * @param [in] caller 调用加锁的代码地址
+     * @return 成功与否
+     */
+    bool Mutex::lockFrom(const void* caller) {
+        if (!m_profile)
+            return acquire();
+
+        uint64_t wait_ns = 0;
+        if (0 == pthread_mutex_trylock(&m_mutex)) {  // 未发生竞争，通常不读时钟
+            beginHold(0);
+        } else {
+            uint64_t wait_start = profilingNow();
+            if (!acquire())
+                return false;
+            uint64_t acquired = profilingNow();
+            wait_ns = std::max<uint64_t>(acquired - wait_start, 1);  // 0表示未发生竞争
+            beginHold(acquired);
+        }
+        m_profile -> recordAcquire(wait_ns, caller);
+        return true;
+    }
+
+    /*!
+     * @brief 开始一次持有，按抽样率决定是否计时
+     * @param [in] now 当前时间（纳秒），为0时需要计时则读取时钟
+     */
+    void Mutex::beginHold(uint64_t now) {
+        if (0 == ++m_hold_tick % MutexProfile::HoldSampleRate)
+            m_locked_at = now ? now : profilingNow();
+        else
+            m_locked_at = 0;
+    }
+
+    /*!
+     * @brief 结束一次持有，若本次持有被抽中则计入统计
+     */
+    void Mutex::endHold() {
+        if (m_locked_at)
+            m_profile -> recordHold(profilingNow() - m_locked_at);
+    }
+
+    /*!
+     * @brief 条件变量等待前调用：等待期间互斥量被释放，结束本次持有的计时
+     */
+    void Mutex::releaseForWait() {
+        if (m_profile)
+            endHold();
+    }
+
+    /*!
+     * @brief 条件变量等待返回后调用：互斥量已重新持有，开始计时
+     * 重新加锁发生在pthread_cond_wait内部，其等待时长无法测得，不计入统计
+     */
+    void Mutex::reacquireAfterWait() {
+        if (m_profile)
+            beginHold(0);
+    }
+#endif
+
     /*!
      * @brief 获取底层互斥量id的指针
      * @return 底层互斥量id的指针
@@ -44,6 +198,88 @@ namespace xjj {
         return &m_mutex;
     }
 
+    /*!
+     * @brief 自适应模式下自旋尝试加锁
+     * @return 是否加锁成功
+     */
+    bool Mutex::spinLock() {
+        // 估计值按1/8的权重向实际所需次数靠拢（与glibc的PTHREAD_MUTEX_ADAPTIVE_NP相同）
+        int estimate = m_spin_estimate.load(std::memory_order_relaxed);
+        int spin_limit = std::min(MaxSpinNum, estimate * 2 + 10);
+        int backoff = 1;
+        for (int spin = 0; spin < spin_limit; spin++) {
+            if (0 == pthread_mutex_trylock(&m_mutex)) {
+                m_spin_estimate.store(estimate + (spin - estimate) / 8, std::memory_order_relaxed);
+                return true;
+            }
+            for (int i = 0; i < backoff; i++)
+                cpuRelax();
+            if (backoff < MaxBackoff)
+                backoff <<= 1;
+        }
+        m_spin_estimate.store(estimate + (spin_limit - estimate) / 8, std::memory_order_relaxed);
+        return false;
+    }
+
+    /*!
+     * @brief 构造函数
+     */
+    RWMutex::RWMutex() {
+        pthread_rwlockattr_t attr;
+        pthread_rwlockattr_init(&attr);
+        // glibc默认读者优先，持续的读者会使写者饿死
+        pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+        pthread_rwlock_init(&m_rwlock, &attr);
+        pthread_rwlockattr_destroy(&attr);
+    }
+
+    /*!
+     * @brief 析构函数
+     */
+    RWMutex::~RWMutex() {
+        pthread_rwlock_destroy(&m_rwlock);
+    }
+
+    /*!
+     * @brief 加读锁
+     * @return 成功与否
+     */
+    bool RWMutex::readLock() {
+        return 0 == pthread_rwlock_rdlock(&m_rwlock);
+    }
+
+    /*!
+     * @brief 加写锁
+     * @return 成功与否
+     */
+    bool RWMutex::writeLock() {
+        return 0 == pthread_rwlock_wrlock(&m_rwlock);
+    }
+
+    /*!
+     * @brief 尝试加读锁，不阻塞
+     * @return 是否加锁成功
+     */
+    bool RWMutex::tryReadLock() {
+        return 0 == pthread_rwlock_tryrdlock(&m_rwlock);
+    }
+
+    /*!
+     * @brief 尝试加写锁，不阻塞
+     * @return 是否加锁成功
+     */
+    bool RWMutex::tryWriteLock() {
+        return 0 == pthread_rwlock_trywrlock(&m_rwlock);
+    }
+
+    /*!
+     * @brief 解锁（读锁或写锁）
+     * @return 成功与否
+     */
+    bool RWMutex::unlock() {
+        return 0 == pthread_rwlock_unlock(&m_rwlock);
+    }
+
 
     /*!
      * @brief 构造函数
@@ -51,7 +287,11 @@ namespace xjj {
      */
     AutoLockMutex::AutoLockMutex(Mutex* mutex_ptr)
         : m_mutex_ptr(mutex_ptr) {
+#if _XJJ_MUTEX_PROFILING
+        m_mutex_ptr -> lockFrom(__builtin_return_address(0));  // 统计AutoLockMutex使用者的调用位置
+#else
         m_mutex_ptr -> lock();  // 构造时自动上锁
+#endif
     }
 
     /*!
@@ -61,4 +301,38 @@ namespace xjj {
         m_mutex_ptr -> unlock();  // 析构时自动解锁
     }
 
+
+    /*!
+     * @brief 构造函数
+     * @param [in] rwmutex_ptr 读写锁指针
+     */
+    AutoReadLock::AutoReadLock(RWMutex* rwmutex_ptr)
+            : m_rwmutex_ptr(rwmutex_ptr) {
+        m_rwmutex_ptr -> readLock();  // 构造时自动加读锁
+    }
+
+    /*!
+     * @brief 析构函数
+     */
+    AutoReadLock::~AutoReadLock() {
+        m_rwmutex_ptr -> unlock();  // 析构时自动解锁
+    }
+
+
+    /*!
+     * @brief 构造函数
+     * @param [in] rwmutex_ptr 读写锁指针
+     */
+    AutoWriteLock::AutoWriteLock(RWMutex* rwmutex_ptr)
+            : m_rwmutex_ptr(rwmutex_ptr) {
+        m_rwmutex_ptr -> writeLock();  // 构造时自动加写锁
+    }
+
+    /*!
+     * @brief 析构函数
+     */
+    AutoWriteLock::~AutoWriteLock() {
+        m_rwmutex_ptr -> unlock();  // 析构时自动解锁
+    }
+
 } // namespace xjj
\ No newline at end of file
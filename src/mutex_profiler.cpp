@@ -0,0 +1,204 @@
+//
+// created by agent on 2026-10-18
+//
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <execinfo.h>
+#include <pthread.h>
+#include "mutex_profiler.hpp"
+
+namespace xjj {
+
+    /*!
+     * @brief 保护统计列表的互斥量，静态初始化，设为static以限制只能在本文件内使用
+     * 不能使用xjj::Mutex：Mutex的构造会调用本文件中的函数
+     */
+    static pthread_mutex_t s_profiles_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+    /// 记录的最长等待次数
+    const size_t MutexProfile::TopWaitNum;
+
+    /// 持有时长的抽样率
+    const uint32_t MutexProfile::HoldSampleRate;
+
+    /*!
+     * @brief 构造函数
+     * @param [in] name 互斥量名称
+     */
+    MutexProfile::MutexProfile(const std::string& name)
+            : m_name(name) {
+        m_top_lock.clear();
+        reset();
+    }
+
+    /*!
+     * @brief 记录一次加锁
+     * @param [in] wait_ns 等待时长（纳秒），为0表示未发生竞争
+     * @param [in] caller 调用加锁的代码地址
+     */
+    void MutexProfile::recordAcquire(uint64_t wait_ns, const void* caller) {
+        m_acquisitions.fetch_add(1, std::memory_order_relaxed);
+        if (0 == wait_ns)
+            return;
+
+        m_contended.fetch_add(1, std::memory_order_relaxed);
+        m_wait_ns.fetch_add(wait_ns, std::memory_order_relaxed);
+        uint64_t max_wait = m_max_wait_ns.load(std::memory_order_relaxed);
+        while (wait_ns > max_wait &&
+                !m_max_wait_ns.compare_exchange_weak(max_wait, wait_ns, std::memory_order_relaxed)) {}
+
+        if (wait_ns <= m_top_min_ns.load(std::memory_order_relaxed))
+            return;  // 绝大多数等待在此返回，不触碰自旋锁
+        while (m_top_lock.test_and_set(std::memory_order_acquire)) {}
+        CallSite* shortest = std::min_element(m_top_waits, m_top_waits + TopWaitNum,
+                [](const CallSite& a, const CallSite& b) { return a.m_wait_ns < b.m_wait_ns; });
+        if (wait_ns > shortest -> m_wait_ns) {
+            shortest -> m_caller = caller;
+            shortest -> m_wait_ns = wait_ns;
+            shortest = std::min_element(m_top_waits, m_top_waits + TopWaitNum,
+                    [](const CallSite& a, const CallSite& b) { return a.m_wait_ns < b.m_wait_ns; });
+            m_top_min_ns.store(shortest -> m_wait_ns, std::memory_order_relaxed);
+        }
+        m_top_lock.clear(std::memory_order_release);
+    }
+
+    /*!
+     * @brief 记录一次抽样的持有，按抽样率放大计入
+     * @param [in] hold_ns 持有时长（纳秒）
+     */
+    void MutexProfile::recordHold(uint64_t hold_ns) {
+        m_hold_ns.fetch_add(hold_ns * HoldSampleRate, std::memory_order_relaxed);
+    }
+
+    /*!
+     * @brief 清零统计
+     */
+    void MutexProfile::reset() {
+        m_acquisitions.store(0);
+        m_contended.store(0);
+        m_wait_ns.store(0);
+        m_max_wait_ns.store(0);
+        m_hold_ns.store(0);
+        while (m_top_lock.test_and_set(std::memory_order_acquire)) {}
+        for (auto& call_site : m_top_waits) {
+            call_site.m_caller = nullptr;
+            call_site.m_wait_ns = 0;
+        }
+        m_top_min_ns.store(0);
+        m_top_lock.clear(std::memory_order_release);
+    }
+
+    /*!
+     * @brief 获取名称对应的统计，不存在时创建
+     * @param [in] name 互斥量名称
+     * @return 统计指针，进程结束前有效
+     */
+    MutexProfile* MutexProfiler::getProfile(const char* name) {
+        pthread_mutex_lock(&s_profiles_mutex);
+        std::vector<MutexProfile*>& all = profiles();
+        auto it = std::find_if(all.begin(), all.end(),
+                               [name](const MutexProfile* profile) { return profile -> m_name == name; });
+        MutexProfile* profile = nullptr;
+        if (it != all.end()) {
+            profile = *it;
+        } else {
+            profile = new MutexProfile(name);  // 互斥量可能在静态析构阶段仍被使用，故不释放
+            all.push_back(profile);
+        }
+        pthread_mutex_unlock(&s_profiles_mutex);
+        return profile;
+    }
+
+    /*!
+     * @brief 获取所有统计的快照，按累计等待时长降序
+     * @return 快照列表
+     */
+    std::vector<MutexProfiler::Report> MutexProfiler::snapshot() {
+        std::vector<Report> reports;
+        pthread_mutex_lock(&s_profiles_mutex);
+        for (MutexProfile* profile : profiles()) {
+            Report report;
+            report.m_name = profile -> m_name;
+            report.m_acquisitions = profile -> m_acquisitions.load(std::memory_order_relaxed);
+            report.m_contended = profile -> m_contended.load(std::memory_order_relaxed);
+            report.m_wait_ns = profile -> m_wait_ns.load(std::memory_order_relaxed);
+            report.m_max_wait_ns = profile -> m_max_wait_ns.load(std::memory_order_relaxed);
+            report.m_hold_ns = profile -> m_hold_ns.load(std::memory_order_relaxed);
+
+            while (profile -> m_top_lock.test_and_set(std::memory_order_acquire)) {}
+            for (const auto& call_site : profile -> m_top_waits) {
+                if (call_site.m_wait_ns > 0)
+                    report.m_top_waits.push_back(call_site);
+            }
+            profile -> m_top_lock.clear(std::memory_order_release);
+            std::sort(report.m_top_waits.begin(), report.m_top_waits.end(),
+                      [](const MutexProfile::CallSite& a, const MutexProfile::CallSite& b) {
+                          return a.m_wait_ns > b.m_wait_ns;
+                      });
+
+            reports.push_back(std::move(report));
+        }
+        pthread_mutex_unlock(&s_profiles_mutex);
+
+        std::sort(reports.begin(), reports.end(), [](const Report& a, const Report& b) {
+            return a.m_wait_ns > b.m_wait_ns;
+        });
+        return reports;
+    }
+
+    /*!
+     * @brief 生成可读的竞争报告，最长等待的调用位置以符号形式给出
+     * @return 报告文本
+     */
+    std::string MutexProfiler::report() {
+        std::vector<Report> reports = snapshot();
+        if (reports.empty())
+            return "no profiled mutex (build with _XJJ_MUTEX_PROFILING=1 and name the mutexes)\n";
+
+        std::string text;
+        char line[256];
+        snprintf(line, sizeof(line), "%-32s %14s %12s %12s %14s %12s\n",
+                 "mutex", "acquisitions", "contended", "wait(ms)", "max wait(us)", "hold(ms)");
+        text.append(line);
+        for (const Report& report : reports) {
+            snprintf(line, sizeof(line), "%-32s %14llu %12llu %12.3f %14.3f %12.3f\n",
+                     report.m_name.c_str(),
+                     static_cast<unsigned long long>(report.m_acquisitions),
+                     static_cast<unsigned long long>(report.m_contended),
+                     report.m_wait_ns / 1e6, report.m_max_wait_ns / 1e3, report.m_hold_ns / 1e6);
+            text.append(line);
+
+            for (const auto& call_site : report.m_top_waits) {
+                void* address = const_cast<void*>(call_site.m_caller);
+                char** symbols = backtrace_symbols(&address, 1);
+                snprintf(line, sizeof(line), "    %12.3f us at %s\n",
+                         call_site.m_wait_ns / 1e3, symbols ? symbols[0] : "?");
+                free(symbols);
+                text.append(line);
+            }
+        }
+        return text;
+    }
+
+    /*!
+     * @brief 清零所有统计
+     */
+    void MutexProfiler::reset() {
+        pthread_mutex_lock(&s_profiles_mutex);
+        for (MutexProfile* profile : profiles())
+            profile -> reset();
+        pthread_mutex_unlock(&s_profiles_mutex);
+    }
+
+    /*!
+     * @brief 获取全部统计，函数内静态对象避免静态初始化顺序问题
+     * @return 统计列表
+     */
+    std::vector<MutexProfile*>& MutexProfiler::profiles() {
+        static std::vector<MutexProfile*>* all = new std::vector<MutexProfile*>();  // 不析构，理由同getProfile
+        return *all;
+    }
+
+} // namespace xjj
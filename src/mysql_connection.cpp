@@ -2,7 +2,13 @@
 // created by xujijun on 2018-03-25
 //
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <poll.h>
+#include <mysql/errmsg.h>
 #include "mysql_connection.hpp"
 
 namespace xjj {
@@ -40,6 +46,27 @@ namespace sql {
         return res;
     }
 
+    /*!
+     * @brief 生成异常
+     * @param [in] stmt 预处理语句句柄
+     * @param [in] caller_func 调用函数名
+     * @param [in] error_operation 出现错误的操作
+     * @return 所生成的异常
+     */
+    SQLException SQLException::generateException(
+            MYSQL_STMT *stmt,
+            const std::string& caller_func,
+            const std::string& error_operation
+    ) {
+        std::string msg(mysql_stmt_error(stmt));
+        msg.append(" (in function ");
+        msg.append(caller_func);
+        msg.append(" when ");
+        msg.append(error_operation);
+        msg.append(")");
+        return SQLException(msg, mysql_stmt_errno(stmt));
+    }
+
     /*!
      * @brief 获取错误编号
      * @return 错误编号
@@ -48,13 +75,160 @@ namespace sql {
         return m_error_code;
     }
 
+    /*!
+     * @brief 由绝对值与符号得到整数，设为static以限制只能在本文件内使用
+     * @param [in] magnitude 绝对值，不超过对应符号的取值范围
+     * @param [in] negative 是否为负
+     * @return 整数
+     */
+    static int64_t applySign(uint64_t magnitude, bool negative) {
+        if (!negative || 0 == magnitude)
+            return static_cast<int64_t>(magnitude);
+        return -static_cast<int64_t>(magnitude - 1) - 1;  // 绝对值可能为2^63，不能直接取负
+    }
+
+    /*!
+     * @brief 解析十进制整数，设为static以限制只能在本文件内使用
+     * @param [in] begin 文本起始
+     * @param [in] end 文本末尾
+     * @param [out] value 解析结果
+     * @return 是否为合法且不溢出的整数
+     */
+    static bool parseInt64(const char* begin, const char* end, int64_t& value) {
+        bool negative = false;
+        if (begin < end && ('-' == *begin || '+' == *begin))
+            negative = '-' == *begin++;
+        if (begin == end)
+            return false;
+
+        // 以无符号数累加绝对值，负数的绝对值上限比正数大1
+        const uint64_t limit = static_cast<uint64_t>(INT64_MAX) + (negative ? 1 : 0);
+        uint64_t magnitude = 0;
+        for (; begin < end; ++begin) {
+            unsigned int digit = static_cast<unsigned char>(*begin) - '0';
+            if (digit > 9 || magnitude > (limit - digit) / 10)
+                return false;
+            magnitude = magnitude * 10 + digit;
+        }
+        value = applySign(magnitude, negative);
+        return true;
+    }
+
+    /*!
+     * @brief 将DECIMAL文本解析为定点数，设为static以限制只能在本文件内使用
+     * @param [in] begin 文本起始
+     * @param [in] end 文本末尾
+     * @param [in] scale 结果的小数位数，多出的小数位被截断
+     * @param [out] value 文本值乘以10的scale次方
+     * @return 是否为合法且不溢出的定点数
+     */
+    static bool parseDecimal(const char* begin, const char* end, unsigned int scale, int64_t& value) {
+        bool negative = false;
+        if (begin < end && ('-' == *begin || '+' == *begin))
+            negative = '-' == *begin++;
+
+        const uint64_t limit = static_cast<uint64_t>(INT64_MAX) + (negative ? 1 : 0);
+        uint64_t magnitude = 0;
+        bool has_digit = false;
+        bool in_fraction = false;
+        unsigned int fraction_num = 0;
+        for (; begin < end; ++begin) {
+            if ('.' == *begin && !in_fraction) {
+                in_fraction = true;
+                continue;
+            }
+            unsigned int digit = static_cast<unsigned char>(*begin) - '0';
+            if (digit > 9)
+                return false;
+            has_digit = true;
+            if (in_fraction && fraction_num++ >= scale)
+                continue;  // 截断多出的小数位，但仍检查格式
+            if (magnitude > (limit - digit) / 10)
+                return false;
+            magnitude = magnitude * 10 + digit;
+        }
+        if (!has_digit)
+            return false;
+        for (; fraction_num < scale; fraction_num++) {
+            if (magnitude > limit / 10)
+                return false;
+            magnitude *= 10;
+        }
+        value = applySign(magnitude, negative);
+        return true;
+    }
+
+    /*!
+     * @brief 解析定长的十进制数字，设为static以限制只能在本文件内使用
+     * @param [in] text 文本起始
+     * @param [in] length 数字个数
+     * @param [out] value 解析结果
+     * @return 是否全为数字
+     */
+    static bool parseDigits(const char* text, int length, int& value) {
+        value = 0;
+        for (int i = 0; i < length; i++) {
+            unsigned int digit = static_cast<unsigned char>(text[i]) - '0';
+            if (digit > 9)
+                return false;
+            value = value * 10 + static_cast<int>(digit);
+        }
+        return true;
+    }
+
+    /*!
+     * @brief 解析"YYYY-MM-DD[ HH:MM:SS[.ffffff]]"格式的日期时间，设为static以限制只能在本文件内使用
+     * @param [in] text 文本起始
+     * @param [in] length 文本长度
+     * @param [out] value 解析结果
+     * @return 格式是否正确
+     */
+    static bool parseDateTime(const char* text, size_t length, DateTime& value) {
+        value = DateTime();
+        if (length < 10 || '-' != text[4] || '-' != text[7] ||
+                !parseDigits(text, 4, value.m_year) ||
+                !parseDigits(text + 5, 2, value.m_month) ||
+                !parseDigits(text + 8, 2, value.m_day))
+            return false;
+        if (10 == length)
+            return true;  // DATE列
+
+        if (length < 19 || (' ' != text[10] && 'T' != text[10]) || ':' != text[13] || ':' != text[16] ||
+                !parseDigits(text + 11, 2, value.m_hour) ||
+                !parseDigits(text + 14, 2, value.m_minute) ||
+                !parseDigits(text + 17, 2, value.m_second))
+            return false;
+        if (19 == length)
+            return true;
+
+        // 小数秒为1至6位，按位数补足为微秒
+        int fraction_length = static_cast<int>(length) - 20;
+        if ('.' != text[19] || fraction_length < 1 || fraction_length > 6 ||
+                !parseDigits(text + 20, fraction_length, value.m_microsecond))
+            return false;
+        for (int i = fraction_length; i < 6; i++)
+            value.m_microsecond *= 10;
+        return true;
+    }
+
+    /*!
+     * @brief 构造函数
+     * @param [in] mysql 连接句柄
+     * @param [in] mode 结果集取回方式
+     */
+    ResultSet::ResultSet(MYSQL *mysql, ResultMode mode)
+            : ResultSet(mysql, ResultMode::Streaming == mode ? mysql_use_result(mysql) : mysql_store_result(mysql),
+                        mode) {}
+
     /*!
      * @brief 构造函数
      * @param [in] mysql 连接句柄
+     * @param [in] result 已取回的底层结果集对象指针，语句未返回数据或出错时为空
+     * @param [in] mode 结果集取回方式
      */
-    ResultSet::ResultSet(MYSQL *mysql)
-            : m_mysql(mysql), m_row_num(0) {
-        m_result = mysql_store_result(m_mysql);
+    ResultSet::ResultSet(MYSQL *mysql, MYSQL_RES *result, ResultMode mode)
+            : m_row_num(0), m_affect_row_num(0), m_mysql(mysql), m_result(result),
+              m_row(nullptr), m_lengths(nullptr), m_mode(mode) {
         if (!m_result) {
             if (mysql_field_count(m_mysql) == 0) {
                 // sql执行未返回数据，不是SELECT操作
@@ -64,31 +238,118 @@ namespace sql {
                 throw SQLException::generateException(
                         m_mysql, "xjj::ResultSet::ResultSet", "getting result");
             }
+            return;
         }
+
+        // 建立列名索引，按列名取值时不再逐个比较字段名；同名的列取第一个
+        unsigned int column_num = mysql_num_fields(m_result);
+        MYSQL_FIELD *fields = mysql_fetch_fields(m_result);
+        m_column_index.reserve(column_num);
+        for (unsigned int i = 0; i < column_num; i++)
+            m_column_index.emplace(fields[i].name, i + 1);
     }
 
+    /*!
+     * @brief 构造函数：读取物化结果，多个结果集可共享同一物化结果，各自维护光标
+     * @param [in] result 物化结果
+     */
+    ResultSet::ResultSet(std::shared_ptr<const MaterializedResult> result)
+            : m_row_num(0), m_affect_row_num(0), m_mysql(nullptr), m_result(nullptr),
+              m_row(nullptr), m_lengths(nullptr), m_mode(ResultMode::Buffered),
+              m_materialized(std::move(result)) {}
+
     /*!
      * @brief 将结果光标移动到下一行
      * @return
      */
     bool ResultSet::next() {
+        if (m_materialized) {
+            if (static_cast<size_t>(m_row_num) >= m_materialized -> m_row_num)
+                return false;
+            size_t offset = static_cast<size_t>(m_row_num) * m_materialized -> m_column_num;
+            m_row = m_materialized -> m_values.data() + offset;
+            m_lengths = m_materialized -> m_lengths.data() + offset;
+            ++m_row_num;
+            return true;
+        }
+        if (!m_result)
+            return false;
         if ((m_row = mysql_fetch_row(m_result))) {
+            m_lengths = mysql_fetch_lengths(m_result);
             ++m_row_num;
             return true;
         }
-        if (mysql_errno(m_mysql))  // 判断是否出现异常
+        // 逐行读取时判断是否出现异常；一次性取回的结果集读完即结束，不再访问连接
+        if (ResultMode::Streaming == m_mode && mysql_errno(m_mysql))
             throw SQLException::generateException(
                     m_mysql, "xjj::ResultSet::next", "fetching next row");
         return false;
     }
 
+    /*!
+     * @brief 根据列名获取列号，列名不存在时抛出异常
+     * @param [in] column_label 列名
+     * @return 列号
+     */
+    uint32_t ResultSet::findColumn(const std::string& column_label) const {
+        // 物化结果的列名索引由共享它的结果集共用，不再逐个建立
+        const std::unordered_map<std::string, uint32_t>& column_index =
+                m_materialized ? m_materialized -> m_column_index : m_column_index;
+        auto it = column_index.find(column_label);
+        if (it == column_index.end())
+            throw SQLException("unknown column " + column_label +
+                               " (in function xjj::sql::ResultSet::findColumn)", 0);
+        return it -> second;
+    }
+
+    /*!
+     * @brief 列值格式错误时抛出异常
+     * @param [in] column_index 列号
+     * @param [in] type_name 目标类型名
+     */
+    void ResultSet::throwConversionError(uint32_t column_index, const char* type_name) const {
+        throw SQLException("cannot convert value '" + getString(column_index) + "' of column " +
+                           std::to_string(column_index) + " to " + type_name +
+                           " (in function xjj::sql::ResultSet::throwConversionError)", 0);
+    }
+
+    /*!
+     * @brief 根据列号判断列值是否为NULL
+     * @param [in] column_index 列号
+     * @return 是否为NULL
+     */
+    bool ResultSet::isNull(uint32_t column_index) const {
+        return nullptr == m_row[column_index - 1];
+    }
+
+    /*!
+     * @brief 根据列号获取列值的引用，不复制、不分配内存
+     * @param [in] column_index 列号
+     * @return 列值引用，NULL值的数据地址为空
+     */
+    StringRef ResultSet::getStringRef(uint32_t column_index) const {
+        StringRef value;
+        value.m_data = m_row[column_index - 1];
+        value.m_length = value.m_data ? m_lengths[column_index - 1] : 0;
+        return value;
+    }
+
+    /*!
+     * @brief 根据列名获取列值的引用，不复制、不分配内存
+     * @param [in] column_label 列名
+     * @return 列值引用，NULL值的数据地址为空
+     */
+    StringRef ResultSet::getStringRef(const std::string& column_label) const {
+        return getStringRef(findColumn(column_label));
+    }
+
     /*!
      * @brief 根据列号获取列中的string数据
      * @param [in] column_index 列号
      * @return 获取到的数据
      */
     std::string ResultSet::getString(uint32_t column_index) const {
-        return std::string(m_row[column_index - 1]);
+        return getStringRef(column_index).str();
     }
 
     /*!
@@ -97,16 +358,7 @@ namespace sql {
     * @return 获取到的数据
     */
     std::string ResultSet::getString(const std::string &column_label) const {
-        MYSQL_FIELD *field;
-        uint32_t col_index = 1;
-
-        // 根据列名获取列号
-        while ((field = mysql_fetch_field(m_result))) {
-            if (0 == strcmp(column_label.c_str(), field -> name))
-                break;
-            ++col_index;
-        }
-        return getString(col_index);
+        return getString(findColumn(column_label));
     }
 
     /*!
@@ -123,7 +375,10 @@ namespace sql {
      * @return 获取到的数据
      */
     int ResultSet::getInt(uint32_t column_index) const {
-        return std::stoi(getString(column_index), nullptr, 10);
+        int64_t value = getInt64(column_index);
+        if (value < INT32_MIN || value > INT32_MAX)
+            throwConversionError(column_index, "int");
+        return static_cast<int>(value);
     }
 
     /*!
@@ -132,7 +387,101 @@ namespace sql {
      * @return 获取到的数据
      */
     int ResultSet::getInt(const std::string &column_label) const {
-        return std::stoi(getString(column_label), nullptr, 10);
+        return getInt(findColumn(column_label));
+    }
+
+    /*!
+     * @brief 根据列号获取列中64位整数数据，直接解析行数据
+     * @param [in] column_index 列号
+     * @return 获取到的数据，NULL值为0
+     */
+    int64_t ResultSet::getInt64(uint32_t column_index) const {
+        StringRef text = getStringRef(column_index);
+        int64_t value = 0;
+        if (text.m_data && !parseInt64(text.m_data, text.m_data + text.m_length, value))
+            throwConversionError(column_index, "int64");
+        return value;
+    }
+
+    /*!
+     * @brief 根据列名获取列中64位整数数据，直接解析行数据
+     * @param [in] column_label 列名
+     * @return 获取到的数据，NULL值为0
+     */
+    int64_t ResultSet::getInt64(const std::string& column_label) const {
+        return getInt64(findColumn(column_label));
+    }
+
+    /*!
+     * @brief 根据列号获取列中double数据，直接解析行数据
+     * @param [in] column_index 列号
+     * @return 获取到的数据，NULL值为0
+     */
+    double ResultSet::getDouble(uint32_t column_index) const {
+        StringRef text = getStringRef(column_index);
+        if (!text.m_data)
+            return 0;
+        // libmysql返回的每个列值都以'\0'结尾，可直接交给strtod
+        char* parsed_end = nullptr;
+        double value = strtod(text.m_data, &parsed_end);
+        if (0 == text.m_length || parsed_end != text.m_data + text.m_length)
+            throwConversionError(column_index, "double");
+        return value;
+    }
+
+    /*!
+     * @brief 根据列名获取列中double数据，直接解析行数据
+     * @param [in] column_label 列名
+     * @return 获取到的数据，NULL值为0
+     */
+    double ResultSet::getDouble(const std::string& column_label) const {
+        return getDouble(findColumn(column_label));
+    }
+
+    /*!
+     * @brief 根据列号获取DECIMAL列的定点数值，不经过浮点数，没有精度损失
+     * @param [in] column_index 列号
+     * @param [in] scale 结果的小数位数，列值多出的小数位被截断
+     * @return 列值乘以10的scale次方，NULL值为0
+     */
+    int64_t ResultSet::getDecimal(uint32_t column_index, unsigned int scale) const {
+        StringRef text = getStringRef(column_index);
+        int64_t value = 0;
+        if (text.m_data && !parseDecimal(text.m_data, text.m_data + text.m_length, scale, value))
+            throwConversionError(column_index, "decimal");
+        return value;
+    }
+
+    /*!
+     * @brief 根据列名获取DECIMAL列的定点数值，不经过浮点数，没有精度损失
+     * @param [in] column_label 列名
+     * @param [in] scale 结果的小数位数，列值多出的小数位被截断
+     * @return 列值乘以10的scale次方，NULL值为0
+     */
+    int64_t ResultSet::getDecimal(const std::string& column_label, unsigned int scale) const {
+        return getDecimal(findColumn(column_label), scale);
+    }
+
+    /*!
+     * @brief 根据列号获取DATE、DATETIME或TIMESTAMP列的日期时间
+     * @param [in] column_index 列号
+     * @return 获取到的数据，NULL值的各字段为0
+     */
+    DateTime ResultSet::getDateTime(uint32_t column_index) const {
+        StringRef text = getStringRef(column_index);
+        DateTime value = DateTime();
+        if (text.m_data && !parseDateTime(text.m_data, text.m_length, value))
+            throwConversionError(column_index, "datetime");
+        return value;
+    }
+
+    /*!
+     * @brief 根据列名获取DATE、DATETIME或TIMESTAMP列的日期时间
+     * @param [in] column_label 列名
+     * @return 获取到的数据，NULL值的各字段为0
+     */
+    DateTime ResultSet::getDateTime(const std::string& column_label) const {
+        return getDateTime(findColumn(column_label));
     }
 
     /*!
@@ -144,7 +493,7 @@ namespace sql {
     }
 
     /*!
-     * @brief 析构函数
+     * @brief 析构函数；逐行读取时未读完的行在此读出并丢弃，之后连接才能执行其它语句
      */
     ResultSet::~ResultSet() {
         mysql_free_result(m_result);
@@ -152,10 +501,10 @@ namespace sql {
 
     /*!
      * @brief 构造函数
-     * @param [in] mysql 连接句柄
+     * @param [in] conn 所属的连接
      */
-    Statement::Statement(MYSQL *mysql)
-            : m_mysql(mysql) {}
+    Statement::Statement(Connection *conn)
+            : m_conn(conn), m_mysql(conn -> m_mysql), m_result_mode(ResultMode::Buffered) {}
 
     /*!
      * @brief 执行sql语句
@@ -163,18 +512,724 @@ namespace sql {
      * @return 结果集对象指针
      */
     std::shared_ptr<ResultSet> Statement::executeQuery(const std::string &sql) {
-        if (mysql_query(m_mysql, sql.c_str()))
+        return executeQuery(sql.c_str(), sql.length());
+    }
+
+    /*!
+     * @brief 执行sql语句，sql无需以'\0'结尾（可直接使用内存池中的字符串）
+     * @param [in] sql sql语句
+     * @param [in] length sql语句长度
+     * @return 结果集对象指针
+     */
+    std::shared_ptr<ResultSet> Statement::executeQuery(const char* sql, size_t length) {
+        m_conn -> setMultiStatements(false);  // 此前执行过批量语句时关闭多语句模式，sql只能是单条语句
+        if (mysql_real_query(m_mysql, sql, static_cast<unsigned long>(length)))
             throw SQLException::generateException(
                     m_mysql, "xjj::sql::Statement::executeQuery", "executing SQL");
-        return std::shared_ptr<ResultSet>(new ResultSet(m_mysql));
+        return std::shared_ptr<ResultSet>(new ResultSet(m_mysql, m_result_mode));
+    }
+
+    /*!
+     * @brief 设置之后执行的语句的结果集取回方式，默认为ResultMode::Buffered；
+     * 导出大量数据时使用ResultMode::Streaming，边读取边处理
+     * @param [in] mode 取回方式
+     */
+    void Statement::setResultMode(ResultMode mode) {
+        m_result_mode = mode;
+    }
+
+    /*!
+     * @brief 获取结果集取回方式
+     * @return 取回方式
+     */
+    ResultMode Statement::getResultMode() const {
+        return m_result_mode;
+    }
+
+    /*!
+     * @brief 以非阻塞方式开始执行sql语句，结果一次性取回（不受结果集取回方式影响）；
+     * 返回的异步查询对象析构前连接不能执行其它语句
+     * @param [in] sql sql语句
+     * @return 异步查询对象指针，由调用者在连接套接字就绪时调用poll()推进
+     */
+    std::shared_ptr<AsyncQuery> Statement::executeQueryAsync(const std::string& sql) {
+        m_conn -> setMultiStatements(false);  // 此前执行过批量语句时关闭多语句模式（阻塞一次网络往返）
+        return std::shared_ptr<AsyncQuery>(new AsyncQuery(m_mysql, sql));
+    }
+
+    /*!
+     * @brief 在一次网络往返中执行多条sql语句，各语句的结果一次性取回（不受结果集取回方式影响）；
+     * 执行前开启连接的多语句模式并保持到执行其它语句前。某条语句出错时服务器不再执行其后的语句
+     * @param [in] sqls sql语句，每个元素为一条语句，不以分号结尾
+     * @return 与sqls一一对应的结果，出错或未执行的语句的结果中记录异常
+     * @throw SQLException 开启多语句模式失败
+     */
+    std::vector<BatchResult> Statement::executeBatch(const std::vector<std::string>& sqls) {
+        std::vector<BatchResult> results(sqls.size());
+        if (sqls.empty())
+            return results;
+        // 多语句模式开启后保持，连续的批量执行不再产生额外的网络往返，执行其它语句前才关闭
+        m_conn -> setMultiStatements(true);
+
+        size_t length = 0;
+        for (const std::string& sql : sqls)
+            length += sql.length() + 1;
+        std::string sql_text;
+        sql_text.reserve(length);
+        for (const std::string& sql : sqls) {
+            if (!sql_text.empty())
+                sql_text.push_back(';');
+            sql_text.append(sql);
+        }
+
+        // 第一条语句的错误由mysql_real_query返回，之后各条的错误由mysql_next_result返回
+        size_t index = 0;
+        int status = mysql_real_query(m_mysql, sql_text.data(), static_cast<unsigned long>(sql_text.length()));
+        while (0 == status) {
+            if (index < sqls.size()) {
+                try {
+                    results[index].m_result_set.reset(new ResultSet(m_mysql, ResultMode::Buffered));
+                } catch (const SQLException&) {
+                    results[index].m_error = std::current_exception();
+                }
+            } else {  // 某个元素包含了多条语句，多出的结果读出并丢弃，使连接可以执行其它语句
+                mysql_free_result(mysql_store_result(m_mysql));
+            }
+            index++;
+            status = mysql_next_result(m_mysql);  // 0表示还有结果，-1表示没有更多结果，大于0表示出错
+        }
+        if (status > 0 && index < sqls.size())
+            results[index++].m_error = std::make_exception_ptr(SQLException::generateException(
+                    m_mysql, "xjj::sql::Statement::executeBatch", "executing SQL"));
+
+        for (; index < sqls.size(); index++)
+            results[index].m_error = std::make_exception_ptr(SQLException(
+                    "statement not executed because a previous statement in the batch failed "
+                    "(in function xjj::sql::Statement::executeBatch)", 0));
+        return results;
     }
 
+    /*!
+     * @brief 构造函数
+     * @param [in] mysql 连接句柄
+     * @param [in] sql sql语句
+     */
+    AsyncQuery::AsyncQuery(MYSQL *mysql, const std::string& sql)
+            : m_mysql(mysql), m_sql(sql), m_phase(Phase::Query) {}
+
+    /*!
+     * @brief 析构函数；语句尚未完成时以poll系统调用等待套接字就绪直至完成，结果与错误均丢弃
+     */
+    AsyncQuery::~AsyncQuery() {
+        while (Phase::Done != m_phase) {
+            try {
+                if (poll())
+                    break;
+            } catch (const SQLException&) {
+                break;
+            }
+            pollfd fds{};
+            fds.fd = getSocket();
+            fds.events = POLLIN | POLLOUT;
+            ::poll(&fds, 1, -1);
+        }
+    }
+
+    /*!
+     * @brief 推进执行直至需要等待套接字，出错时抛出异常（之后isDone()为真）
+     * @return 是否已完成
+     */
+    bool AsyncQuery::poll() {
+        if (Phase::Query == m_phase) {
+            net_async_status status = mysql_real_query_nonblocking(
+                    m_mysql, m_sql.data(), static_cast<unsigned long>(m_sql.length()));
+            if (NET_ASYNC_NOT_READY == status)
+                return false;
+            if (NET_ASYNC_ERROR == status) {
+                m_phase = Phase::Done;
+                throw SQLException::generateException(
+                        m_mysql, "xjj::sql::AsyncQuery::poll", "executing SQL");
+            }
+            m_phase = Phase::StoreResult;
+        }
+        if (Phase::StoreResult == m_phase) {
+            MYSQL_RES *result = nullptr;
+            net_async_status status = mysql_store_result_nonblocking(m_mysql, &result);
+            if (NET_ASYNC_NOT_READY == status)
+                return false;
+            m_phase = Phase::Done;
+            if (NET_ASYNC_ERROR == status)
+                throw SQLException::generateException(
+                        m_mysql, "xjj::sql::AsyncQuery::poll", "getting result");
+            // 语句未返回数据时result为空，由结果集记录影响行数
+            m_result.reset(new ResultSet(m_mysql, result, ResultMode::Buffered));
+        }
+        return true;
+    }
+
+    /*!
+     * @brief 判断是否已完成或已出错
+     * @return 是否已完成
+     */
+    bool AsyncQuery::isDone() const {
+        return Phase::Done == m_phase;
+    }
+
+    /*!
+     * @brief 获取连接的套接字文件描述符，用于注册到epoll等待就绪
+     * @return 套接字文件描述符
+     */
+    int AsyncQuery::getSocket() const {
+        return m_mysql -> net.fd;
+    }
+
+    /*!
+     * @brief 获取结果集；结果已全部取回，可在连接归还后继续读取
+     * @return 结果集对象指针，未完成或出错时为空
+     */
+    std::shared_ptr<ResultSet> AsyncQuery::getResult() const {
+        return m_result;
+    }
+
+    /*!
+     * @brief 构造函数
+     * @param [in] stmt 语句句柄，关闭与否由句柄对象负责
+     */
+    StatementHandle::StatementHandle(MYSQL_STMT *stmt) : m_stmt(stmt), m_generation(0) {}
+
+    /*!
+     * @brief 析构函数：关闭语句句柄
+     */
+    StatementHandle::~StatementHandle() {
+        mysql_stmt_close(m_stmt);
+    }
+
+    /*!
+     * @brief 构造函数
+     * @param [in] handle 语句句柄
+     */
+    PreparedStatement::PreparedStatement(const std::shared_ptr<StatementHandle>& handle)
+            : m_handle(handle),
+              m_binds(mysql_stmt_param_count(handle -> m_stmt)),
+              m_params(m_binds.size()) {
+        clearParameters();
+    }
+
+    /*!
+     * @brief 根据参数序号获取参数绑定，序号越界时抛出异常
+     * @param [in] parameter_index 参数序号
+     * @return 参数绑定
+     */
+    MYSQL_BIND& PreparedStatement::bindAt(uint32_t parameter_index) {
+        if (parameter_index < 1 || parameter_index > m_binds.size())
+            throw SQLException("parameter index " + std::to_string(parameter_index) + " out of range "
+                               "(in function xjj::sql::PreparedStatement::bindAt)", 0);
+        MYSQL_BIND& bind = m_binds[parameter_index - 1];
+        memset(&bind, 0, sizeof(bind));
+        return bind;
+    }
+
+    /*!
+     * @brief 设置int参数
+     * @param [in] parameter_index 参数序号
+     * @param [in] value 参数值
+     */
+    void PreparedStatement::setInt(uint32_t parameter_index, int value) {
+        setInt64(parameter_index, value);
+    }
+
+    /*!
+     * @brief 设置64位整数参数
+     * @param [in] parameter_index 参数序号
+     * @param [in] value 参数值
+     */
+    void PreparedStatement::setInt64(uint32_t parameter_index, int64_t value) {
+        MYSQL_BIND& bind = bindAt(parameter_index);
+        Parameter& param = m_params[parameter_index - 1];
+        param.m_int = value;
+        bind.buffer_type = MYSQL_TYPE_LONGLONG;
+        bind.buffer = &param.m_int;
+    }
+
+    /*!
+     * @brief 设置无符号64位整数参数
+     * @param [in] parameter_index 参数序号
+     * @param [in] value 参数值
+     */
+    void PreparedStatement::setUInt64(uint32_t parameter_index, uint64_t value) {
+        setInt64(parameter_index, static_cast<int64_t>(value));
+        m_binds[parameter_index - 1].is_unsigned = 1;
+    }
+
+    /*!
+     * @brief 设置double参数
+     * @param [in] parameter_index 参数序号
+     * @param [in] value 参数值
+     */
+    void PreparedStatement::setDouble(uint32_t parameter_index, double value) {
+        MYSQL_BIND& bind = bindAt(parameter_index);
+        Parameter& param = m_params[parameter_index - 1];
+        param.m_double = value;
+        bind.buffer_type = MYSQL_TYPE_DOUBLE;
+        bind.buffer = &param.m_double;
+    }
+
+    /*!
+     * @brief 设置string参数
+     * @param [in] parameter_index 参数序号
+     * @param [in] value 参数值
+     */
+    void PreparedStatement::setString(uint32_t parameter_index, const std::string& value) {
+        setString(parameter_index, value.data(), value.length());
+    }
+
+    /*!
+     * @brief 设置string参数，value无需以'\0'结尾
+     * @param [in] parameter_index 参数序号
+     * @param [in] value 参数值
+     * @param [in] length 参数长度
+     */
+    void PreparedStatement::setString(uint32_t parameter_index, const char* value, size_t length) {
+        MYSQL_BIND& bind = bindAt(parameter_index);
+        Parameter& param = m_params[parameter_index - 1];
+        param.m_string.assign(value, length);
+        param.m_length = static_cast<unsigned long>(length);
+        bind.buffer_type = MYSQL_TYPE_STRING;
+        bind.buffer = &param.m_string[0];
+        bind.buffer_length = param.m_length;
+        bind.length = &param.m_length;
+    }
+
+    /*!
+     * @brief 设置NULL参数
+     * @param [in] parameter_index 参数序号
+     */
+    void PreparedStatement::setNull(uint32_t parameter_index) {
+        bindAt(parameter_index).buffer_type = MYSQL_TYPE_NULL;
+    }
+
+    /*!
+     * @brief 将所有参数重置为NULL
+     */
+    void PreparedStatement::clearParameters() {
+        for (uint32_t i = 1; i <= m_binds.size(); i++)
+            setNull(i);
+    }
+
+    /*!
+     * @brief 绑定参数并执行
+     * @param [in] caller_func 调用函数名
+     */
+    void PreparedStatement::execute(const char* caller_func) {
+        // 句柄可能被同一SQL的其它PreparedStatement绑定过，每次执行前重新绑定（只在客户端复制绑定信息）
+        if (!m_binds.empty() && mysql_stmt_bind_param(m_handle -> m_stmt, m_binds.data()))
+            throw SQLException::generateException(m_handle -> m_stmt, caller_func, "binding parameters");
+        m_handle -> m_generation++;  // 执行会丢弃句柄上尚未释放的结果，此前的结果集随之失效
+        if (mysql_stmt_execute(m_handle -> m_stmt))
+            throw SQLException::generateException(m_handle -> m_stmt, caller_func, "executing statement");
+    }
+
+    /*!
+     * @brief 执行语句并获取结果集（结果一次性取回客户端）
+     * @return 结果集对象指针
+     */
+    std::shared_ptr<PreparedResultSet> PreparedStatement::executeQuery() {
+        execute("xjj::sql::PreparedStatement::executeQuery");
+        return std::shared_ptr<PreparedResultSet>(new PreparedResultSet(m_handle));
+    }
+
+    /*!
+     * @brief 执行不返回结果集的语句（INSERT、UPDATE、DELETE等）
+     * @return 影响行数
+     */
+    uint64_t PreparedStatement::executeUpdate() {
+        execute("xjj::sql::PreparedStatement::executeUpdate");
+        if (mysql_stmt_field_count(m_handle -> m_stmt) > 0)
+            mysql_stmt_free_result(m_handle -> m_stmt);  // 语句意外返回了结果集，丢弃以免连接处于未读完状态
+        return mysql_stmt_affected_rows(m_handle -> m_stmt);
+    }
+
+    /*!
+     * @brief 获取最近一次执行所生成的自增ID
+     * @return 自增ID
+     */
+    uint64_t PreparedStatement::getLastInsertId() const {
+        return mysql_stmt_insert_id(m_handle -> m_stmt);
+    }
+
+    /// 字符串列缓冲区的最小字节数
+    const unsigned long PreparedResultSet::MinStringBufferSize;
+
+    /*!
+     * @brief 构造函数：取回全部结果行并为各列绑定缓冲区
+     * @param [in] handle 已执行的语句句柄
+     */
+    PreparedResultSet::PreparedResultSet(const std::shared_ptr<StatementHandle>& handle)
+            : m_handle(handle), m_generation(handle -> m_generation), m_row_num(0), m_affect_row_num(0) {
+        MYSQL_RES *metadata = mysql_stmt_result_metadata(m_handle -> m_stmt);
+        if (!metadata) {
+            if (mysql_stmt_field_count(m_handle -> m_stmt) == 0) {
+                // 语句未返回数据，不是SELECT操作
+                m_affect_row_num = mysql_stmt_affected_rows(m_handle -> m_stmt);
+                return;
+            }
+            throw SQLException::generateException(
+                    m_handle -> m_stmt, "xjj::sql::PreparedResultSet::PreparedResultSet", "getting metadata");
+        }
+
+        // 取回全部结果行，同时计算各列的最大长度（语句句柄设置了STMT_ATTR_UPDATE_MAX_LENGTH）
+        if (mysql_stmt_store_result(m_handle -> m_stmt)) {
+            mysql_free_result(metadata);
+            throw SQLException::generateException(
+                    m_handle -> m_stmt, "xjj::sql::PreparedResultSet::PreparedResultSet", "storing result");
+        }
+
+        unsigned int column_num = mysql_num_fields(metadata);
+        MYSQL_FIELD *fields = mysql_fetch_fields(metadata);
+        m_binds.resize(column_num);
+        m_columns.resize(column_num);
+        for (unsigned int i = 0; i < column_num; i++) {
+            MYSQL_BIND& bind = m_binds[i];
+            Column& column = m_columns[i];
+            memset(&bind, 0, sizeof(bind));
+            column.m_name = fields[i].name;
+            column.m_int = 0;
+            bind.length = &column.m_length;
+            bind.is_null = &column.m_is_null;
+            bind.error = &column.m_error;
+
+            switch (fields[i].type) {
+                case MYSQL_TYPE_TINY:
+                case MYSQL_TYPE_SHORT:
+                case MYSQL_TYPE_INT24:
+                case MYSQL_TYPE_LONG:
+                case MYSQL_TYPE_LONGLONG:
+                case MYSQL_TYPE_YEAR:
+                    bind.buffer_type = MYSQL_TYPE_LONGLONG;
+                    bind.buffer = &column.m_int;
+                    bind.is_unsigned = (fields[i].flags & UNSIGNED_FLAG) != 0;
+                    break;
+                case MYSQL_TYPE_FLOAT:
+                case MYSQL_TYPE_DOUBLE:
+                    bind.buffer_type = MYSQL_TYPE_DOUBLE;
+                    bind.buffer = &column.m_double;
+                    break;
+                default:
+                    column.m_buffer.resize(std::max(fields[i].max_length + 1, MinStringBufferSize));
+                    bind.buffer_type = MYSQL_TYPE_STRING;
+                    bind.buffer = column.m_buffer.data();
+                    bind.buffer_length = static_cast<unsigned long>(column.m_buffer.size());
+                    break;
+            }
+        }
+        mysql_free_result(metadata);
+
+        if (mysql_stmt_bind_result(m_handle -> m_stmt, m_binds.data())) {
+            mysql_stmt_free_result(m_handle -> m_stmt);
+            throw SQLException::generateException(
+                    m_handle -> m_stmt, "xjj::sql::PreparedResultSet::PreparedResultSet", "binding result");
+        }
+    }
+
+    /*!
+     * @brief 析构函数：句柄此后未再执行时释放结果，否则结果已属于新的执行
+     */
+    PreparedResultSet::~PreparedResultSet() {
+        if (!m_columns.empty() && m_generation == m_handle -> m_generation)
+            mysql_stmt_free_result(m_handle -> m_stmt);
+    }
+
+    /*!
+     * @brief 将结果光标移动到下一行
+     * @return 是否还有数据，句柄已再次执行（本结果集失效）时返回false
+     */
+    bool PreparedResultSet::next() {
+        if (m_columns.empty() || m_generation != m_handle -> m_generation)
+            return false;
+        int ret = mysql_stmt_fetch(m_handle -> m_stmt);
+        if (MYSQL_NO_DATA == ret)
+            return false;
+        if (MYSQL_DATA_TRUNCATED == ret)
+            fetchTruncatedColumns();
+        else if (ret)
+            throw SQLException::generateException(
+                    m_handle -> m_stmt, "xjj::sql::PreparedResultSet::next", "fetching next row");
+        ++m_row_num;
+        return true;
+    }
+
+    /*!
+     * @brief 读出其余各行，生成以文本形式保存列值的物化结果；之后本结果集没有数据
+     * @return 物化结果
+     */
+    std::shared_ptr<const MaterializedResult> PreparedResultSet::materialize() {
+        // NULL值的偏移量标记
+        static const size_t NullOffset = SIZE_MAX;
+
+        std::shared_ptr<MaterializedResult> result(new MaterializedResult());
+        result -> m_column_num = static_cast<uint32_t>(m_columns.size());
+        result -> m_column_index.reserve(m_columns.size());
+        for (uint32_t i = 0; i < m_columns.size(); i++)
+            result -> m_column_index.emplace(m_columns[i].m_name, i + 1);
+
+        // 先记录各列值在存储中的偏移量，全部读完、存储不再扩容后再换算为地址
+        std::vector<size_t> offsets;
+        std::vector<char>& data = result -> m_data;
+        while (next()) {
+            for (uint32_t i = 0; i < m_columns.size(); i++) {
+                const Column& column = m_columns[i];
+                if (column.m_is_null) {
+                    offsets.push_back(NullOffset);
+                    result -> m_lengths.push_back(0);
+                    continue;
+                }
+                offsets.push_back(data.size());
+                if (MYSQL_TYPE_STRING == m_binds[i].buffer_type) {
+                    data.insert(data.end(), column.m_buffer.data(), column.m_buffer.data() + column.m_length);
+                    result -> m_lengths.push_back(column.m_length);
+                } else {
+                    std::string text = getString(i + 1);  // 数值的文本形式较短，不分配内存
+                    data.insert(data.end(), text.begin(), text.end());
+                    result -> m_lengths.push_back(static_cast<unsigned long>(text.length()));
+                }
+                data.push_back('\0');
+            }
+            result -> m_row_num++;
+        }
+
+        result -> m_values.reserve(offsets.size());
+        for (size_t offset : offsets)
+            result -> m_values.push_back(NullOffset == offset ? nullptr : data.data() + offset);
+        return result;
+    }
+
+    /*!
+     * @brief 扩大被截断列的缓冲区并重新读取该列
+     */
+    void PreparedResultSet::fetchTruncatedColumns() {
+        for (unsigned int i = 0; i < m_columns.size(); i++) {
+            Column& column = m_columns[i];
+            if (!column.m_error || MYSQL_TYPE_STRING != m_binds[i].buffer_type)
+                continue;
+            column.m_buffer.resize(column.m_length + 1);
+            m_binds[i].buffer = column.m_buffer.data();
+            m_binds[i].buffer_length = static_cast<unsigned long>(column.m_buffer.size());
+            if (mysql_stmt_fetch_column(m_handle -> m_stmt, &m_binds[i], i, 0))
+                throw SQLException::generateException(
+                        m_handle -> m_stmt, "xjj::sql::PreparedResultSet::next", "fetching truncated column");
+        }
+
+        // 缓冲区地址已改变，重新绑定以供后续行使用
+        if (mysql_stmt_bind_result(m_handle -> m_stmt, m_binds.data()))
+            throw SQLException::generateException(
+                    m_handle -> m_stmt, "xjj::sql::PreparedResultSet::next", "binding result");
+    }
+
+    /*!
+     * @brief 根据列名获取列号，列名不存在时抛出异常
+     * @param [in] column_label 列名
+     * @return 列号
+     */
+    uint32_t PreparedResultSet::findColumn(const std::string& column_label) const {
+        for (uint32_t i = 0; i < m_columns.size(); i++) {
+            if (m_columns[i].m_name == column_label)
+                return i + 1;
+        }
+        throw SQLException("unknown column " + column_label +
+                           " (in function xjj::sql::PreparedResultSet::findColumn)", 0);
+    }
+
+    /*!
+     * @brief 获取sql操作影响行数
+     * @return 影响行数
+     */
+    uint64_t PreparedResultSet::getAffectedRow() const {
+        return m_affect_row_num;
+    }
+
+    /*!
+     * @brief 获取当前光标指向行行号
+     * @return 行号
+     */
+    int PreparedResultSet::getRow() const {
+        return m_row_num;
+    }
+
+    /*!
+     * @brief 根据列号判断列值是否为NULL
+     * @param [in] column_index 列号
+     * @return 是否为NULL
+     */
+    bool PreparedResultSet::isNull(uint32_t column_index) const {
+        return m_columns[column_index - 1].m_is_null;
+    }
+
+    /*!
+     * @brief 根据列号获取列中int数据
+     * @param [in] column_index 列号
+     * @return 获取到的数据
+     */
+    int PreparedResultSet::getInt(uint32_t column_index) const {
+        return static_cast<int>(getInt64(column_index));
+    }
+
+    /*!
+     * @brief 根据列名获取列中int数据
+     * @param [in] column_label 列名
+     * @return 获取到的数据
+     */
+    int PreparedResultSet::getInt(const std::string& column_label) const {
+        return getInt(findColumn(column_label));
+    }
+
+    /*!
+     * @brief 根据列号获取列中64位整数数据
+     * @param [in] column_index 列号
+     * @return 获取到的数据
+     */
+    int64_t PreparedResultSet::getInt64(uint32_t column_index) const {
+        const Column& column = m_columns[column_index - 1];
+        if (column.m_is_null)
+            return 0;
+        switch (m_binds[column_index - 1].buffer_type) {
+            case MYSQL_TYPE_LONGLONG:
+                return column.m_int;
+            case MYSQL_TYPE_DOUBLE:
+                return static_cast<int64_t>(column.m_double);
+            default:
+                return std::stoll(getString(column_index), nullptr, 10);
+        }
+    }
+
+    /*!
+     * @brief 根据列名获取列中64位整数数据
+     * @param [in] column_label 列名
+     * @return 获取到的数据
+     */
+    int64_t PreparedResultSet::getInt64(const std::string& column_label) const {
+        return getInt64(findColumn(column_label));
+    }
+
+    /*!
+     * @brief 根据列号获取列中double数据
+     * @param [in] column_index 列号
+     * @return 获取到的数据
+     */
+    double PreparedResultSet::getDouble(uint32_t column_index) const {
+        const Column& column = m_columns[column_index - 1];
+        if (column.m_is_null)
+            return 0;
+        const MYSQL_BIND& bind = m_binds[column_index - 1];
+        switch (bind.buffer_type) {
+            case MYSQL_TYPE_LONGLONG:
+                return bind.is_unsigned ? static_cast<double>(static_cast<uint64_t>(column.m_int))
+                                        : static_cast<double>(column.m_int);
+            case MYSQL_TYPE_DOUBLE:
+                return column.m_double;
+            default:
+                return std::stod(getString(column_index), nullptr);
+        }
+    }
+
+    /*!
+     * @brief 根据列名获取列中double数据
+     * @param [in] column_label 列名
+     * @return 获取到的数据
+     */
+    double PreparedResultSet::getDouble(const std::string& column_label) const {
+        return getDouble(findColumn(column_label));
+    }
+
+    /*!
+     * @brief 根据列号获取列中的string数据
+     * @param [in] column_index 列号
+     * @return 获取到的数据
+     */
+    std::string PreparedResultSet::getString(uint32_t column_index) const {
+        const Column& column = m_columns[column_index - 1];
+        if (column.m_is_null)
+            return std::string();
+        const MYSQL_BIND& bind = m_binds[column_index - 1];
+        switch (bind.buffer_type) {
+            case MYSQL_TYPE_LONGLONG:
+                return bind.is_unsigned ? std::to_string(static_cast<uint64_t>(column.m_int))
+                                        : std::to_string(column.m_int);
+            case MYSQL_TYPE_DOUBLE: {
+                char text[32];
+                int length = snprintf(text, sizeof(text), "%.17g", column.m_double);
+                return std::string(text, static_cast<size_t>(length));
+            }
+            default:
+                return std::string(column.m_buffer.data(), column.m_length);
+        }
+    }
+
+    /*!
+     * @brief 根据列名获取列中的string数据
+     * @param [in] column_label 列名
+     * @return 获取到的数据
+     */
+    std::string PreparedResultSet::getString(const std::string& column_label) const {
+        return getString(findColumn(column_label));
+    }
+
+    /*!
+     * @brief 构造函数
+     */
+    MaterializedResult::MaterializedResult() : m_column_num(0), m_row_num(0) {}
+
+    /*!
+     * @brief 获取行数
+     * @return 行数
+     */
+    size_t MaterializedResult::getRowNum() const {
+        return m_row_num;
+    }
+
+    /*!
+     * @brief 获取列数
+     * @return 列数
+     */
+    uint32_t MaterializedResult::getColumnNum() const {
+        return m_column_num;
+    }
+
+    /*!
+     * @brief 获取占用的内存字节数（估计值），用于限制缓存的内存占用
+     * @return 字节数
+     */
+    size_t MaterializedResult::getMemorySize() const {
+        size_t size = sizeof(MaterializedResult) + m_data.capacity() +
+                      m_values.capacity() * sizeof(const char*) + m_lengths.capacity() * sizeof(unsigned long);
+        for (const auto& item : m_column_index)
+            size += sizeof(item) + item.first.capacity() + 2 * sizeof(void*);  // 另计哈希表节点与桶的开销
+        return size;
+    }
+
+    /// 预处理语句缓存的默认容量
+    const size_t Connection::DefaultStatementCacheSize;
+
     /*!
      * @brief 构造函数
      * @param [in] mysql 连接句柄
      */
     Connection::Connection(MYSQL *mysql)
-            : m_mysql(mysql) {}
+            : m_mysql(mysql), m_stmt_cache_size(DefaultStatementCacheSize), m_multi_statements(false) {}
+
+    /*!
+     * @brief 开启或关闭多语句模式，与当前模式相同时不产生网络往返
+     * @param [in] enable 是否开启
+     * @throw SQLException 设置失败，此时模式不变
+     */
+    void Connection::setMultiStatements(bool enable) {
+        if (m_multi_statements == enable)
+            return;
+        if (mysql_set_server_option(m_mysql, enable ? MYSQL_OPTION_MULTI_STATEMENTS_ON :
+                                             MYSQL_OPTION_MULTI_STATEMENTS_OFF))
+            throw SQLException::generateException(
+                    m_mysql, "xjj::sql::Connection::setMultiStatements", "setting multiple statements mode");
+        m_multi_statements = enable;
+    }
 
     /*!
      * @brief 设置Schema（用于选择数据库）
@@ -191,30 +1246,114 @@ namespace sql {
      * @return sql表达式指针
      */
     std::shared_ptr<Statement> Connection::createStatement() {
-        return std::shared_ptr<Statement>(new Statement(m_mysql));
+        return std::shared_ptr<Statement>(new Statement(this));
+    }
+
+    /*!
+     * @brief 创建预处理语句：以SQL文本为键查找本连接的LRU缓存，未命中时才在服务器端解析（mysql_stmt_prepare），
+     * 因此重复执行同一SQL只需发送参数；缓存满时关闭最久未使用的语句句柄
+     * @param [in] sql 以?为参数占位符的sql语句
+     * @return 预处理语句指针
+     */
+    std::shared_ptr<PreparedStatement> Connection::prepareStatement(const std::string& sql) {
+        auto it = m_stmt_index.find(sql);
+        if (it != m_stmt_index.end()) {
+            m_stmt_list.splice(m_stmt_list.begin(), m_stmt_list, it -> second);
+            return std::shared_ptr<PreparedStatement>(new PreparedStatement(it -> second -> second));
+        }
+
+        MYSQL_STMT *handle = mysql_stmt_init(m_mysql);
+        if (!handle)
+            throw SQLException::generateException(
+                    m_mysql, "xjj::sql::Connection::prepareStatement", "initializing statement");
+        // 句柄在缓存淘汰且没有PreparedStatement引用时关闭
+        std::shared_ptr<StatementHandle> stmt(std::make_shared<StatementHandle>(handle));
+
+        BindFlag update_max_length = 1;  // 取回结果时计算各列最大长度，供结果集按需分配缓冲区
+        mysql_stmt_attr_set(handle, STMT_ATTR_UPDATE_MAX_LENGTH, &update_max_length);
+        if (mysql_stmt_prepare(handle, sql.c_str(), static_cast<unsigned long>(sql.length())))
+            throw SQLException::generateException(
+                    handle, "xjj::sql::Connection::prepareStatement", "preparing statement");
+
+        if (m_stmt_cache_size > 0) {
+            m_stmt_list.emplace_front(sql, stmt);
+            m_stmt_index.emplace(sql, m_stmt_list.begin());
+            trimStatementCache();
+        }
+        return std::shared_ptr<PreparedStatement>(new PreparedStatement(stmt));
+    }
+
+    /*!
+     * @brief 淘汰最久未使用的预处理语句，直到缓存不超过容量
+     */
+    void Connection::trimStatementCache() {
+        while (m_stmt_list.size() > m_stmt_cache_size) {
+            m_stmt_index.erase(m_stmt_list.back().first);
+            m_stmt_list.pop_back();
+        }
+    }
+
+    /*!
+     * @brief 设置预处理语句缓存容量，超出部分立即淘汰
+     * @param [in] size 容量，为0时不缓存（语句在PreparedStatement释放时关闭）
+     */
+    void Connection::setStatementCacheSize(size_t size) {
+        m_stmt_cache_size = size;
+        trimStatementCache();
+    }
+
+    /*!
+     * @brief 获取预处理语句缓存容量
+     * @return 容量
+     */
+    size_t Connection::getStatementCacheSize() const {
+        return m_stmt_cache_size;
+    }
+
+    /*!
+     * @brief 检查与服务器的连接是否可用（mysql_ping），会产生一次网络往返
+     * @return 是否可用
+     */
+    bool Connection::ping() {
+        return 0 == mysql_ping(m_mysql);
+    }
+
+    /*!
+     * @brief 根据最近一次操作的错误编号判断连接是否已断开（服务器重启、wait_timeout等），不产生网络往返
+     * @return 是否已断开
+     */
+    bool Connection::isConnectionLost() const {
+        unsigned int error_code = mysql_errno(m_mysql);
+        return CR_SERVER_GONE_ERROR == error_code || CR_SERVER_LOST == error_code;
     }
 
     /*!
      * @brief 析构函数
      */
     Connection::~Connection() {
+        // 先关闭缓存的语句句柄；仍被PreparedStatement引用的句柄在mysql_close后只释放客户端内存
+        m_stmt_index.clear();
+        m_stmt_list.clear();
         mysql_close(m_mysql);
     }
 
     std::shared_ptr<Driver> Driver::m_instance = nullptr;
 
-    Mutex Driver::m_mutex;
+    RWMutex Driver::m_mutex;
 
     /*!
      * @brief 驱动全局单例获取函数
      * @return 驱动全局单例
      */
     std::shared_ptr<Driver> Driver::getDriverInstance() {
-        if (!m_instance) {
-            AutoLockMutex autoLockMutex(&m_mutex);
-            if (!m_instance)
-                m_instance = std::shared_ptr<Driver>(new Driver());
+        {
+            AutoReadLock autoReadLock(&m_mutex);
+            if (m_instance)
+                return m_instance;
         }
+        AutoWriteLock autoWriteLock(&m_mutex);
+        if (!m_instance)
+            m_instance = std::shared_ptr<Driver>(new Driver());
         return m_instance;
     }
 
@@ -237,9 +1376,12 @@ namespace sql {
         MYSQL *mysql = mysql_init(nullptr);
 
         if (!mysql_real_connect(mysql, host.c_str(), user.c_str(), passwd.c_str(),
-                               db.c_str(), port, nullptr, 0))
-            throw SQLException::generateException(
+                               db.c_str(), port, nullptr, 0)) {
+            SQLException exception = SQLException::generateException(
                     mysql, "xjj::sql::Driver::connect", "connecting");
+            mysql_close(mysql);  // 连接失败时也须释放句柄，否则服务器不可用期间反复重连会泄漏
+            throw exception;
+        }
         return std::shared_ptr<Connection>(new Connection(mysql));
     }
 
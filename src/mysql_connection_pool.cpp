@@ -2,6 +2,7 @@
 // created by xujijun on 2018-03-20
 //
 
+#include <algorithm>
 #include <fstream>
 #include <mysql_connection_pool.hpp>
 #include <rapidjson/document.h>
@@ -12,22 +13,179 @@ namespace xjj {
 
     std::shared_ptr<MySQLConnectionPool> MySQLConnectionPool::m_instance = nullptr;
 
-    Mutex MySQLConnectionPool::m_instance_mutex;
+    RWMutex MySQLConnectionPool::m_instance_mutex;
+
+    /*!
+     * @brief 构造函数
+     * @param [in] msg 错误信息
+     */
+    ConnectionTimeoutException::ConnectionTimeoutException(const std::string& msg)
+            : SQLException(msg, 0) {}
+
+    /*!
+     * @brief 构造函数，构造空租约
+     */
+    ConnectionLease::ConnectionLease() noexcept
+            : m_pool(nullptr), m_session(nullptr) {}
+
+    /*!
+     * @brief 构造函数
+     * @param [in] pool 连接所属的连接池指针
+     * @param [in] conn 借出的连接对象
+     */
+    ConnectionLease::ConnectionLease(MySQLConnectionPool* pool, std::shared_ptr<sql::Connection> conn) noexcept
+            : m_pool(pool), m_conn(std::move(conn)), m_session(nullptr) {}
+
+    /*!
+     * @brief 移动构造函数
+     * @param [in,out] other 被移动的租约
+     */
+    ConnectionLease::ConnectionLease(ConnectionLease&& other) noexcept
+            : m_pool(other.m_pool), m_conn(std::move(other.m_conn)), m_session(other.m_session) {
+        other.m_pool = nullptr;
+        other.m_session = nullptr;
+    }
+
+    /*!
+     * @brief 移动赋值，先归还本租约原有的连接
+     * @param [in,out] other 被移动的租约
+     * @return ConnectionLease&
+     */
+    ConnectionLease& ConnectionLease::operator=(ConnectionLease&& other) noexcept {
+        if (this != &other) {
+            reset();
+            m_pool = other.m_pool;
+            m_conn = std::move(other.m_conn);
+            m_session = other.m_session;
+            other.m_pool = nullptr;
+            other.m_session = nullptr;
+        }
+        return *this;
+    }
+
+    /*!
+     * @brief 析构函数：归还连接
+     */
+    ConnectionLease::~ConnectionLease() {
+        reset();
+    }
+
+    /*!
+     * @brief 提前归还连接，之后租约为空
+     */
+    void ConnectionLease::reset() {
+        if (m_pool && m_conn)
+            m_pool -> returnConnection(std::move(m_conn));
+        m_conn.reset();
+        m_pool = nullptr;
+        if (m_session)
+            m_session -> finishWrite();  // 写入在连接归还后才算结束，读己之写时长从此时算起
+        m_session = nullptr;
+    }
+
+    /*!
+     * @brief 获取连接对象
+     * @return 连接对象，租约为空时为空
+     */
+    const std::shared_ptr<sql::Connection>& ConnectionLease::get() const noexcept {
+        return m_conn;
+    }
+
+    /*!
+     * @brief 访问连接对象
+     * @return 连接对象指针
+     */
+    sql::Connection* ConnectionLease::operator->() const noexcept {
+        return m_conn.get();
+    }
+
+    /*!
+     * @brief 判断租约是否持有连接
+     * @return 是否持有连接
+     */
+    ConnectionLease::operator bool() const noexcept {
+        return static_cast<bool>(m_conn);
+    }
 
     /*!
      * @brief 构造函数
      */
     MySQLConnectionPool::MySQLConnectionPool()
-            : m_pool_size(5), m_port(0) {
+            : m_list_mutex("MySQLConnectionPool::m_list_mutex", true),  // 取还连接的临界区很短，先自旋再睡眠
+              m_open_num(0),
+              m_timeout_num(0),
+              m_broken_num(0),
+              m_port(0),
+              m_min_size(5),
+              m_max_size(5),
+              m_wait_timeout(0),
+              m_idle_timeout(60),
+              m_validate_interval(1000),
+              m_outstanding_num(0),
+              m_down_until(0),
+              m_replica_retry_interval(1000),
+              m_read_your_writes_window(0) {
         m_driver = sql::Driver::getDriverInstance();
 
         getConfiguration();  // 获取配置文件配置信息
 
-        // 加锁初始化连接池
+        openMinConnections(false);
+
+        // 副本的连接池；副本暂不可用时不影响启动，只读连接改用主库，之后借出时重试
+        for (auto& replica : m_replicas)
+            replica.m_pool.reset(new MySQLConnectionPool(*this, replica));
+    }
+
+    /*!
+     * @brief 构造函数，建立副本的连接池，除地址与端口外的配置与主库相同
+     * @param [in] primary 主库连接池
+     * @param [in] replica 副本
+     */
+    MySQLConnectionPool::MySQLConnectionPool(const MySQLConnectionPool& primary, const Replica& replica)
+            : m_driver(primary.m_driver),
+              m_list_mutex("MySQLConnectionPool::m_list_mutex", true),
+              m_open_num(0),
+              m_timeout_num(0),
+              m_broken_num(0),
+              m_host(replica.m_host),
+              m_user(primary.m_user),
+              m_passwd(primary.m_passwd),
+              m_db_name(primary.m_db_name),
+              m_port(replica.m_port),
+              m_min_size(primary.m_min_size),
+              m_max_size(primary.m_max_size),
+              m_wait_timeout(primary.m_wait_timeout),
+              m_idle_timeout(primary.m_idle_timeout),
+              m_validate_interval(primary.m_validate_interval),
+              m_outstanding_num(0),
+              m_down_until(0),
+              m_replica_retry_interval(primary.m_replica_retry_interval),
+              m_read_your_writes_window(primary.m_read_your_writes_window) {
+        openMinConnections(true);
+    }
+
+    /*!
+     * @brief 建立下限数目的连接
+     * @param [in] tolerate_failure 是否容忍连接失败（副本不可用时不影响启动）
+     */
+    void MySQLConnectionPool::openMinConnections(bool tolerate_failure) {
+        // 加锁初始化连接池，建立下限数目的连接
         AutoLockMutex autoLockMutex(&m_list_mutex);
-        for (auto count = m_pool_size; count > 0; count--) {
-            m_conn_list.push_back(
-                    m_driver -> connect(m_host, m_user, m_passwd, m_db_name, m_port));
+        auto now = std::chrono::steady_clock::now();
+        for (auto count = m_min_size; count > 0; count--) {
+            std::shared_ptr<sql::Connection> conn;
+            try {
+                conn = connect();
+            } catch (const sql::SQLException&) {
+                if (!tolerate_failure)
+                    throw;
+                // 暂不选择本池，重试间隔过后借出时再新建连接
+                m_down_until.store((now + m_replica_retry_interval).time_since_epoch().count(),
+                                   std::memory_order_relaxed);
+                break;
+            }
+            m_idle_list.push_back(IdleConnection{std::move(conn), now, now});
+            m_open_num++;
         }
     }
 
@@ -36,11 +194,14 @@ namespace xjj {
      * @return 连接池对象
      */
     std::shared_ptr<MySQLConnectionPool> MySQLConnectionPool::getInstance() {
-        if (!m_instance) {
-            AutoLockMutex autoLockMutex(&m_instance_mutex);
-            if (!m_instance)
-                m_instance = std::shared_ptr<MySQLConnectionPool>(new MySQLConnectionPool());
+        {
+            AutoReadLock autoReadLock(&m_instance_mutex);
+            if (m_instance)
+                return m_instance;
         }
+        AutoWriteLock autoWriteLock(&m_instance_mutex);
+        if (!m_instance)
+            m_instance = std::shared_ptr<MySQLConnectionPool>(new MySQLConnectionPool());
         return m_instance;
     }
 
@@ -95,10 +256,76 @@ namespace xjj {
                 m_port = document["db_port"].GetUint();
             }
 
+            // db_pool_size单独使用时为固定大小；db_pool_min_size与db_pool_max_size缺省时取db_pool_size
             if (document.HasMember("db_pool_size")) {
                 if (!document["db_pool_size"].IsUint64())
                     throw std::runtime_error(exception_msg + "\"db_pool_size\"");
-                m_pool_size = document["db_pool_size"].GetUint64();
+                m_min_size = m_max_size = document["db_pool_size"].GetUint64();
+            }
+
+            if (document.HasMember("db_pool_min_size")) {
+                if (!document["db_pool_min_size"].IsUint64())
+                    throw std::runtime_error(exception_msg + "\"db_pool_min_size\"");
+                m_min_size = document["db_pool_min_size"].GetUint64();
+                m_max_size = std::max(m_max_size, m_min_size);
+            }
+
+            if (document.HasMember("db_pool_max_size")) {
+                if (!document["db_pool_max_size"].IsUint64() ||
+                        document["db_pool_max_size"].GetUint64() < m_min_size ||
+                        0 == document["db_pool_max_size"].GetUint64())
+                    throw std::runtime_error(exception_msg + "\"db_pool_max_size\"");
+                m_max_size = document["db_pool_max_size"].GetUint64();
+            }
+
+            if (0 == m_max_size)
+                throw std::runtime_error(exception_msg + "\"db_pool_size\"");
+
+            if (document.HasMember("db_pool_idle_timeout_s")) {
+                if (!document["db_pool_idle_timeout_s"].IsUint64())
+                    throw std::runtime_error(exception_msg + "\"db_pool_idle_timeout_s\"");
+                m_idle_timeout = std::chrono::seconds(document["db_pool_idle_timeout_s"].GetUint64());
+            }
+
+            if (document.HasMember("db_pool_validate_ms")) {
+                if (!document["db_pool_validate_ms"].IsUint64())
+                    throw std::runtime_error(exception_msg + "\"db_pool_validate_ms\"");
+                m_validate_interval = std::chrono::milliseconds(document["db_pool_validate_ms"].GetUint64());
+            }
+
+            if (document.HasMember("db_pool_timeout_ms")) {
+                if (!document["db_pool_timeout_ms"].IsUint64())
+                    throw std::runtime_error(exception_msg + "\"db_pool_timeout_ms\"");
+                m_wait_timeout = std::chrono::milliseconds(document["db_pool_timeout_ms"].GetUint64());
+            }
+
+            // 只读副本，用户名、密码、数据库名与连接池配置与主库相同
+            if (document.HasMember("db_replicas")) {
+                if (!document["db_replicas"].IsArray())
+                    throw std::runtime_error(exception_msg + "\"db_replicas\"");
+                for (const auto& item : document["db_replicas"].GetArray()) {
+                    if (!item.IsObject() || !item.HasMember("host") || !item["host"].IsString() ||
+                            (item.HasMember("port") && !item["port"].IsUint()) ||
+                            (item.HasMember("weight") && (!item["weight"].IsUint() || 0 == item["weight"].GetUint())))
+                        throw std::runtime_error(exception_msg + "\"db_replicas\"");
+                    Replica replica;
+                    replica.m_host = item["host"].GetString();
+                    replica.m_port = item.HasMember("port") ? item["port"].GetUint() : m_port;
+                    replica.m_weight = item.HasMember("weight") ? item["weight"].GetUint() : 1;
+                    m_replicas.push_back(std::move(replica));
+                }
+            }
+
+            if (document.HasMember("db_replica_retry_ms")) {
+                if (!document["db_replica_retry_ms"].IsUint64())
+                    throw std::runtime_error(exception_msg + "\"db_replica_retry_ms\"");
+                m_replica_retry_interval = std::chrono::milliseconds(document["db_replica_retry_ms"].GetUint64());
+            }
+
+            if (document.HasMember("db_read_your_writes_ms")) {
+                if (!document["db_read_your_writes_ms"].IsUint64())
+                    throw std::runtime_error(exception_msg + "\"db_read_your_writes_ms\"");
+                m_read_your_writes_window = std::chrono::milliseconds(document["db_read_your_writes_ms"].GetUint64());
             }
 
         } else {
@@ -110,28 +337,389 @@ namespace xjj {
      * @brief 析构函数
      */
     MySQLConnectionPool::~MySQLConnectionPool() {
-        m_conn_list.clear();  // 清空连接池
+        m_idle_list.clear();  // 清空连接池
     }
 
     /*!
-     * @brief 获取连接对象
+     * @brief 获取连接对象，没有空闲连接时按先来先得排队等待，
+     * 等待时长上限由配置项db_pool_timeout_ms指定，缺省时一直等待；须调用returnConnection归还
      * @return 连接对象
+     * @throw ConnectionTimeoutException 等待超时
      */
     std::shared_ptr<sql::Connection> MySQLConnectionPool::getConnection() {
-        AutoLockMutex autoLockMutex(&m_list_mutex);
-        std::shared_ptr<sql::Connection> conn(std::move(m_conn_list.front()));
-        m_conn_list.pop_front();
+        if (0 == m_wait_timeout.count())
+            return takeConnection(nullptr);
+        auto deadline = ConditionVariable::deadlineAfter(m_wait_timeout);
+        return takeConnection(&deadline);
+    }
+
+    /*!
+     * @brief 获取连接租约，没有空闲连接时按先来先得排队等待，租约析构时自动归还连接
+     * @param [in] timeout 等待时长上限
+     * @return 连接租约
+     * @throw ConnectionTimeoutException 等待超时
+     */
+    ConnectionLease MySQLConnectionPool::getConnection(std::chrono::nanoseconds timeout) {
+        auto deadline = ConditionVariable::deadlineAfter(timeout);
+        return ConnectionLease(this, takeConnection(&deadline));
+    }
+
+    /*!
+     * @brief 按访问方式获取连接租约：读写使用主库；只读在可用副本中选择借出连接数与权重之比最小者，
+     * 没有副本或副本新建连接失败时使用主库
+     * @param [in] mode 访问方式
+     * @param [in] timeout 等待时长上限
+     * @return 连接租约
+     * @throw ConnectionTimeoutException 等待超时
+     */
+    ConnectionLease MySQLConnectionPool::getConnection(AccessMode mode, std::chrono::nanoseconds timeout) {
+        auto deadline = ConditionVariable::deadlineAfter(timeout);
+        MySQLConnectionPool* replica = AccessMode::ReadOnly == mode ? chooseReplica() : nullptr;
+        if (replica) {
+            try {
+                return ConnectionLease(replica, replica -> takeConnection(&deadline));
+            } catch (const ConnectionTimeoutException&) {
+                throw;  // 副本繁忙，截止时间已过，不再改用主库
+            } catch (const sql::SQLException&) {
+                // 副本不可用：重试间隔内不再选择，本次改用主库
+                replica -> m_down_until.store(
+                        (std::chrono::steady_clock::now() + m_replica_retry_interval).time_since_epoch().count(),
+                        std::memory_order_relaxed);
+            }
+        }
+        return ConnectionLease(this, takeConnection(&deadline));
+    }
+
+    /*!
+     * @brief 选择借出连接数与权重之比最小的可用副本
+     * @return 副本的连接池，没有可用副本时为空
+     */
+    MySQLConnectionPool* MySQLConnectionPool::chooseReplica() {
+        int64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+        MySQLConnectionPool* chosen = nullptr;
+        uint64_t chosen_load = 0, chosen_weight = 1;
+        for (auto& replica : m_replicas) {
+            MySQLConnectionPool* pool = replica.m_pool.get();
+            if (pool -> m_down_until.load(std::memory_order_relaxed) > now)
+                continue;
+            // 比较 (借出数 + 1) / 权重，交叉相乘避免除法；加1使空闲副本也按权重分配
+            uint64_t load = pool -> m_outstanding_num.load(std::memory_order_relaxed) + 1;
+            if (!chosen || load * chosen_weight < chosen_load * replica.m_weight) {
+                chosen = pool;
+                chosen_load = load;
+                chosen_weight = replica.m_weight;
+            }
+        }
+        return chosen;
+    }
+
+    /*!
+     * @brief 获取连接，没有空闲连接时排队等待
+     * @param [in] deadline 截止时间点，为空表示一直等待
+     * @return 连接对象
+     * @throw ConnectionTimeoutException 超过截止时间仍未得到连接
+     */
+    std::shared_ptr<sql::Connection> MySQLConnectionPool::takeConnection(
+            const std::chrono::steady_clock::time_point* deadline) {
+        std::shared_ptr<sql::Connection> conn;
+        std::vector<std::shared_ptr<sql::Connection>> evicted;  // 离开作用域时在互斥量外关闭
+        bool need_connect = false;
+        bool need_validate = false;
+        {
+            AutoLockMutex autoLockMutex(&m_list_mutex);
+            auto now = std::chrono::steady_clock::now();
+            evictIdleLocked(now, evicted);
+
+            if (m_waiters.empty() && !m_idle_list.empty()) {  // 有空闲连接且无人排队，直接取走
+                IdleConnection& idle = m_idle_list.back();
+                conn = std::move(idle.m_conn);
+                need_validate = now - idle.m_checked_at >= m_validate_interval;
+                m_idle_list.pop_back();
+                m_wait_histogram.record(0);
+            } else if (m_waiters.empty() && m_open_num < m_max_size) {  // 未达上限，新建连接
+                m_open_num++;
+                need_connect = true;
+                m_wait_histogram.record(0);
+            } else {
+                // 排到队尾，等待归还连接的线程将连接或新建连接的准许直接交给自己
+                Waiter waiter;
+                m_waiters.push_back(&waiter);
+                auto handed_over = [&waiter] () { return waiter.m_conn || waiter.m_may_connect; };
+                bool got = true;
+                if (deadline)
+                    got = waiter.m_cond.timedWaitUntil(&m_list_mutex, *deadline, handed_over);
+                else
+                    waiter.m_cond.wait(&m_list_mutex, handed_over);
+
+                auto waited = std::chrono::steady_clock::now() - now;
+                m_wait_histogram.record(static_cast<uint64_t>(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count()));
+                if (!got) {  // 超时，此时仍持有互斥量，没有线程会再将连接交给自己
+                    m_waiters.erase(std::find(m_waiters.begin(), m_waiters.end(), &waiter));
+                    m_timeout_num.fetch_add(1, std::memory_order_relaxed);
+                    throw ConnectionTimeoutException(
+                            "in function xjj::MySQLConnectionPool::getConnection: timed out after " +
+                            std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(waited).count()) +
+                            " ms waiting for a connection (pool max size " + std::to_string(m_max_size) + ")");
+                }
+                conn = std::move(waiter.m_conn);
+                need_connect = !conn;
+            }
+        }
+
+        // 以下网络操作均在互斥量外进行
+        if (need_validate && !conn -> ping()) {  // 闲置期间连接已断开，透明地重新连接
+            m_broken_num.fetch_add(1, std::memory_order_relaxed);
+            conn.reset();
+            need_connect = true;
+        }
+        if (need_connect) {
+            try {
+                conn = connect();
+            } catch (...) {
+                AutoLockMutex autoLockMutex(&m_list_mutex);
+                dropConnectionLocked();
+                throw;
+            }
+        }
+        m_outstanding_num.fetch_add(1, std::memory_order_relaxed);
         return conn;
     }
 
     /*!
-     * @brief 返还连接
+     * @brief 返还连接，有等待者时直接交给最早的等待者；已断开的连接被丢弃
      * @param [in] conn 目标连接对象
      */
     void MySQLConnectionPool::returnConnection(
             std::shared_ptr<sql::Connection> conn) {
+        if (!conn)
+            return;
+        m_outstanding_num.fetch_sub(1, std::memory_order_relaxed);
+        if (conn -> isConnectionLost()) {
+            m_broken_num.fetch_add(1, std::memory_order_relaxed);
+            conn.reset();  // 在互斥量外关闭
+            AutoLockMutex autoLockMutex(&m_list_mutex);
+            dropConnectionLocked();
+            return;
+        }
+        AutoLockMutex autoLockMutex(&m_list_mutex);
+        auto now = std::chrono::steady_clock::now();
+        putConnectionLocked(std::move(conn), now, now);
+    }
+
+    /*!
+     * @brief 新建连接，在互斥量外调用
+     * @return 连接对象
+     * @throw sql::SQLException 连接失败
+     */
+    std::shared_ptr<sql::Connection> MySQLConnectionPool::connect() {
+        return m_driver -> connect(m_host, m_user, m_passwd, m_db_name, m_port);
+    }
+
+    /*!
+     * @brief 将连接交给最早的等待者，没有等待者时放入空闲链表，须持有互斥量
+     * @param [in] conn 连接对象
+     * @param [in] idle_since 开始闲置的时间点
+     * @param [in] checked_at 最近一次确认可用的时间点
+     */
+    void MySQLConnectionPool::putConnectionLocked(std::shared_ptr<sql::Connection> conn,
+                                                  std::chrono::steady_clock::time_point idle_since,
+                                                  std::chrono::steady_clock::time_point checked_at) {
+        if (!m_waiters.empty()) {
+            // 持有互斥量时唤醒：等待者得到互斥量之前不会返回并销毁其条件变量
+            Waiter* waiter = m_waiters.front();
+            m_waiters.pop_front();
+            waiter -> m_conn = std::move(conn);
+            waiter -> m_cond.signal();
+            return;
+        }
+        m_idle_list.push_back(IdleConnection{std::move(conn), idle_since, checked_at});
+    }
+
+    /*!
+     * @brief 减少一个打开的连接数，并在有等待者时准许最早的等待者新建连接，须持有互斥量
+     */
+    void MySQLConnectionPool::dropConnectionLocked() {
+        m_open_num--;
+        if (!m_waiters.empty() && m_open_num < m_max_size) {
+            Waiter* waiter = m_waiters.front();
+            m_waiters.pop_front();
+            m_open_num++;
+            waiter -> m_may_connect = true;
+            waiter -> m_cond.signal();
+        }
+    }
+
+    /*!
+     * @brief 取出闲置超时的多余连接，须持有互斥量；连接由调用者在互斥量外关闭
+     * @param [in] now 当前时间点
+     * @param [out] evicted 被淘汰的连接
+     */
+    void MySQLConnectionPool::evictIdleLocked(std::chrono::steady_clock::time_point now,
+                                              std::vector<std::shared_ptr<sql::Connection>>& evicted) {
+        if (0 == m_idle_timeout.count())
+            return;
+        for (auto it = m_idle_list.begin(); it != m_idle_list.end() && m_open_num > m_min_size;) {
+            if (now - it -> m_idle_since >= m_idle_timeout) {
+                evicted.push_back(std::move(it -> m_conn));
+                it = m_idle_list.erase(it);
+                m_open_num--;
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    /*!
+     * @brief 获取等待统计快照，可据此确定连接池大小
+     * @return 等待统计快照
+     */
+    MySQLConnectionPool::WaitStats MySQLConnectionPool::getWaitStats() {
+        WaitStats stats;
+        stats.m_wait = m_wait_histogram.snapshot();
+        stats.m_timeouts = m_timeout_num.load(std::memory_order_relaxed);
+        stats.m_broken = m_broken_num.load(std::memory_order_relaxed);
+        AutoLockMutex autoLockMutex(&m_list_mutex);
+        stats.m_pool_size = m_open_num;
+        stats.m_waiting = m_waiters.size();
+        stats.m_idle = m_idle_list.size();
+        return stats;
+    }
+
+    /*!
+     * @brief 获取副本数目
+     * @return 副本数目
+     */
+    size_t MySQLConnectionPool::getReplicaNum() const {
+        return m_replicas.size();
+    }
+
+    /*!
+     * @brief 获取副本连接池的等待统计快照
+     * @param [in] index 副本序号，与配置项db_replicas中的顺序相同
+     * @return 等待统计快照
+     */
+    MySQLConnectionPool::WaitStats MySQLConnectionPool::getReplicaWaitStats(size_t index) {
+        return m_replicas.at(index).m_pool -> getWaitStats();
+    }
+
+    /*!
+     * @brief 获取配置的读己之写时长，Session缺省使用该值
+     * @return 读己之写时长
+     */
+    std::chrono::milliseconds MySQLConnectionPool::getReadYourWritesWindow() const {
+        return m_read_your_writes_window;
+    }
+
+    /*!
+     * @brief 维护连接池：淘汰闲置超时的多余连接，ping闲置超过校验间隔的连接并重建不可用的连接，
+     * 补足连接数下限。借出时已会按需完成这些工作，本函数供定期后台调用；同时维护各副本的连接池
+     */
+    void MySQLConnectionPool::maintain() {
+        for (auto& replica : m_replicas)
+            replica.m_pool -> maintain();
+
+        std::vector<std::shared_ptr<sql::Connection>> evicted;
+        std::vector<IdleConnection> checking;
+        size_t missing = 0;
+        {
+            AutoLockMutex autoLockMutex(&m_list_mutex);
+            auto now = std::chrono::steady_clock::now();
+            evictIdleLocked(now, evicted);
+
+            // 取出需要校验的连接，在互斥量外ping，期间它们仍计入打开的连接数
+            for (auto it = m_idle_list.begin(); it != m_idle_list.end();) {
+                if (now - it -> m_checked_at >= m_validate_interval) {
+                    checking.push_back(std::move(*it));
+                    it = m_idle_list.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+
+            // 预留补足下限所需的连接数
+            if (m_open_num < m_min_size) {
+                missing = m_min_size - m_open_num;
+                m_open_num += missing;
+            }
+        }
+        evicted.clear();
+
+        // 不可用的连接就地重建，与补足下限的新连接一并放回
+        size_t failed = 0;
+        for (auto& idle : checking) {
+            if (idle.m_conn -> ping()) {
+                idle.m_checked_at = std::chrono::steady_clock::now();
+                continue;
+            }
+            m_broken_num.fetch_add(1, std::memory_order_relaxed);
+            idle.m_conn.reset();
+            missing++;
+        }
+        std::vector<std::shared_ptr<sql::Connection>> opened;
+        for (; missing > 0; missing--) {
+            try {
+                opened.push_back(connect());
+            } catch (const sql::SQLException&) {
+                failed++;  // 数据库仍不可用，留待之后借出或维护时重试
+            }
+        }
+
         AutoLockMutex autoLockMutex(&m_list_mutex);
-        m_conn_list.push_back(conn);
+        auto now = std::chrono::steady_clock::now();
+        for (auto& idle : checking) {
+            if (idle.m_conn)
+                putConnectionLocked(std::move(idle.m_conn), idle.m_idle_since, idle.m_checked_at);
+        }
+        for (auto& conn : opened)
+            putConnectionLocked(std::move(conn), now, now);
+        for (; failed > 0; failed--)
+            dropConnectionLocked();
+    }
+
+    /*!
+     * @brief 构造函数，读己之写时长取配置项db_read_your_writes_ms
+     * @param [in] pool 连接池指针
+     */
+    Session::Session(MySQLConnectionPool* pool)
+            : Session(pool, pool -> getReadYourWritesWindow()) {}
+
+    /*!
+     * @brief 构造函数
+     * @param [in] pool 连接池指针
+     * @param [in] window 读己之写时长，应大于副本的复制延迟
+     */
+    Session::Session(MySQLConnectionPool* pool, std::chrono::milliseconds window)
+            : m_pool(pool), m_window(window), m_has_written(false), m_writing_num(0) {}
+
+    /*!
+     * @brief 按访问方式获取连接租约；读写租约未归还期间及归还后的读己之写时长内，只读操作使用主库；
+     * 读写租约须在会话析构前归还
+     * @param [in] mode 访问方式
+     * @param [in] timeout 等待时长上限
+     * @return 连接租约
+     * @throw ConnectionTimeoutException 等待超时
+     */
+    ConnectionLease Session::getConnection(AccessMode mode, std::chrono::nanoseconds timeout) {
+        if (AccessMode::ReadWrite == mode) {
+            ConnectionLease lease = m_pool -> getConnection(mode, timeout);
+            lease.m_session = this;
+            m_writing_num++;
+            return lease;
+        }
+        if (m_writing_num > 0 ||
+                (m_has_written && std::chrono::steady_clock::now() - m_last_write < m_window))
+            mode = AccessMode::ReadWrite;  // 副本可能尚未复制到本会话的写入
+        return m_pool -> getConnection(mode, timeout);
+    }
+
+    /*!
+     * @brief 读写租约归还时调用，记录写入结束的时间点
+     */
+    void Session::finishWrite() {
+        m_writing_num--;
+        m_last_write = std::chrono::steady_clock::now();
+        m_has_written = true;
     }
 
 } // namespace xjj
@@ -0,0 +1,744 @@
+//
+// created by agent on 2026-10-19
+//
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <strings.h>
+#include "query_cache.hpp"
+
+namespace xjj {
+
+    /*!
+     * @brief 添加整数参数
+     * @param [in] value 参数值
+     * @return 本对象
+     */
+    QueryParameters& QueryParameters::addInt64(int64_t value) {
+        append(IntTag, value);
+        return *this;
+    }
+
+    /*!
+     * @brief 添加浮点参数
+     * @param [in] value 参数值
+     * @return 本对象
+     */
+    QueryParameters& QueryParameters::addDouble(double value) {
+        append(DoubleTag, value);
+        return *this;
+    }
+
+    /*!
+     * @brief 添加字符串参数
+     * @param [in] value 参数值
+     * @return 本对象
+     */
+    QueryParameters& QueryParameters::addString(const std::string& value) {
+        return addString(value.data(), value.length());
+    }
+
+    /*!
+     * @brief 添加字符串参数
+     * @param [in] value 字符串起始地址
+     * @param [in] length 字符串长度
+     * @return 本对象
+     */
+    QueryParameters& QueryParameters::addString(const char* value, size_t length) {
+        append(StringTag, static_cast<uint64_t>(length));
+        m_encoded.append(value, length);
+        return *this;
+    }
+
+    /*!
+     * @brief 添加NULL参数
+     * @return 本对象
+     */
+    QueryParameters& QueryParameters::addNull() {
+        m_encoded.push_back(NullTag);
+        return *this;
+    }
+
+    /*!
+     * @brief 将参数依次设置到预处理语句
+     * @param [in] stmt 预处理语句
+     */
+    void QueryParameters::bind(sql::PreparedStatement& stmt) const {
+        size_t pos = 0;
+        for (uint32_t index = 1; pos < m_encoded.length(); index++) {
+            switch (m_encoded[pos++]) {
+                case IntTag:
+                    stmt.setInt64(index, read<int64_t>(pos));
+                    break;
+                case DoubleTag:
+                    stmt.setDouble(index, read<double>(pos));
+                    break;
+                case StringTag: {
+                    size_t length = static_cast<size_t>(read<uint64_t>(pos));
+                    stmt.setString(index, m_encoded.data() + pos, length);
+                    pos += length;
+                    break;
+                }
+                default:
+                    stmt.setNull(index);
+                    break;
+            }
+        }
+    }
+
+    /*!
+     * @brief 获取参数的编码，不同的参数序列编码不同
+     * @return 编码
+     */
+    const std::string& QueryParameters::getEncoded() const {
+        return m_encoded;
+    }
+
+    /*!
+     * @brief 在编码末尾追加类型标记与定长数值
+     * @tparam T 数值类型
+     * @param [in] tag 类型标记
+     * @param [in] value 数值
+     */
+    template <typename T>
+    void QueryParameters::append(Tag tag, T value) {
+        char bytes[sizeof(T)];
+        memcpy(bytes, &value, sizeof(T));
+        m_encoded.push_back(tag);
+        m_encoded.append(bytes, sizeof(T));
+    }
+
+    /*!
+     * @brief 从编码中读出定长数值
+     * @tparam T 数值类型
+     * @param [in,out] pos 读取位置，读出后后移
+     * @return 数值
+     */
+    template <typename T>
+    T QueryParameters::read(size_t& pos) const {
+        T value;
+        memcpy(&value, m_encoded.data() + pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+    /*!
+     * @brief sql语句的词法单元 \struct
+     */
+    struct Token {
+        /// 文本：单词去掉反引号，字符串常量记为"'"，其余为单个字符
+        std::string m_text;
+
+        /// 是否为单词（关键字、标识符或数字）
+        bool m_word;
+    };
+
+    /// 其后为表名列表的关键字
+    static const char* const TableListKeywords[] = {
+            "FROM", "JOIN", "STRAIGHT_JOIN", "INTO", "UPDATE", "INSERT", "REPLACE", "DELETE"
+    };
+
+    /// 表名列表中表名之前的修饰词
+    static const char* const TableModifiers[] = {
+            "LOW_PRIORITY", "HIGH_PRIORITY", "DELAYED", "QUICK", "IGNORE"
+    };
+
+    /// 结束表名列表的子句关键字，不会是表名或别名
+    static const char* const ClauseKeywords[] = {
+            "WHERE", "SET", "VALUES", "VALUE", "SELECT", "FROM", "JOIN", "INNER", "LEFT", "RIGHT", "OUTER",
+            "CROSS", "NATURAL", "STRAIGHT_JOIN", "ON", "USING", "GROUP", "ORDER", "LIMIT", "HAVING", "UNION",
+            "FOR", "LOCK", "INTO", "PARTITION", "USE", "IGNORE", "FORCE", "WINDOW", "AS"
+    };
+
+    /// 结束表名子句的关键字，JOIN的ON、USING条件不结束表名子句
+    static const char* const TableClauseEnds[] = {
+            "WHERE", "SET", "VALUES", "VALUE", "SELECT", "GROUP", "ORDER", "LIMIT", "HAVING", "UNION",
+            "FOR", "LOCK", "WINDOW"
+    };
+
+    /// 写语句的首个关键字
+    static const char* const WriteVerbs[] = {
+            "INSERT", "REPLACE", "UPDATE", "DELETE"
+    };
+
+    /// 只读而不可缓存的语句的首个关键字
+    static const char* const ReadOnlyVerbs[] = {
+            "SHOW", "DESCRIBE", "DESC", "EXPLAIN"
+    };
+
+    /// 出现即使SELECT不可缓存的关键字：加锁读、SELECT ... INTO与不带括号的时间函数等
+    static const char* const UncacheableKeywords[] = {
+            "FOR", "LOCK", "INTO", "SQL_NO_CACHE", "CURRENT_DATE", "CURRENT_TIME", "CURRENT_TIMESTAMP",
+            "CURRENT_USER", "LOCALTIME", "LOCALTIMESTAMP", "UTC_DATE", "UTC_TIME", "UTC_TIMESTAMP"
+    };
+
+    /// 结果不确定或与会话相关的函数，其后紧跟'('时使SELECT不可缓存
+    static const char* const UncacheableFunctions[] = {
+            "RAND", "UUID", "UUID_SHORT", "NOW", "SYSDATE", "CURDATE", "CURTIME", "UNIX_TIMESTAMP",
+            "LAST_INSERT_ID", "FOUND_ROWS", "ROW_COUNT", "CONNECTION_ID", "USER", "SESSION_USER",
+            "SYSTEM_USER", "DATABASE", "SCHEMA", "GET_LOCK", "RELEASE_LOCK", "IS_FREE_LOCK", "IS_USED_LOCK",
+            "SLEEP", "BENCHMARK", "MASTER_POS_WAIT"
+    };
+
+    /*!
+     * @brief 判断单词是否为某个关键字（不区分大小写），设为static以限制只能在本文件内使用
+     * @param [in] token 词法单元
+     * @param [in] keyword 关键字
+     * @return 是否为该关键字
+     */
+    static bool isKeyword(const Token& token, const char* keyword) {
+        return token.m_word && 0 == strcasecmp(token.m_text.c_str(), keyword);
+    }
+
+    /*!
+     * @brief 判断单词是否为列表中的关键字（不区分大小写），设为static以限制只能在本文件内使用
+     * @tparam N 列表长度
+     * @param [in] token 词法单元
+     * @param [in] keywords 关键字列表
+     * @return 是否为其中之一
+     */
+    template <size_t N>
+    static bool isOneOf(const Token& token, const char* const (&keywords)[N]) {
+        for (const char* keyword : keywords) {
+            if (isKeyword(token, keyword))
+                return true;
+        }
+        return false;
+    }
+
+    /*!
+     * @brief 判断字符能否出现在不加引号的标识符或数字中，设为static以限制只能在本文件内使用
+     * @param [in] c 字符
+     * @return 是否可以
+     */
+    static bool isWordChar(char c) {
+        return isalnum(static_cast<unsigned char>(c)) || '_' == c || '$' == c ||
+               static_cast<unsigned char>(c) >= 0x80;
+    }
+
+    /*!
+     * @brief 切分sql语句，同时生成规整后的语句：去掉注释，空白合并为一个空格，去掉末尾的分号，
+     * 字符串常量原样保留；设为static以限制只能在本文件内使用
+     * @param [in] sql sql语句
+     * @param [out] normalized 规整后的语句
+     * @param [out] tokens 词法单元
+     * @return 是否含有MySQL的可执行注释（以感叹号开头的注释），含有时无法可靠地分析语句
+     */
+    static bool tokenize(const std::string& sql, std::string& normalized, std::vector<Token>& tokens) {
+        bool executable_comment = false;
+        bool pending_space = false;
+        size_t length = sql.length();
+        normalized.reserve(length);
+
+        // 单词之间以一个空格分隔，标点前后的空白同样保留为一个空格，规整前后语义不变
+        auto emit = [&](size_t begin, size_t end) {
+            if (pending_space && !normalized.empty())
+                normalized.push_back(' ');
+            pending_space = false;
+            normalized.append(sql, begin, end - begin);
+        };
+
+        size_t i = 0;
+        while (i < length) {
+            char c = sql[i];
+            if (isspace(static_cast<unsigned char>(c))) {
+                pending_space = true;
+                i++;
+            } else if ('#' == c || ('-' == c && i + 1 < length && '-' == sql[i + 1] &&
+                                    (i + 2 == length || isspace(static_cast<unsigned char>(sql[i + 2]))))) {
+                i = std::min(sql.find('\n', i), length);
+                pending_space = true;
+            } else if ('/' == c && i + 1 < length && '*' == sql[i + 1]) {
+                if (i + 2 < length && '!' == sql[i + 2])
+                    executable_comment = true;
+                size_t end = sql.find("*/", i + 2);
+                i = std::string::npos == end ? length : end + 2;
+                pending_space = true;
+            } else if ('\'' == c || '"' == c) {
+                size_t begin = i++;
+                while (i < length) {
+                    if ('\\' == sql[i]) {
+                        i += 2;
+                    } else if (c == sql[i]) {
+                        i++;
+                        if (i == length || c != sql[i])
+                            break;
+                        i++;  // 两个连续的引号表示引号本身
+                    } else {
+                        i++;
+                    }
+                }
+                i = std::min(i, length);
+                emit(begin, i);
+                tokens.push_back(Token{"'", false});
+            } else if (isWordChar(c) || '`' == c) {
+                // 单词可由反引号括起的部分与'.'连接而成，如`db`.`table`
+                size_t begin = i;
+                std::string word;
+                while (i < length && (isWordChar(sql[i]) || '.' == sql[i] || '`' == sql[i])) {
+                    if ('`' == sql[i]) {
+                        size_t end = std::min(sql.find('`', i + 1), length);
+                        word.append(sql, i + 1, end - i - 1);
+                        i = std::min(end + 1, length);
+                    } else {
+                        word.push_back(sql[i++]);
+                    }
+                }
+                emit(begin, i);
+                tokens.push_back(Token{word, true});
+            } else {
+                emit(i, i + 1);
+                tokens.push_back(Token{std::string(1, c), false});
+                i++;
+            }
+        }
+
+        while (!tokens.empty() && !tokens.back().m_word && ";" == tokens.back().m_text) {
+            tokens.pop_back();
+            normalized.pop_back();
+            while (!normalized.empty() && ' ' == normalized.back())
+                normalized.pop_back();
+        }
+        return executable_comment;
+    }
+
+    /*!
+     * @brief 读取表名列表，表名去掉数据库名，跳过别名；设为static以限制只能在本文件内使用
+     * @param [in] tokens 词法单元
+     * @param [in] pos 列表起始位置
+     * @param [out] tables 表名
+     * @return 列表之后的位置
+     */
+    static size_t collectTables(const std::vector<Token>& tokens, size_t pos, std::vector<std::string>& tables) {
+        while (pos < tokens.size() && isOneOf(tokens[pos], TableModifiers))
+            pos++;
+        while (pos < tokens.size() && tokens[pos].m_word && !isOneOf(tokens[pos], ClauseKeywords)) {
+            const std::string& name = tokens[pos].m_text;
+            size_t dot = name.rfind('.');
+            tables.push_back(std::string::npos == dot ? name : name.substr(dot + 1));
+            pos++;
+
+            if (pos < tokens.size() && isKeyword(tokens[pos], "AS"))
+                pos++;
+            if (pos < tokens.size() && tokens[pos].m_word && !isOneOf(tokens[pos], ClauseKeywords))
+                pos++;  // 别名
+            if (pos == tokens.size() || tokens[pos].m_word || "," != tokens[pos].m_text)
+                break;
+            pos++;
+        }
+        return pos;
+    }
+
+    /*!
+     * @brief 构造函数
+     */
+    QueryCache::Shard::Shard()
+            : m_mutex("QueryCache::Shard::m_mutex", true),  // 临界区只有查表与链表操作，先自旋再睡眠
+              m_size(0) {}
+
+    /// 默认的分片数目
+    const size_t QueryCache::DefaultShardNum;
+
+    /// 语句分析结果的缓存数目上限
+    const size_t QueryCache::MaxStatementNum;
+
+    /// 表写入后未命中的查询仍使用主库的最短时长
+    constexpr std::chrono::milliseconds QueryCache::MinReadYourWritesWindow;
+
+    /*!
+     * @brief 构造函数
+     * @param [in] pool 连接池指针
+     * @param [in] capacity 缓存占用的内存字节数上限，平均分配给各分片；超过分片容量的结果不缓存
+     * @param [in] ttl 结果的默认存活时长
+     * @param [in] connection_timeout 获取连接的等待时长上限
+     * @param [in] shard_num 分片数目，默认为DefaultShardNum
+     */
+    QueryCache::QueryCache(MySQLConnectionPool* pool, size_t capacity, std::chrono::milliseconds ttl,
+                           std::chrono::nanoseconds connection_timeout, size_t shard_num)
+            : m_pool(pool),
+              m_shard_capacity(capacity / std::max<size_t>(shard_num, 1)),
+              m_ttl(ttl),
+              m_connection_timeout(connection_timeout),
+              m_read_your_writes_window(std::max(pool -> getReadYourWritesWindow(), MinReadYourWritesWindow)),
+              m_table_mutex("QueryCache::m_table_mutex", true),
+              m_hit_num(0),
+              m_miss_num(0),
+              m_eviction_num(0),
+              m_invalidation_num(0) {
+        for (size_t i = 0; i < std::max<size_t>(shard_num, 1); i++)
+            m_shards.emplace_back(new Shard());
+    }
+
+    /*!
+     * @brief 执行查询，命中时直接返回缓存的结果；SELECT ... FOR UPDATE等不可缓存的语句直接执行，
+     * 写语句执行后使相关表失效
+     * @param [in] sql 以?为参数占位符的sql语句
+     * @param [in] params 参数
+     * @param [in] ttl 本次缓存结果的存活时长，0表示使用默认存活时长
+     * @return 结果集
+     * @throw SQLException 查询出错、获取连接超时等
+     */
+    std::shared_ptr<sql::ResultSet> QueryCache::executeQuery(const std::string& sql, const QueryParameters& params,
+                                                             std::chrono::milliseconds ttl) {
+        std::shared_ptr<const StatementInfo> info = getStatementInfo(sql);
+        if (StatementKind::Cacheable != info -> m_kind) {
+            m_miss_num.fetch_add(1, std::memory_order_relaxed);
+            if (StatementKind::Uncacheable == info -> m_kind)
+                return std::make_shared<sql::ResultSet>(query(sql, params, AccessMode::ReadWrite));
+            try {
+                std::shared_ptr<sql::ResultSet> result =
+                        std::make_shared<sql::ResultSet>(query(sql, params, AccessMode::ReadWrite));
+                invalidate(*info);
+                return result;
+            } catch (...) {
+                invalidate(*info);  // 出错时写入可能已部分生效
+                throw;
+            }
+        }
+
+        // 键为规整后的语句与参数编码，语句中不含'\0'，二者不会混淆
+        std::string key;
+        key.reserve(info -> m_normalized.length() + 1 + params.getEncoded().length());
+        key.append(info -> m_normalized).push_back('\0');
+        key.append(params.getEncoded());
+
+        std::shared_ptr<const sql::MaterializedResult> result = lookup(key);
+        if (result) {
+            m_hit_num.fetch_add(1, std::memory_order_relaxed);
+            return std::make_shared<sql::ResultSet>(std::move(result));
+        }
+        m_miss_num.fetch_add(1, std::memory_order_relaxed);
+
+        // 先记录各表的版本号再查询：查询期间有写入时版本号已变，放入的结果不会被读到
+        Entry entry;
+        entry.m_versions.reserve(info -> m_tables.size());
+        for (Table* table : info -> m_tables)
+            entry.m_versions.emplace_back(table, table -> m_version.load(std::memory_order_acquire));
+
+        result = query(sql, params, isRecentlyWritten(*info) ? AccessMode::ReadWrite : AccessMode::ReadOnly);
+        entry.m_result = result;
+        entry.m_expire_time = std::chrono::steady_clock::now() + (ttl.count() > 0 ? ttl : m_ttl);
+        entry.m_size = sizeof(Entry) + 2 * key.capacity() + result -> getMemorySize() +
+                       entry.m_versions.capacity() * sizeof(std::pair<Table*, uint64_t>);
+        entry.m_key = std::move(key);
+        insert(std::move(entry));
+        return std::make_shared<sql::ResultSet>(std::move(result));
+    }
+
+    /*!
+     * @brief 在主库上执行写语句，之后使所涉及表的缓存结果失效
+     * @param [in] sql 以?为参数占位符的sql语句
+     * @param [in] params 参数
+     * @return 影响行数
+     * @throw SQLException 执行出错、获取连接超时等
+     */
+    uint64_t QueryCache::executeUpdate(const std::string& sql, const QueryParameters& params) {
+        std::shared_ptr<const StatementInfo> info = getStatementInfo(sql);
+        try {
+            uint64_t affected_row_num;
+            {
+                ConnectionLease conn = m_pool -> getConnection(AccessMode::ReadWrite, m_connection_timeout);
+                std::shared_ptr<sql::PreparedStatement> stmt(conn -> prepareStatement(sql));
+                params.bind(*stmt);
+                affected_row_num = stmt -> executeUpdate();
+            }
+            invalidate(*info);
+            return affected_row_num;
+        } catch (...) {
+            invalidate(*info);  // 出错时写入可能已部分生效
+            throw;
+        }
+    }
+
+    /*!
+     * @brief 使某个表的全部缓存结果失效，用于其它途径写入后
+     * @param [in] table 表名，不区分数据库名
+     */
+    void QueryCache::invalidate(const std::string& table) {
+        Table* state = getTable(table);
+        state -> m_written_at.store(std::chrono::steady_clock::now().time_since_epoch().count(),
+                                    std::memory_order_relaxed);
+        state -> m_version.fetch_add(1, std::memory_order_acq_rel);
+        m_invalidation_num.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /*!
+     * @brief 使全部缓存结果失效
+     */
+    void QueryCache::invalidateAll() {
+        // 递增全部表的版本号，使正在进行的查询的结果不再放入
+        {
+            AutoLockMutex lock(&m_table_mutex);
+            int64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+            for (auto& item : m_tables) {
+                item.second -> m_written_at.store(now, std::memory_order_relaxed);
+                item.second -> m_version.fetch_add(1, std::memory_order_acq_rel);
+            }
+        }
+        m_invalidation_num.fetch_add(1, std::memory_order_relaxed);
+
+        for (auto& shard : m_shards) {
+            std::list<Entry> entries;  // 离开作用域时在互斥量外释放
+            AutoLockMutex lock(&shard -> m_mutex);
+            entries.swap(shard -> m_lru);
+            shard -> m_index.clear();
+            shard -> m_size = 0;
+        }
+    }
+
+    /*!
+     * @brief 获取缓存统计
+     * @return 缓存统计
+     */
+    QueryCache::Stats QueryCache::getStats() const {
+        Stats stats = Stats();
+        stats.m_hit = m_hit_num.load(std::memory_order_relaxed);
+        stats.m_miss = m_miss_num.load(std::memory_order_relaxed);
+        stats.m_eviction = m_eviction_num.load(std::memory_order_relaxed);
+        stats.m_invalidation = m_invalidation_num.load(std::memory_order_relaxed);
+        for (auto& shard : m_shards) {
+            AutoLockMutex lock(&shard -> m_mutex);
+            stats.m_entry_num += shard -> m_lru.size();
+            stats.m_memory_size += shard -> m_size;
+        }
+        return stats;
+    }
+
+    /*!
+     * @brief 获取语句的分析结果，分析过的语句直接返回
+     * @param [in] sql sql语句
+     * @return 分析结果
+     */
+    std::shared_ptr<const QueryCache::StatementInfo> QueryCache::getStatementInfo(const std::string& sql) {
+        {
+            AutoReadLock lock(&m_statement_mutex);
+            auto it = m_statements.find(sql);
+            if (it != m_statements.end())
+                return it -> second;
+        }
+
+        std::shared_ptr<const StatementInfo> info = analyze(sql);
+        AutoWriteLock lock(&m_statement_mutex);
+        if (m_statements.size() < MaxStatementNum)
+            m_statements.emplace(sql, info);
+        return info;
+    }
+
+    /*!
+     * @brief 分析语句：规整空白、识别类别与所涉及的表
+     * @param [in] sql sql语句
+     * @return 分析结果
+     */
+    std::shared_ptr<const QueryCache::StatementInfo> QueryCache::analyze(const std::string& sql) {
+        std::shared_ptr<StatementInfo> info = std::make_shared<StatementInfo>();
+        std::vector<Token> tokens;
+        bool opaque = tokenize(sql, info -> m_normalized, tokens);
+
+        // 跳过"(SELECT ...) UNION (SELECT ...)"开头的括号
+        size_t first = 0;
+        while (first < tokens.size() && !tokens[first].m_word && "(" == tokens[first].m_text)
+            first++;
+        if (first == tokens.size()) {
+            info -> m_kind = StatementKind::Other;
+            return info;
+        }
+
+        // 各层括号内是否处于表名子句中："a JOIN b ON ..., c"中ON条件之后的逗号仍引出表名
+        std::vector<bool> in_table_clause(1, false);
+        std::vector<std::string> tables;
+        bool deterministic = true;
+        bool has_write_verb = false;
+        for (size_t i = first; i < tokens.size(); i++) {
+            const Token& token = tokens[i];
+            if (!token.m_word) {
+                if ("(" == token.m_text) {
+                    in_table_clause.push_back(false);
+                } else if (")" == token.m_text) {
+                    if (in_table_clause.size() > 1)
+                        in_table_clause.pop_back();
+                } else if ("," == token.m_text && in_table_clause.back()) {
+                    i = collectTables(tokens, i + 1, tables) - 1;
+                } else if ("@" == token.m_text) {
+                    deterministic = false;  // 用户变量或系统变量
+                }
+                continue;
+            }
+            if (isOneOf(token, UncacheableKeywords) ||
+                    (isOneOf(token, UncacheableFunctions) && i + 1 < tokens.size() && "(" == tokens[i + 1].m_text))
+                deterministic = false;
+            if (isOneOf(token, WriteVerbs))
+                has_write_verb = true;
+            if (isOneOf(token, TableListKeywords)) {
+                in_table_clause.back() = true;
+                i = collectTables(tokens, i + 1, tables) - 1;
+            } else if (isOneOf(token, TableClauseEnds)) {
+                in_table_clause.back() = false;
+            }
+        }
+
+        const Token& verb = tokens[first];
+        if (isKeyword(verb, "SELECT"))
+            info -> m_kind = deterministic && !opaque ? StatementKind::Cacheable : StatementKind::Uncacheable;
+        else if (isOneOf(verb, WriteVerbs))
+            info -> m_kind = tables.empty() || opaque ? StatementKind::Other : StatementKind::Write;
+        else if (isOneOf(verb, ReadOnlyVerbs) || (isKeyword(verb, "WITH") && !has_write_verb))
+            info -> m_kind = StatementKind::Uncacheable;
+        else
+            info -> m_kind = StatementKind::Other;
+
+        // 写语句中的子查询或ON DUPLICATE KEY UPDATE的列名也可能被当作表名，只会使更多结果失效
+        std::sort(tables.begin(), tables.end());
+        tables.erase(std::unique(tables.begin(), tables.end()), tables.end());
+        for (const std::string& table : tables)
+            info -> m_tables.push_back(getTable(table));
+        return info;
+    }
+
+    /*!
+     * @brief 获取表的失效状态，首次出现时创建
+     * @param [in] table 表名
+     * @return 失效状态
+     */
+    QueryCache::Table* QueryCache::getTable(const std::string& table) {
+        AutoLockMutex lock(&m_table_mutex);
+        std::unique_ptr<Table>& state = m_tables[table];
+        if (!state) {
+            state.reset(new Table());
+            state -> m_version.store(0, std::memory_order_relaxed);
+            state -> m_written_at.store(std::numeric_limits<int64_t>::min(), std::memory_order_relaxed);
+        }
+        return state.get();
+    }
+
+    /*!
+     * @brief 获取缓存键所在的分片
+     * @param [in] key 缓存键
+     * @return 分片
+     */
+    QueryCache::Shard& QueryCache::getShard(const std::string& key) {
+        return *m_shards[std::hash<std::string>()(key) % m_shards.size()];
+    }
+
+    /*!
+     * @brief 查找未过期且所涉及表未写入过的结果
+     * @param [in] key 缓存键
+     * @return 物化结果，未命中时为空
+     */
+    std::shared_ptr<const sql::MaterializedResult> QueryCache::lookup(const std::string& key) {
+        Shard& shard = getShard(key);
+        auto now = std::chrono::steady_clock::now();
+        std::shared_ptr<const sql::MaterializedResult> stale;  // 离开作用域时在互斥量外释放
+        AutoLockMutex lock(&shard.m_mutex);
+        auto it = shard.m_index.find(key);
+        if (it == shard.m_index.end())
+            return nullptr;
+
+        std::list<Entry>::iterator entry = it -> second;
+        bool valid = now < entry -> m_expire_time;
+        for (const auto& version : entry -> m_versions) {
+            if (version.first -> m_version.load(std::memory_order_acquire) != version.second)
+                valid = false;
+        }
+        if (!valid) {
+            stale = std::move(entry -> m_result);
+            eraseLocked(shard, entry);
+            return nullptr;
+        }
+        shard.m_lru.splice(shard.m_lru.begin(), shard.m_lru, entry);
+        return entry -> m_result;
+    }
+
+    /*!
+     * @brief 放入结果，查询期间所涉及表有写入时放弃
+     * @param [in] entry 待放入的结果
+     */
+    void QueryCache::insert(Entry&& entry) {
+        if (entry.m_size > m_shard_capacity)
+            return;
+        // 只是提前放弃：放入后才发生的写入由查找时的版本号比较发现
+        for (const auto& version : entry.m_versions) {
+            if (version.first -> m_version.load(std::memory_order_acquire) != version.second)
+                return;
+        }
+
+        Shard& shard = getShard(entry.m_key);
+        std::list<Entry> evicted;  // 离开作用域时在互斥量外释放
+        AutoLockMutex lock(&shard.m_mutex);
+        auto it = shard.m_index.find(entry.m_key);
+        if (it != shard.m_index.end())  // 并发的未命中已放入同一结果，以较新的为准
+            eraseLocked(shard, it -> second);
+        while (shard.m_size + entry.m_size > m_shard_capacity) {
+            auto victim = std::prev(shard.m_lru.end());
+            shard.m_size -= victim -> m_size;
+            shard.m_index.erase(victim -> m_key);
+            evicted.splice(evicted.begin(), shard.m_lru, victim);
+            m_eviction_num.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        shard.m_lru.push_front(std::move(entry));
+        shard.m_index.emplace(shard.m_lru.front().m_key, shard.m_lru.begin());
+        shard.m_size += shard.m_lru.front().m_size;
+    }
+
+    /*!
+     * @brief 从分片中移除结果；调用时须持有分片的互斥量
+     * @param [in] shard 分片
+     * @param [in] it 结果所在的链表节点
+     */
+    void QueryCache::eraseLocked(Shard& shard, std::list<Entry>::iterator it) {
+        shard.m_size -= it -> m_size;
+        shard.m_index.erase(it -> m_key);
+        shard.m_lru.erase(it);
+    }
+
+    /*!
+     * @brief 执行查询并取回全部结果，归还连接前生成物化结果
+     * @param [in] sql sql语句
+     * @param [in] params 参数
+     * @param [in] mode 访问方式
+     * @return 物化结果
+     */
+    std::shared_ptr<const sql::MaterializedResult> QueryCache::query(
+            const std::string& sql, const QueryParameters& params, AccessMode mode) {
+        ConnectionLease conn = m_pool -> getConnection(mode, m_connection_timeout);
+        std::shared_ptr<sql::PreparedStatement> stmt(conn -> prepareStatement(sql));
+        params.bind(*stmt);
+        return stmt -> executeQuery() -> materialize();
+    }
+
+    /*!
+     * @brief 写语句执行后使所涉及的表失效
+     * @param [in] info 语句的分析结果
+     */
+    void QueryCache::invalidate(const StatementInfo& info) {
+        if (StatementKind::Other == info.m_kind) {
+            invalidateAll();
+            return;
+        }
+        int64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+        for (Table* table : info.m_tables) {
+            table -> m_written_at.store(now, std::memory_order_relaxed);
+            table -> m_version.fetch_add(1, std::memory_order_acq_rel);
+        }
+        m_invalidation_num.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /*!
+     * @brief 判断所涉及的表是否在读己之写的时间窗口内写入过
+     * @param [in] info 语句的分析结果
+     * @return 是否写入过
+     */
+    bool QueryCache::isRecentlyWritten(const StatementInfo& info) const {
+        int64_t since = (std::chrono::steady_clock::now() - m_read_your_writes_window)
+                .time_since_epoch().count();
+        for (Table* table : info.m_tables) {
+            if (table -> m_written_at.load(std::memory_order_relaxed) > since)
+                return true;
+        }
+        return false;
+    }
+}
@@ -2,8 +2,12 @@
 // created by xujijun on 2018-03-20
 //
 
+#include <algorithm>
 #include <cstring>
 #include <fcntl.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <cassert>
@@ -12,6 +16,7 @@
 #include <thread>
 #include <fstream>
 #include <rapidjson/document.h>
+#include "object_pool.hpp"
 #include "server.hpp"
 
 namespace xjj {
@@ -22,8 +27,17 @@ namespace xjj {
     /// 套接字文件描述符关闭状态码
     const int Server::CloseSockFdStatusCode = -1;
 
-    /// 重置套接字文件描述符OneShot状态码
-    const int Server::ResetOneShotStatusCode = -2;
+    /// 暂无数据可读状态码
+    const int Server::ReadLaterStatusCode = -2;
+
+    /// 连接上下文表大小上限
+    const size_t Server::MaxConnectionNum = 1 << 20;
+
+    /// 有被拒绝的排空任务时epoll_wait的超时（毫秒）
+    const int Server::DeferredRetryMs = 10;
+
+    /// 发送缓冲区持续已满时的等待时长上限（毫秒）
+    const int Server::Response::SendTimeoutMs = 30000;
 
     /*!
      * @brief 构造函数
@@ -32,6 +46,8 @@ namespace xjj {
     Server::Server(std::function<void(const Request&, Response&)> business_logic)
             : m_thread_pool_size(5),
               m_thread_pool_overload(true),
+              m_thread_pool_capacity(0),
+              m_thread_pool_rejection_policy(ThreadPool::RejectionPolicy::Block),
               m_is_running(false),
               m_business_logic(std::move(business_logic)),
               m_thread_pool(nullptr) {}
@@ -51,6 +67,12 @@ namespace xjj {
 
             close(m_listen_fd);  // 关闭服务端监听套接字文件描述符
             m_thread_pool -> terminate();  // 终止线程池
+
+            // 关闭剩余连接，连接上下文归还对象池
+            for (size_t fd = 0; fd < m_connections.size(); fd++) {
+                if (m_connections[fd].load())
+                    closeSocketConnection(static_cast<int>(fd));
+            }
             m_is_running = false;
         }
     }
@@ -70,7 +92,9 @@ namespace xjj {
 
         while (true)  // 循环等待epoll事件到来
         {
-            int ret = epoll_wait(m_epoll_fd, &m_events[0], MAX_EVENT_COUNT, -1);
+            // 有被拒绝的排空任务时定时醒来重新提交，否则其Strand将停滞
+            int timeout = m_deferred_tasks.empty() ? -1 : DeferredRetryMs;
+            int ret = epoll_wait(m_epoll_fd, &m_events[0], MAX_EVENT_COUNT, timeout);
             if (ret < 0)
             {
                 DEBUG_PRINT("epoll failure\n");
@@ -81,6 +105,31 @@ namespace xjj {
         }
     }
 
+    /*!
+     * @brief 添加事件源，须在run()之前调用；文件描述符以水平触发方式注册到服务器的epoll中，
+     * 可读时在epoll线程中调用回调（如异步查询执行器的processEvents），回调应简短
+     * @param [in] fd 事件源文件描述符
+     * @param [in] callback 可读时的回调
+     */
+    void Server::addEventSource(int fd, std::function<void()> callback) {
+        m_event_sources.emplace_back(fd, std::move(callback));
+    }
+
+    /*!
+     * @brief 若文件描述符是用户添加的事件源，调用其回调
+     * @param [in] fd 就绪的文件描述符
+     * @return 是否为事件源
+     */
+    bool Server::dispatchEventSource(int fd) {
+        for (const auto& source : m_event_sources) {  // 事件源很少，顺序查找
+            if (source.first == fd) {
+                source.second();
+                return true;
+            }
+        }
+        return false;
+    }
+
     /*!
      * @brief 将文件描述符设置为非阻塞读写模式
      * @param [in] fd 目标文件描述符
@@ -108,69 +157,131 @@ namespace xjj {
     /*!
      * @brief 讲文件描述符fd添加到epoll监听列表中
      * @param [in] fd 目标文件描述符
-     * @param [in] enable_one_shot 使用EPOLLONESHOT模式（避免线程竞争读fd）
      */
-    void Server::addFd(int fd, bool enable_one_shot) {
+    void Server::addFd(int fd) {
         epoll_event event{};
         event.data.fd = fd;
         event.events = EPOLLIN | EPOLLET;  // 使用ET
-        if (enable_one_shot)
-        {
-            event.events |= EPOLLONESHOT;  // 使用EPOLLONESHOT模式
-        }
         epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &event);
         setNonBlocking(fd);
     }
 
     /*!
-     * @brief 对socket文件描述符的EPOLLONESHOT选项进行重置，使后续读事件到来时其他线程可以进行读操作
-     * @param [in] fd 目标socket文件描述符
-     */
-    void Server::resetOneShot(int fd) {
-        epoll_event event{};
-        event.data.fd = fd;
-        event.events = EPOLLIN | EPOLLET | EPOLLONESHOT;
-        epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD, fd, &event);
-    }
-
-    /*!
-     * @brief epoll事件触发函数
+     * @brief epoll事件触发函数，可读事件投递到连接所属的Strand，
+     * 本轮变为非空闲的Strand的排空任务收集后一次性批量交给线程池
      * @param [in] number 就绪文件描述符数目
      */
     void Server::edgeTriggerEventFunc(int number) {
+        // 之前被拒绝的排空任务排在前面，先于本轮的任务提交
+        for (auto& task : m_deferred_tasks) {
+            m_ready_tasks.push_back(std::move(task));
+            m_ready_strands.push_back(nullptr);
+        }
+        m_deferred_tasks.clear();
+
         for (int i = 0; i < number; i++) {
             int sock_fd = m_events[i].data.fd;
             if (sock_fd == m_listen_fd) {  // 客户端连接事件
                 struct sockaddr_in client_address{};
                 socklen_t client_addr_length = sizeof(client_address);
                 int conn_fd = accept(m_listen_fd, (struct sockaddr *) &client_address, &client_addr_length);
-                addFd(conn_fd, true);  // 设置EPOLLONESHOT
+                if (conn_fd < 0)
+                    continue;
+                if (static_cast<size_t>(conn_fd) >= m_connections.size()) {  // 超出连接上下文表，拒绝连接
+                    close(conn_fd);
+                    continue;
+                }
+                // 上下文先于监听放入表中，Strand任务入队与出队保证工作线程能看到
+                m_connections[conn_fd].store(ObjectPool<PacketProcessor>::create(), std::memory_order_release);
+                addFd(conn_fd);
+            } else if (dispatchEventSource(sock_fd)) {  // 用户添加的事件源
+                continue;
             } else if (m_events[i].events & EPOLLIN) {  // 客户端连接可读事件
                 DEBUG_PRINT("event trigger once\n");
-                m_thread_pool -> addTask(
-                        [=] () {
-                            DEBUG_PRINT("Going to process packet from sock_fd = %d\n", sock_fd);
-
-                            std::unique_ptr<PacketProcessor> processor(new PacketProcessor());
-
-                            int ret = processor -> readBuffer(sock_fd, this->m_business_logic);  // 读取处理缓冲区
-                            switch (ret) {
-                                case CloseSockFdStatusCode: // 处理结果为关闭连接
-                                    closeSocketConnection(sock_fd);
-                                    break;
-                                case ResetOneShotStatusCode: // 处理结果为重置连接，等待可读
-                                    resetOneShot(sock_fd);
-                                    break;
-                                default:
-                                    DEBUG_PRINT("something else happened when reading buffer\n");
-                            }
-                        },
-                        generateTaskId()
-                );
+                // 同一连接的读事件在其Strand中排队，不会有两个线程同时读写该连接
+                Strand* strand = &m_connection_strands -> get(static_cast<size_t>(sock_fd));
+                Task drain = strand -> enqueue([this, sock_fd] () {
+                    processReadEvent(sock_fd);
+                });
+                m_read_events.emplace_back(sock_fd, strand);
+                if (drain) {  // Strand原本空闲，由本轮负责提交
+                    m_ready_tasks.push_back(std::move(drain));
+                    m_ready_strands.push_back(strand);
+                }
             } else {
                 DEBUG_PRINT("something else happened\n");
             }
         }
+
+        if (!m_ready_tasks.empty()) {
+            // 一次加锁入队并只唤醒所需数目的工作线程
+            size_t added = m_thread_pool -> addTasks(m_ready_tasks.begin(), m_ready_tasks.end());
+            if (added < m_ready_tasks.size()) {
+                // 线程池已满且拒绝了任务：本轮读事件所在的连接被拒绝，排空任务留待下一轮重新提交，
+                // 同一Strand上其它连接之前与之后的事件不受影响
+                shedRejectedConnections(added);
+                for (size_t i = added; i < m_ready_tasks.size(); i++)
+                    m_deferred_tasks.push_back(std::move(m_ready_tasks[i]));
+            }
+        }
+        // 保留容量，避免每轮重新分配
+        m_ready_tasks.clear();
+        m_ready_strands.clear();
+        m_read_events.clear();
+    }
+
+    /*!
+     * @brief 标记本轮读事件落在被拒绝的Strand上的连接；
+     * 这些Strand本轮之前空闲且排空任务未提交，没有线程在访问其连接
+     * @param [in] first 第一个被拒绝的排空任务在m_ready_tasks中的下标
+     */
+    void Server::shedRejectedConnections(size_t first) {
+        std::vector<Strand*> rejected;
+        for (size_t i = first; i < m_ready_strands.size(); i++) {
+            if (m_ready_strands[i])  // 之前被拒绝的排空任务，其连接已经标记过
+                rejected.push_back(m_ready_strands[i]);
+        }
+        std::sort(rejected.begin(), rejected.end());
+        for (const auto& event : m_read_events) {
+            if (!std::binary_search(rejected.begin(), rejected.end(), event.second))
+                continue;
+            PacketProcessor* processor = m_connections[event.first].load(std::memory_order_acquire);
+            if (processor) {
+                DEBUG_PRINT("thread pool rejected sock_fd = %d\n", event.first);
+                processor -> shed();
+            }
+        }
+    }
+
+    /*!
+     * @brief 处理连接可读事件，在连接所属的Strand中执行，同一连接的读写不会并发
+     * @param [in] sock_fd 可读的socket文件描述符
+     */
+    void Server::processReadEvent(int sock_fd) {
+        // 连接已被本Strand中之前的任务关闭，这是排队中的过期读事件
+        PacketProcessor* processor = m_connections[sock_fd].load(std::memory_order_acquire);
+        if (!processor)
+            return;
+
+        if (processor -> isShed()) {  // 线程池曾拒绝该连接的读事件
+            closeSocketConnection(sock_fd);
+            return;
+        }
+
+        DEBUG_PRINT("Going to process packet from sock_fd = %d\n", sock_fd);
+
+        // 读取处理缓冲区
+        int ret = processor -> readBuffer(sock_fd, m_business_logic,
+                                          &m_connection_strands -> get(static_cast<size_t>(sock_fd)));
+        switch (ret) {
+            case CloseSockFdStatusCode: // 处理结果为关闭连接
+                closeSocketConnection(sock_fd);
+                break;
+            case ReadLaterStatusCode: // 暂无数据可读，ET模式下有新数据时epoll会再次返回
+                break;
+            default:
+                DEBUG_PRINT("something else happened when reading buffer\n");
+        }
     }
 
     /*!
@@ -201,10 +312,34 @@ namespace xjj {
 
         m_epoll_fd = epoll_create(5);  // 初始化epoll文件描述符
         assert(m_epoll_fd != -1);
-        addFd(m_listen_fd, false);  // 监听套接字不能设置为OneShot！
+        addFd(m_listen_fd);
+        for (const auto& source : m_event_sources) {  // 事件源使用LT，回调无需一次处理完所有事件
+            epoll_event event{};
+            event.data.fd = source.first;
+            event.events = EPOLLIN;
+            epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, source.first, &event);
+        }
+
+        m_ready_tasks.reserve(MAX_EVENT_COUNT);
+        m_ready_strands.reserve(MAX_EVENT_COUNT);
+        m_read_events.reserve(MAX_EVENT_COUNT);
 
         m_thread_pool.reset(new ThreadPool(m_thread_pool_size, m_thread_pool_overload));
+        if (m_thread_pool_capacity > 0)  // 设置了等待队列容量
+            m_thread_pool -> setCapacity(m_thread_pool_capacity, m_thread_pool_rejection_policy);
         m_thread_pool -> start();  // 启动线程池
+
+        m_connection_strands.reset(new StrandGroup(m_thread_pool.get()));
+
+        // 文件描述符不会超过进程上限，按上限分配连接上下文表
+        struct rlimit fd_limit{};
+        size_t connection_num = MaxConnectionNum;
+        if (0 == getrlimit(RLIMIT_NOFILE, &fd_limit) && fd_limit.rlim_cur < MaxConnectionNum)
+            connection_num = static_cast<size_t>(fd_limit.rlim_cur);
+        std::vector<std::atomic<PacketProcessor*>> connections(connection_num);
+        for (auto& connection : connections)
+            connection.store(nullptr, std::memory_order_relaxed);
+        m_connections.swap(connections);
     }
 
     /*!
@@ -255,6 +390,29 @@ namespace xjj {
                 m_thread_pool_overload = document["thread_pool_overload"].GetBool();
             }
 
+            if (document.HasMember("thread_pool_capacity")) {
+                if (!document["thread_pool_capacity"].IsUint64()) {
+                    throw std::runtime_error(exception_msg + "\"thread_pool_capacity\"");
+                }
+                m_thread_pool_capacity = document["thread_pool_capacity"].GetUint64();
+            }
+
+            if (document.HasMember("thread_pool_rejection_policy")) {
+                if (!document["thread_pool_rejection_policy"].IsString()) {
+                    throw std::runtime_error(exception_msg + "\"thread_pool_rejection_policy\"");
+                }
+                // DropOldest丢弃的任务无法得知其连接，服务器不支持该策略
+                std::string policy = document["thread_pool_rejection_policy"].GetString();
+                if (policy == "block")
+                    m_thread_pool_rejection_policy = ThreadPool::RejectionPolicy::Block;
+                else if (policy == "reject")
+                    m_thread_pool_rejection_policy = ThreadPool::RejectionPolicy::Reject;
+                else if (policy == "caller_runs")
+                    m_thread_pool_rejection_policy = ThreadPool::RejectionPolicy::CallerRuns;
+                else
+                    throw std::runtime_error(exception_msg + "\"thread_pool_rejection_policy\"");
+            }
+
         } else {
             throw std::runtime_error("Fail to open \"./config.json\"!");
         }
@@ -268,6 +426,8 @@ namespace xjj {
         // 取消对socket文件描述符的epoll事件监听
         epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, sock_fd, nullptr);
 
+        // 先归还连接上下文再关闭：关闭后文件描述符可能立即被新连接复用
+        ObjectPool<PacketProcessor>::destroy(m_connections[sock_fd].exchange(nullptr, std::memory_order_acq_rel));
         close(sock_fd);
     }
 
@@ -276,23 +436,45 @@ namespace xjj {
      * @param [in] business_logic 用户业务逻辑函数对象
      */
     Server::PacketProcessor::PacketProcessor()
-            : m_packet_len(-1) {}
+            : m_packet_len(-1), m_shed(false) {}
+
+    /*!
+     * @brief 标记连接被线程池拒绝，其排队中的读事件改为关闭连接
+     */
+    void Server::PacketProcessor::shed() {
+        m_shed = true;
+    }
+
+    /*!
+     * @brief 判断连接是否被线程池拒绝
+     * @return 是否被拒绝
+     */
+    bool Server::PacketProcessor::isShed() const {
+        return m_shed;
+    }
 
     /*!
     * @brief 读取并处理缓冲区数据
     * @param [in] sock_fd 欲读取的socket文件描述符
     * @param [in] business_logic 需要对请求执行的业务逻辑
-    * @return 操作完成状态码，包括 ResetOneShotStatusCode 和 CloseSockFdStatusCode
+    * @param [in] strand 连接所属的Strand指针
+    * @return 操作完成状态码，包括 ReadLaterStatusCode 和 CloseSockFdStatusCode
     */
     int Server::PacketProcessor::readBuffer(int sock_fd, 
-            const std::function<void(const Request&, Response&)>& business_logic) {
+            const std::function<void(const Request&, Response&)>& business_logic, Strand* strand) {
         while (true) {
             bzero(&m_buffer[0], BUFFER_SIZE);  // 清空缓冲区
             int ret = static_cast<int>(recv(sock_fd, &m_buffer[0], BUFFER_SIZE - 1, 0));
             if (ret < 0) { // 出现错误
                 if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
                     DEBUG_PRINT("Read later\n");
-                    return Server::ResetOneShotStatusCode;  // 暂无数据可读，设置EPOLLONESHOT，交由epoll继续监听读事件
+                    return Server::ReadLaterStatusCode;  // 暂无数据可读，交由epoll继续监听读事件
+                }
+                if (errno == EBADF) {
+                    // 连接已被本Strand中之前的任务关闭，这是排队中的过期读事件；
+                    // 文件描述符只会在本Strand中关闭，因此不会误关被复用的描述符
+                    DEBUG_PRINT("Connection already closed\n");
+                    return Server::ReadLaterStatusCode;
                 }
                 DEBUG_PRINT("Error occur when reading\n");
                 return Server::CloseSockFdStatusCode;
@@ -302,14 +484,15 @@ namespace xjj {
             } else {  // 正常读取到数据，进行处理
                 DEBUG_PRINT("Got %d bytes of content: %s\n", ret, &m_buffer[0]);
                 
-                std::string valid_packet;
-                
-                generatePacket(ret, sock_fd, valid_packet);
+                m_request_body.clear();
 
-                if (!valid_packet.empty()) {
-                    // 执行业务逻辑
-                    Request req(valid_packet);
-                    Response res(sock_fd);
+                generatePacket(ret, sock_fd, m_request_body);
+
+                if (!m_request_body.empty()) {
+                    // 执行业务逻辑，请求期间的临时内存从内存池分配，离开作用域时一次性归还
+                    Arena arena;
+                    Request req(m_request_body, &arena);
+                    Response res(sock_fd, strand);
                     business_logic(req, res);
                 }
             }
@@ -343,7 +526,7 @@ namespace xjj {
             printBreakpoint(6);
 
             // 获取剪裁出来的当前处理报文
-            valid_packet = std::move(m_packet.substr(0, static_cast<unsigned long>(m_packet_len)));            
+            valid_packet.assign(m_packet, 0, static_cast<unsigned long>(m_packet_len));  // 复用容量，不分配内存            
 
             // 切分报文边界，获取后续报文的包头
             cutPacketStream();
@@ -385,8 +568,8 @@ namespace xjj {
             int32_t old_len = m_packet_len;
             m_packet_len = *reinterpret_cast<const int32_t*>(m_packet.c_str() + old_len);
 
-            // 根据当前处理报文长度，剪裁出后续报文
-            m_packet = m_packet.substr(static_cast<unsigned long>(old_len + 4));
+            // 根据当前处理报文长度，剪裁出后续报文（原地移动，不分配内存）
+            m_packet.erase(0, static_cast<unsigned long>(old_len + 4));
         } else  {  // 未剪裁数据长度和当前处理报文长度之差小于报文头长度，后续报文报文头未知
             printBreakpoint(4);
 
@@ -395,7 +578,7 @@ namespace xjj {
                 printBreakpoint(5);
 
                 // 根据当前处理报文长度，剪裁出后续报文的部分报文头
-                m_packet_len_buf = m_packet.substr(static_cast<unsigned long>(m_packet_len));
+                m_packet_len_buf.assign(m_packet, static_cast<unsigned long>(m_packet_len), std::string::npos);
             }
 
             m_packet_len = -1;  // 获取到报文头不完整，后续报文长度未知
@@ -414,14 +597,6 @@ namespace xjj {
         DEBUG_PRINT(msg.c_str());
     }
 
-    /*!
-     * @brief 任务Id生成，用于标识即将加入线程池任务队列的任务
-     * @return 任务Id
-     */
-    int32_t Server::generateTaskId() {
-        return -1;
-    }
-
     /*!
      * @brief 打印调试信息（使用宏 _XJJ_DEBUG 开启调试模式），采用 printf 实现
      * @param [in] format 格式字符指针常量
@@ -439,9 +614,11 @@ namespace xjj {
     /*!
      * @brief 构造函数
      * @param [in] body 初始化请求体参数
+     * @param [in] arena 本次请求的内存池指针
      */
-    Server::Request::Request(const std::string& body)
-            : m_body(body) {}
+    Server::Request::Request(const std::string& body, Arena* arena)
+            : m_body(body),
+              m_arena(arena) {}
 
     /*!
      * @brief 获取请求体
@@ -451,42 +628,130 @@ namespace xjj {
         return m_body;
     }
 
+    /*!
+     * @brief 获取本次请求的内存池：业务逻辑函数返回后一次性归还，
+     * 其中的内存不可在post的任务或其它线程中使用
+     * @return 内存池引用
+     */
+    Arena& Server::Request::getArena() const {
+        return *m_arena;
+    }
+
     /*!
      * @brief 构造函数
      * @param [in] sock_fd 初始化响应的套接字文件描述符
+     * @param [in] strand 连接所属的Strand指针，为空时post直接执行任务
      */
-    Server::Response::Response(int sock_fd)
+    Server::Response::Response(int sock_fd, Strand* strand)
             : m_sock_fd(sock_fd), 
-              m_send_offset(0) {}
+              m_strand(strand) {}
 
     /*!
-     * @brief 将报文体的长度转换成字符表示，用于做为响应报文头
-     * @param [in] length 报文体长度
-     * @return 转换结果
+     * @brief 发送响应报文
+     * @param [in] body 响应报文体
      */
-    std::string Server::Response::lenToString(int length) {
-        std::string res(4, '\0');
-        for (int i = 0; i < 4; i++) {
-            res[i] = static_cast<char>(length >> (i * 8));
-        }
-        return res;
+    void Server::Response::sendResponse(const std::string &body) {
+        sendResponse(body.c_str(), body.length());
     }
 
     /*!
-     * @brief 发送响应报文
+     * @brief 发送响应报文，报文体无需以'\0'结尾（可直接使用内存池中的缓冲区）
      * @param [in] body 响应报文体
+     * @param [in] length 响应报文体长度
      */
-    void Server::Response::sendResponse(const std::string &body) {
-         // 初始化响应报文，添加报文头
-         // 采用移动构造，减少内存拷贝开销
-        m_packet = std::move(lenToString(static_cast<int>(body.length())));
+    void Server::Response::sendResponse(const char* body, size_t length) {
+        sendFrame(body, length);
+    }
+
+    /*!
+     * @brief 发送分块响应的一个数据块，用于逐步生成的大响应（如流式导出查询结果）：
+     * 每块是一个独立的报文，所有数据块发送完毕后须调用endChunks。
+     * 发送缓冲区已满时阻塞至客户端读取，故生成方的内存占用不超过一个数据块
+     * @param [in] data 数据块
+     * @param [in] length 数据块长度，为0时不发送（长度为0的报文表示响应结束）
+     * @return 是否发送成功，失败时应停止生成后续数据块
+     */
+    bool Server::Response::sendChunk(const char* data, size_t length) {
+        if (0 == length)
+            return true;
+        return sendFrame(data, length);
+    }
+
+    /*!
+     * @brief 结束分块响应：发送长度为0的报文
+     * @return 是否发送成功
+     */
+    bool Server::Response::endChunks() {
+        return sendFrame("", 0);
+    }
 
-        m_packet.append(body); // 添加报文体
+    /*!
+     * @brief 发送一个报文（4字节小端序长度头加报文体）：套接字保持非阻塞，
+     * 发送缓冲区已满时以poll等待可写，客户端读取多快就发送多快
+     * @param [in] body 报文体
+     * @param [in] length 报文体长度
+     * @return 是否发送成功，失败时连接已关闭读写，由之后的读事件回收
+     */
+    bool Server::Response::sendFrame(const char* body, size_t length) {
+        // 报文头为报文体长度的小端序表示，与报文体一起聚集发送，无需拼接成完整报文
+        char header[4];
+        for (int i = 0; i < 4; i++) {
+            header[i] = static_cast<char>(length >> (i * 8));
+        }
 
-        DEBUG_PRINT("Going to send: %s", m_packet.c_str());
+        DEBUG_PRINT("Going to send: %.*s", static_cast<int>(length), body);
+
+        struct iovec iov[2];
+        iov[0].iov_base = header;
+        iov[0].iov_len = sizeof(header);
+        iov[1].iov_base = const_cast<char*>(body);
+        iov[1].iov_len = length;
+        struct msghdr message{};
+        message.msg_iov = iov;
+        message.msg_iovlen = length > 0 ? 2 : 1;
+
+        // 套接字保持非阻塞（不再来回切换模式，以免影响同时在读该连接的线程），发送缓冲区满时等待可写
+        while (message.msg_iovlen > 0) {
+            ssize_t sent = sendmsg(m_sock_fd, &message, MSG_NOSIGNAL);
+            if (sent < 0) {
+                if (errno == EINTR)
+                    continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    struct pollfd writable{};
+                    writable.fd = m_sock_fd;
+                    writable.events = POLLOUT;
+                    int ready = poll(&writable, 1, SendTimeoutMs);
+                    if (ready > 0 || (ready < 0 && errno == EINTR))
+                        continue;
+                }
+                // 连接出错或客户端长时间不读取：关闭读写，由之后的读事件关闭连接
+                shutdown(m_sock_fd, SHUT_RDWR);
+                return false;
+            }
+            // 跳过已发送的部分
+            auto remain = static_cast<size_t>(sent);
+            while (message.msg_iovlen > 0 && remain >= message.msg_iov[0].iov_len) {
+                remain -= message.msg_iov[0].iov_len;
+                message.msg_iov++;
+                message.msg_iovlen--;
+            }
+            if (message.msg_iovlen > 0) {
+                message.msg_iov[0].iov_base = static_cast<char*>(message.msg_iov[0].iov_base) + remain;
+                message.msg_iov[0].iov_len -= remain;
+            }
+        }
+        return true;
+    }
 
-        Server::cancelNonBlocking(m_sock_fd);  // 取消非阻塞读写
-        send(m_sock_fd, m_packet.c_str(), m_packet.length(), 0);
-        Server::setNonBlocking(m_sock_fd);  // 重新设置非阻塞读写
+    /*!
+     * @brief 在连接所属的Strand上执行后续工作：与该连接之后的请求处理按投递顺序串行执行，
+     * 无需再对连接加锁。任务执行时本Response已销毁、连接可能已关闭，任务不应捕获本对象
+     * @param [in] task 任务对象
+     */
+    void Server::Response::post(Task task) {
+        if (m_strand)
+            m_strand -> post(std::move(task));
+        else
+            task();
     }
 } // namespace xjj
\ No newline at end of file
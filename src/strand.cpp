@@ -0,0 +1,196 @@
+//
+// created by agent on 2026-10-18
+//
+
+#include <exception>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include "object_pool.hpp"
+#include "strand.hpp"
+
+namespace xjj {
+
+    /*!
+     * @brief 当前线程正在执行的Strand状态，设为static以限制只能在本文件内使用
+     */
+    static thread_local const void* t_current_strand = nullptr;
+
+    /*!
+     * @brief 构造函数
+     * @param [in] pool_ptr 执行任务的线程池指针
+     * @param [in] priority 排空任务的优先级
+     */
+    Strand::State::State(ThreadPool* pool_ptr, ThreadPool::Priority priority)
+            : m_pool_ptr(pool_ptr),
+              m_priority(priority),
+              m_count(0),
+              m_head(nullptr),
+              m_tail(ObjectPool<Node>::create()) {
+        m_tail -> m_next.store(nullptr);
+        m_head.store(m_tail);
+    }
+
+    /*!
+     * @brief 析构函数：释放链表节点
+     */
+    Strand::State::~State() {
+        while (m_tail) {
+            Node* next = m_tail -> m_next.load();
+            ObjectPool<Node>::destroy(m_tail);
+            m_tail = next;
+        }
+    }
+
+    /*!
+     * @brief 构造函数
+     * @param [in] pool_ptr 执行任务的线程池指针
+     * @param [in] priority 排空任务的优先级，默认为Normal
+     */
+    Strand::Strand(ThreadPool* pool_ptr, ThreadPool::Priority priority)
+            : m_state(std::make_shared<State>(pool_ptr, priority)) {}
+
+    /*!
+     * @brief 投递任务；线程池无空位接收排空任务时在调用线程上执行
+     * @param [in] task 任务对象
+     */
+    void Strand::post(Task task) {
+        if (push(*m_state, std::move(task)) && !submitDrain(m_state))
+            drain(m_state);
+    }
+
+    /*!
+     * @brief 只将任务放入队列，不提交排空任务，便于调用者批量提交
+     * @param [in] task 任务对象
+     * @return Strand原本空闲时返回排空任务，调用者必须将其交给线程池或自行执行；否则返回空任务
+     */
+    Task Strand::enqueue(Task task) {
+        if (push(*m_state, std::move(task)))
+            return DrainTask{m_state};
+        return Task();
+    }
+
+    /*!
+     * @brief 判断调用线程当前是否正在执行本Strand的任务
+     * @return 是否正在执行
+     */
+    bool Strand::runningInThisThread() const {
+        return t_current_strand == m_state.get();
+    }
+
+    /*!
+     * @brief 将任务放入链表
+     * @param [in] state 执行器共享状态
+     * @param [in] task 任务对象
+     * @return 执行器原本是否空闲
+     */
+    bool Strand::push(State& state, Task task) {
+        Node* node = ObjectPool<Node>::create();  // 节点取自对象池，投递任务不调用malloc
+        node -> m_next.store(nullptr, std::memory_order_relaxed);
+        node -> m_task = std::move(task);
+        // 先交换头部再链接前驱，两步之间消费者可能短暂看到断开的链表
+        Node* previous = state.m_head.exchange(node, std::memory_order_acq_rel);
+        previous -> m_next.store(node, std::memory_order_release);
+        return 0 == state.m_count.fetch_add(1);
+    }
+
+    /*!
+     * @brief 依次执行链表中的任务，直到执行器空闲或剩余任务交给新的排空任务；
+     * 任务抛出的异常在返回前重新抛出，交接失败而继续执行时只保留第一个异常
+     * @param [in] state 执行器共享状态
+     */
+    void Strand::drain(const std::shared_ptr<State>& state) {
+        const void* previous_strand = t_current_strand;
+        t_current_strand = state.get();
+
+        std::exception_ptr exception;
+        size_t executed = 0;
+        while (true) {
+            // 计数保证链表中有任务，生产者尚未链接完成时稍作等待
+            Node* tail = state -> m_tail;
+            Node* next = tail -> m_next.load(std::memory_order_acquire);
+            while (!next) {
+                std::this_thread::yield();
+                next = tail -> m_next.load(std::memory_order_acquire);
+            }
+            Task task = std::move(next -> m_task);
+            state -> m_tail = next;  // next成为新的哨兵
+            ObjectPool<Node>::destroy(tail);
+
+            bool failed = false;
+            try {
+                task();
+            } catch (...) {
+                if (!exception)
+                    exception = std::current_exception();
+                failed = true;
+            }
+            task.reset();
+
+            if (1 == state -> m_count.fetch_sub(1))
+                break;  // 执行器空闲，后续投递者会提交新的排空任务
+            // 任务抛出异常或已连续执行BatchSize个任务时，剩余任务交给新的排空任务
+            if (failed || ++executed >= BatchSize) {
+                if (submitDrain(state))
+                    break;  // 让出工作线程
+                executed = 0;  // 线程池无空位，继续在本线程执行，不递归也不阻塞
+            }
+        }
+
+        t_current_strand = previous_strand;
+        if (exception)
+            std::rethrow_exception(exception);
+    }
+
+    /*!
+     * @brief 向线程池提交排空任务，不阻塞、不在调用线程执行
+     * @param [in] state 执行器共享状态
+     * @return 是否提交成功（线程池未运行或无空位时返回false）
+     */
+    bool Strand::submitDrain(const std::shared_ptr<State>& state) {
+        return state -> m_pool_ptr -> tryAddTask(DrainTask{state}, state -> m_priority);
+    }
+
+    /*!
+     * @brief 构造函数
+     * @param [in] pool_ptr 执行任务的线程池指针
+     * @param [in] strand_num Strand数目，默认为DefaultStrandNum
+     * @param [in] priority 排空任务的优先级，默认为Normal
+     */
+    StrandGroup::StrandGroup(ThreadPool* pool_ptr, size_t strand_num, ThreadPool::Priority priority) {
+        if (0 == strand_num)
+            throw std::invalid_argument("strand number must be positive.");
+        m_strands.reserve(strand_num);
+        for (size_t i = 0; i < strand_num; i++)
+            m_strands.emplace_back(pool_ptr, priority);
+    }
+
+    /*!
+     * @brief 获取键对应的Strand
+     * @param [in] key 键，如连接的socket文件描述符、用户id或分片号
+     * @return Strand引用
+     */
+    Strand& StrandGroup::get(size_t key) {
+        return m_strands[key % m_strands.size()];
+    }
+
+    /*!
+     * @brief 向键对应的Strand投递任务
+     * @param [in] key 键
+     * @param [in] task 任务对象
+     */
+    void StrandGroup::post(size_t key, Task task) {
+        get(key).post(std::move(task));
+    }
+
+    /*!
+     * @brief 只将任务放入键对应的Strand，见Strand::enqueue
+     * @param [in] key 键
+     * @param [in] task 任务对象
+     * @return 排空任务或空任务
+     */
+    Task StrandGroup::enqueue(size_t key, Task task) {
+        return get(key).enqueue(std::move(task));
+    }
+
+} // namespace xjj
@@ -0,0 +1,212 @@
+//
+// created by agent on 2026-10-18
+//
+
+#include <stdexcept>
+#include <utility>
+#include "task_graph.hpp"
+
+namespace xjj {
+
+    /*!
+     * @brief 构造函数
+     * @param [in] pool_ptr 执行节点的线程池指针
+     * @param [in] priority 节点任务的优先级，默认为Normal
+     */
+    TaskGraph::TaskGraph(ThreadPool* pool_ptr, ThreadPool::Priority priority)
+            : m_state(std::make_shared<State>()),
+              m_running(false) {
+        m_state -> m_pool_ptr = pool_ptr;
+        m_state -> m_priority = priority;
+        m_state -> m_generation = 0;
+        m_state -> m_finished_num.store(0);
+        m_state -> m_failed.store(false);
+    }
+
+    /*!
+     * @brief 析构函数：若已run而未wait，先等待所有节点完成（忽略异常）
+     */
+    TaskGraph::~TaskGraph() {
+        if (m_running) {
+            try {
+                wait();
+            } catch (...) {}
+        }
+    }
+
+    /*!
+     * @brief 添加节点，须在首次run之前调用
+     * @param [in] function 节点执行的可执行对象
+     * @return 节点id
+     */
+    TaskGraph::node_id TaskGraph::addNode(std::function<void()> function) {
+        std::unique_ptr<Node> node(new Node);
+        node -> m_function = std::move(function);
+        node -> m_predecessor_num = 0;
+        node -> m_remaining.store(0);
+        node -> m_claimed_generation.store(m_state -> m_generation);
+        m_state -> m_nodes.push_back(std::move(node));
+        return m_state -> m_nodes.size() - 1;
+    }
+
+    /*!
+     * @brief 声明before须在after之前完成，须在首次run之前调用
+     * @param [in] before 前驱节点id
+     * @param [in] after 后继节点id
+     */
+    void TaskGraph::addEdge(node_id before, node_id after) {
+        auto& nodes = m_state -> m_nodes;
+        if (before >= nodes.size() || after >= nodes.size())
+            throw std::out_of_range("task graph node id out of range.");
+        nodes[before] -> m_successors.push_back(after);
+        nodes[after] -> m_predecessor_num++;
+    }
+
+    /*!
+     * @brief 开始执行，提交所有没有前驱的节点
+     * 图中存在环时抛出std::invalid_argument
+     */
+    void TaskGraph::run() {
+        if (m_running)
+            throw std::logic_error("task graph is already running.");
+        auto& nodes = m_state -> m_nodes;
+
+        // 按拓扑顺序检查是否有环
+        std::vector<size_t> in_degrees(nodes.size());
+        std::vector<node_id> order;
+        order.reserve(nodes.size());
+        for (node_id id = 0; id < nodes.size(); id++) {
+            in_degrees[id] = nodes[id] -> m_predecessor_num;
+            if (0 == in_degrees[id])
+                order.push_back(id);
+        }
+        for (size_t i = 0; i < order.size(); i++) {
+            for (node_id successor : nodes[order[i]] -> m_successors) {
+                if (0 == --in_degrees[successor])
+                    order.push_back(successor);
+            }
+        }
+        if (order.size() != nodes.size())
+            throw std::invalid_argument("task graph contains a cycle.");
+
+        for (auto& node : nodes)
+            node -> m_remaining.store(node -> m_predecessor_num);
+        size_t generation = ++m_state -> m_generation;
+        m_state -> m_finished_num.store(0);
+        m_state -> m_failed.store(false);
+        m_state -> m_exception = nullptr;
+        m_running = true;
+
+        for (node_id id = 0; id < nodes.size(); id++) {
+            if (0 == nodes[id] -> m_predecessor_num)
+                makeReady(m_state, id, generation);
+        }
+    }
+
+    /*!
+     * @brief 等待所有节点完成，期间帮助执行；有节点抛出异常时重新抛出第一个异常
+     */
+    void TaskGraph::wait() {
+        if (!m_running)
+            return;
+        State& state = *m_state;
+        const size_t node_num = state.m_nodes.size();
+        while (true) {
+            bool has_ready = false;
+            node_id id = 0;
+            {
+                AutoLockMutex autoLockMutex(&state.m_mutex);
+                if (state.m_finished_num.load() == node_num)
+                    break;
+                if (!state.m_ready.empty()) {
+                    has_ready = true;
+                    id = state.m_ready.front();
+                    state.m_ready.pop();
+                }
+            }
+
+            if (has_ready) {  // 优先执行本图的就绪节点
+                runNode(m_state, id, state.m_generation);
+                continue;
+            }
+            if (state.m_pool_ptr -> runPendingTask())  // 其次帮助执行线程池中的任务
+                continue;
+
+            // 剩余节点都已被其它线程领取，等待它们完成或产生新的就绪节点
+            AutoLockMutex autoLockMutex(&state.m_mutex);
+            while (state.m_finished_num.load() < node_num && state.m_ready.empty())
+                state.m_cond_var.wait(&state.m_mutex);
+        }
+
+        m_running = false;
+        {
+            AutoLockMutex autoLockMutex(&state.m_mutex);
+            state.m_ready.clear();  // 已被执行的节点可能仍留在就绪队列中
+        }
+        if (state.m_exception)
+            std::rethrow_exception(state.m_exception);
+    }
+
+    /*!
+     * @brief 获取节点数
+     * @return 节点数
+     */
+    size_t TaskGraph::size() const {
+        return m_state -> m_nodes.size();
+    }
+
+    /*!
+     * @brief 节点就绪：放入就绪队列并尝试提交到线程池
+     * @param [in] state 执行共享状态
+     * @param [in] id 节点id
+     * @param [in] generation 执行轮次
+     */
+    void TaskGraph::makeReady(const std::shared_ptr<State>& state, node_id id, size_t generation) {
+        {
+            AutoLockMutex autoLockMutex(&state -> m_mutex);
+            state -> m_ready.push(id);
+        }
+        state -> m_cond_var.signal();
+
+        // 线程池已满时不阻塞，节点留给等待线程执行
+        std::shared_ptr<State> state_copy = state;
+        state -> m_pool_ptr -> tryAddTask([state_copy, id, generation] {
+            runNode(state_copy, id, generation);
+        }, state -> m_priority);
+    }
+
+    /*!
+     * @brief 领取并执行节点，节点已被其它线程领取时直接返回
+     * @param [in] state 执行共享状态
+     * @param [in] id 节点id
+     * @param [in] generation 执行轮次
+     */
+    void TaskGraph::runNode(const std::shared_ptr<State>& state, node_id id, size_t generation) {
+        Node& node = *state -> m_nodes[id];
+        size_t previous = generation - 1;
+        if (!node.m_claimed_generation.compare_exchange_strong(previous, generation))
+            return;
+
+        if (!state -> m_failed.load(std::memory_order_relaxed)) {  // 已有节点失败时只传递完成
+            try {
+                node.m_function();
+            } catch (...) {
+                AutoLockMutex autoLockMutex(&state -> m_mutex);
+                if (!state -> m_exception)
+                    state -> m_exception = std::current_exception();
+                state -> m_failed.store(true);
+            }
+        }
+
+        for (node_id successor : node.m_successors) {
+            if (1 == state -> m_nodes[successor] -> m_remaining.fetch_sub(1))
+                makeReady(state, successor, generation);
+        }
+
+        if (state -> m_finished_num.fetch_add(1) + 1 == state -> m_nodes.size()) {
+            AutoLockMutex autoLockMutex(&state -> m_mutex);
+            state -> m_cond_var.signal();
+        }
+    }
+
+} // namespace xjj
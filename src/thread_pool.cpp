@@ -3,7 +3,10 @@
 //
 
 #include <algorithm>
+#include <cstdio>
 #include <iostream>
+#include <limits>
+#include <sched.h>
 #include <utility>
 #include "thread_pool.hpp"
 
@@ -22,15 +25,30 @@ namespace xjj {
     ThreadPool::ThreadPool(thread_num_type thread_num, bool overload)
             : m_thread_num(static_cast<thread_num_type>(std::min(MaxThreadNum, thread_num))),
               m_overload(overload),
-              m_running(false) {
+              m_running(false),
+              m_pending_count(0),
+              m_active_count(0),
+              m_capacity(MaxCapacity),
+              m_rejection_policy(RejectionPolicy::Block),
+              m_blocked_count(0),
+              m_full_mutex("ThreadPool::m_full_mutex"),
+              m_normal_share(4),
+              m_background_share(1),
+              m_schedule_tick(0),
+              m_idle_count(0),
+              m_idle_mutex("ThreadPool::m_idle_mutex") {
+        for (size_t i = 0; i < PriorityNum; i++) {
+            m_running_counts[i].store(0);
+            m_priority_quotas[i] = m_thread_num;  // 默认不限制各优先级占用的线程数
+        }
+
         // 创建内部线程对象，但底层线程对象未创建
         for (thread_num_type i = 0; i < m_thread_num; i++) {
             auto thread_ptr =
                     std::make_shared<Thread>(
-                            &m_waiting_queue,
-                            &m_working_queue,
-                            &m_finished_queue,
-                             true);  // 默认在线程池发出终止指令时，选择继续执行等待队列中的任务
+                            this,
+                            i,
+                            true);  // 默认在线程池发出终止指令时，选择继续执行等待队列中的任务
             m_thread_ptr_set.push_back(thread_ptr);
         }
     }
@@ -49,26 +67,250 @@ namespace xjj {
         m_running = true;
         for (auto& thread_ptr : m_thread_ptr_set)
             thread_ptr -> start();
+        m_timer_queue.start();
+    }
+
+    /*!
+     * @brief 设置Normal与Background优先级的调度份额，须在start之前调用
+     * @param [in] normal_share Normal份额，默认为4
+     * @param [in] background_share Background份额，默认为1
+     */
+    void ThreadPool::setPriorityShares(size_t normal_share, size_t background_share) {
+        if (0 == normal_share + background_share)
+            throw std::invalid_argument("priority shares must not both be zero.");
+        m_normal_share = normal_share;
+        m_background_share = background_share;
+    }
+
+    /*!
+     * @brief 设置某优先级同时占用的线程数上限，须在start之前调用
+     * @param [in] priority 目标优先级
+     * @param [in] max_running 同时执行该优先级任务的线程数上限，默认为线程总数
+     */
+    void ThreadPool::setPriorityQuota(Priority priority, thread_num_type max_running) {
+        if (0 == max_running)
+            throw std::invalid_argument("priority quota must be positive.");
+        m_priority_quotas[static_cast<size_t>(priority)] = std::min(max_running, m_thread_num);
+    }
+
+    /*!
+     * @brief 设置等待队列容量（所有优先级合计）及队满时的处理策略，须在start之前调用；使用无锁队列时容量至多为MaxCapacity
+     * @param [in] capacity 等待任务数上限
+     * @param [in] policy 队满处理策略，默认为Block
+     * @param [in] drop_callback DropOldest策略下被丢弃任务的回调，可为空
+     */
+    void ThreadPool::setCapacity(size_t capacity, RejectionPolicy policy,
+                                 drop_callback_type drop_callback) {
+        if (0 == capacity)
+            throw std::invalid_argument("thread pool capacity must be positive.");
+        m_capacity = capacity < MaxCapacity ? capacity : MaxCapacity;
+        m_rejection_policy = policy;
+        m_drop_callback = std::move(drop_callback);
     }
 
     /*!
      * @brief 往线程池添加任务
-     * @param [in] function 任务可执行对象
-     * @param [in] task_id 任务id
-     * @return 添加成功与否
+     * @param [in] task 任务对象，可由任意无参可执行对象隐式构造，小对象不分配堆内存
+     * @param [in] priority 任务优先级，默认为Normal
+     * @return 添加成功与否（非过载模式下已满，或Reject策略下队列已满时返回false）
      */
-    bool ThreadPool::addTask(std::function<void()> function, int32_t task_id) {
+    bool ThreadPool::addTask(Task task, Priority priority) {
         if (!m_running) // 线程池未在运行，此时添加任务会抛异常
             throw std::runtime_error("thread pool is not running.");
 
-        // 在非过载模式下，判断是否过载，以过载则不继续添加任务
-        if (!m_overload && m_waiting_queue.size() + m_working_queue.size() >= m_thread_num)
+        // 在非过载模式下，等待与执行中的任务总数不超过线程数，以过载则不继续添加任务
+        if (!m_overload && !tryIncrease(m_active_count, m_thread_num))
             return false;
-        // 添加任务
-        m_waiting_queue.push(Task(std::move(function), task_id));
+        if (m_overload)
+            m_active_count.fetch_add(1);
+
+        // 预留等待队列中的位置：先预留再入队，保证计数精确且不会因工作线程先出队而下溢
+        if (!tryIncrease(m_pending_count, m_capacity)) {
+            switch (m_rejection_policy) {
+                case RejectionPolicy::Block:
+                    try {
+                        waitForPendingSlot();
+                    } catch (...) {
+                        m_active_count.fetch_sub(1);
+                        throw;
+                    }
+                    break;
+                case RejectionPolicy::Reject:
+                    m_active_count.fetch_sub(1);
+                    return false;
+                case RejectionPolicy::CallerRuns:
+                    m_active_count.fetch_sub(1);
+                    task();
+                    return true;
+                case RejectionPolicy::DropOldest:
+                    // 队列中的位置可能已被其它提交线程预留而任务尚未入队，此时无任务可丢弃，让出CPU后重试
+                    while (!tryIncrease(m_pending_count, m_capacity)) {
+                        if (!dropOldestTask())
+                            sched_yield();
+                    }
+                    break;
+            }
+        }
+
+        m_waiting_queues[static_cast<size_t>(priority)].push(std::move(task));
+        notifyIdleThread();
+        return true;
+    }
+
+    /*!
+     * @brief 尝试往线程池添加任务，不阻塞、不在调用线程执行、不丢弃其它任务
+     * @param [in] task 任务对象
+     * @param [in] priority 任务优先级，默认为Normal
+     * @return 添加成功与否（线程池未运行、已满或等待队列已满时返回false）
+     */
+    bool ThreadPool::tryAddTask(Task task, Priority priority) {
+        if (!m_running || 0 == reserveSlots(1))
+            return false;
+#if _XJJ_LOCK_FREE_TASK_QUEUE
+        if (!m_waiting_queues[static_cast<size_t>(priority)].tryEmplace(std::move(task))) {
+            m_pending_count.fetch_sub(1);  // 归还预留的位置
+            m_active_count.fetch_sub(1);
+            notifyBlockedSubmitter();
+            return false;
+        }
+#else
+        m_waiting_queues[static_cast<size_t>(priority)].push(std::move(task));
+#endif
+        notifyIdleThread();
         return true;
     }
 
+    /*!
+     * @brief 在调用线程上执行一个等待中的任务（遵守优先级调度与配额），用于等待时帮助执行
+     * @return 是否执行了任务
+     */
+    bool ThreadPool::runPendingTask() {
+        QueuedTask task;
+        Priority priority;
+        if (!tryTakeTask(task, priority))
+            return false;
+        try {
+            task.m_task();
+        } catch (...) {
+            finishTask(priority);  // 异常传给调用者前先归还配额
+            throw;
+        }
+        finishTask(priority);
+        return true;
+    }
+
+    /*!
+     * @brief 由调用线程与线程池共同执行chunk_num个分组，返回时全部完成
+     * @param [in] chunk_num 分组总数
+     * @param [in] body 分组执行函数，参数为分组下标
+     * @param [in] priority 帮助任务的优先级
+     */
+    void ThreadPool::runChunks(size_t chunk_num, const std::function<void(size_t)>& body, Priority priority) {
+        auto state = std::make_shared<ChunkState>();
+        state -> m_chunk_num = chunk_num;
+        state -> m_body = &body;
+        state -> m_next_chunk.store(0);
+        state -> m_done_num.store(0);
+        state -> m_failed.store(false);
+
+        // 调用线程自己也领取分组，因此至多需要chunk_num - 1个帮助任务；提交失败时由已有的线程完成
+        size_t helper_num = std::min<size_t>(chunk_num - 1, m_thread_num);
+        for (size_t i = 0; i < helper_num; i++) {
+            if (!tryAddTask([state] { executeChunks(*state); }, priority))
+                break;
+        }
+        executeChunks(*state);
+
+        // 剩余的只是其它线程正在执行的分组，等待期间帮助执行等待队列中的任务
+        while (state -> m_done_num.load() < chunk_num) {
+            if (runPendingTask())
+                continue;
+            AutoLockMutex autoLockMutex(&state -> m_mutex);
+            while (state -> m_done_num.load() < chunk_num)
+                state -> m_done_cond_var.wait(&state -> m_mutex);
+        }
+
+        if (state -> m_exception)
+            std::rethrow_exception(state -> m_exception);
+    }
+
+    /*!
+     * @brief 循环领取并执行分组，直到没有剩余分组
+     * @param [in,out] state 共享状态
+     */
+    void ThreadPool::executeChunks(ChunkState& state) {
+        size_t chunk;
+        while ((chunk = state.m_next_chunk.fetch_add(1)) < state.m_chunk_num) {
+            if (!state.m_failed.load(std::memory_order_relaxed)) {  // 已有分组失败时只计数不执行
+                try {
+                    (*state.m_body)(chunk);
+                } catch (...) {
+                    AutoLockMutex autoLockMutex(&state.m_mutex);
+                    if (!state.m_exception)
+                        state.m_exception = std::current_exception();
+                    state.m_failed.store(true);
+                }
+            }
+            if (state.m_done_num.fetch_add(1) + 1 == state.m_chunk_num) {
+                AutoLockMutex autoLockMutex(&state.m_mutex);
+                state.m_done_cond_var.signal();
+            }
+        }
+    }
+
+    /*!
+     * @brief 安排延时任务，到期后按addTask的规则提交
+     * @param [in] delay 延时时长
+     * @param [in] task 任务对象
+     * @param [in] priority 任务优先级，默认为Normal
+     * @return 定时器句柄，可用于取消
+     */
+    TimerHandle ThreadPool::scheduleAfter(std::chrono::nanoseconds delay, Task task, Priority priority) {
+        if (!m_running)
+            throw std::runtime_error("thread pool is not running.");
+        return m_timer_queue.scheduleAt(
+                ConditionVariable::deadlineAfter(delay),
+                DelayedTask{this, std::move(task), priority});
+    }
+
+    /*!
+     * @brief 安排周期任务，首次在一个周期后提交；上一次提交尚未执行完时跳过本次
+     * @param [in] period 触发周期，须为正
+     * @param [in] function 每次执行的可执行对象
+     * @param [in] priority 任务优先级，默认为Normal
+     * @return 定时器句柄，可用于取消
+     */
+    TimerHandle ThreadPool::scheduleEvery(std::chrono::nanoseconds period, std::function<void()> function,
+                                          Priority priority) {
+        if (!m_running)
+            throw std::runtime_error("thread pool is not running.");
+        auto function_ptr = std::make_shared<std::function<void()>>(std::move(function));
+        auto in_flight = std::make_shared<std::atomic<bool>>(false);
+        return m_timer_queue.scheduleEvery(
+                ConditionVariable::deadlineAfter(period),
+                period,
+                [this, function_ptr, in_flight, priority] {
+                    if (in_flight -> exchange(true))  // 上一次提交尚未执行完
+                        return;
+                    // 被拒绝时PeriodicRun随即析构，清除执行中标记
+                    addTask(PeriodicRun(function_ptr, in_flight), priority);
+                });
+    }
+
+    /*!
+     * @brief 获取运行统计快照，运行中可随时调用（但不可与terminate并发），不会暂停工作线程
+     * @return 统计快照
+     */
+    ThreadPool::Stats ThreadPool::getStats() const {
+        Stats stats;
+        for (auto& thread_ptr : m_thread_ptr_set)
+            thread_ptr -> collectStats(stats);
+        stats.m_pending = m_pending_count.load();
+        for (size_t i = 0; i < PriorityNum; i++)
+            stats.m_running[i] = m_running_counts[i].load();
+        return stats;
+    }
+
     /*!
      * @brief 终止线程池
      * @param [in] wait_finish 线程池发出终止指令时，是否选择继续执行等待队列中的任务，默认为true
@@ -77,31 +319,248 @@ namespace xjj {
         if (!m_running)  // 未在运行则无需终止
             return;
         m_running = false;
+        m_timer_queue.stop();  // 先停止定时器，不再有到期任务提交
 
         for (auto& thread_ptr : m_thread_ptr_set) {
             thread_ptr -> terminate(wait_finish);  // 对所有线程发出终止指令
         }
+        {
+            // 唤醒所有空闲等待的工作线程，不必等到定时等待超时
+            AutoLockMutex autoLockMutex(&m_idle_mutex);
+            m_idle_cond_var.broadcast();
+        }
+        {
+            // 唤醒所有因队满而阻塞的提交线程，使其抛出线程池未运行的异常
+            AutoLockMutex autoLockMutex(&m_full_mutex);
+            m_not_full_cond_var.broadcast();
+        }
 
         for (auto& thread_ptr : m_thread_ptr_set) {
             thread_ptr -> join();  // 将所有线程置于分离状态
         }
 
-        m_waiting_queue.clear();  // 清空等待队列
-        m_finished_queue.clear();  // 清空完成队列
+        for (auto& waiting_queue : m_waiting_queues)
+            waiting_queue.clear();  // 清空等待队列
+        m_pending_count.store(0);
+        m_active_count.store(0);
         m_thread_ptr_set.clear();  // 清空线程指针数组
     }
 
     /*!
-     * @brief 获取一个已经完成的任务的id
-     * @return 获取到的id（已完成任务队列为空时返回-1）
+     * @brief 工作线程获取任务，没有可执行任务时定时等待，超时1秒返回
+     * @param [out] task 获取到的任务
+     * @param [out] priority 获取到的任务的优先级
+     * @return 是否获取到任务
+     */
+    bool ThreadPool::takeTask(QueuedTask& task, Priority& priority) {
+        if (tryTakeTask(task, priority))
+            return true;
+
+        AutoLockMutex autoLockMutex(&m_idle_mutex);
+        // 先登记为空闲再重新检查，与notifyIdleThread配合避免丢失唤醒
+        m_idle_count.fetch_add(1);
+        bool got = tryTakeTask(task, priority);
+        if (!got) {
+            m_idle_cond_var.timedWait(&m_idle_mutex, 1);
+            got = tryTakeTask(task, priority);
+        }
+        m_idle_count.fetch_sub(1);
+        return got;
+    }
+
+    /*!
+     * @brief 按优先级与份额尝试获取一个任务，不阻塞
+     * @param [out] task 获取到的任务
+     * @param [out] priority 获取到的任务的优先级
+     * @return 是否获取到任务
      */
-    int32_t ThreadPool::getFinishedTaskId() {
-        if (!m_finished_queue.empty()) {  // 完成队列非空时才可执行
-            int32_t res;
-            m_finished_queue.pop(res);  // 从等待队列队头获取一个id
-            return res;
+    bool ThreadPool::tryTakeTask(QueuedTask& task, Priority& priority) {
+        if (0 == m_pending_count.load())
+            return false;
+
+        // High优先级严格优先
+        if (tryTakeTaskFrom(static_cast<size_t>(Priority::High), task)) {
+            priority = Priority::High;
+            return true;
+        }
+
+        // Normal与Background按份额加权轮转，首选队列为空或配额已满时退而选择另一个
+        size_t tick = m_schedule_tick.load(std::memory_order_relaxed);
+        bool prefer_normal = tick % (m_normal_share + m_background_share) < m_normal_share;
+        const Priority order[2] = {
+                prefer_normal ? Priority::Normal : Priority::Background,
+                prefer_normal ? Priority::Background : Priority::Normal
+        };
+        for (Priority candidate : order) {
+            if (tryTakeTaskFrom(static_cast<size_t>(candidate), task)) {
+                m_schedule_tick.fetch_add(1, std::memory_order_relaxed);
+                priority = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /*!
+     * @brief 在配额允许的情况下尝试从指定优先级的队列获取一个任务
+     * @param [in] index 优先级下标
+     * @param [out] task 获取到的任务
+     * @return 是否获取到任务
+     */
+    bool ThreadPool::tryTakeTaskFrom(size_t index, QueuedTask& task) {
+        // 先占用配额，出队失败再归还，保证同时执行数不超过配额
+        size_t running = m_running_counts[index].load(std::memory_order_relaxed);
+        do {
+            if (running >= m_priority_quotas[index])
+                return false;
+        } while (!m_running_counts[index].compare_exchange_weak(running, running + 1));
+
+        if (!m_waiting_queues[index].tryPop(task)) {
+            m_running_counts[index].fetch_sub(1);
+            return false;
+        }
+        m_pending_count.fetch_sub(1);
+        notifyBlockedSubmitter();
+        return true;
+    }
+
+    /*!
+     * @brief 工作线程执行完任务后调用，归还配额
+     * @param [in] priority 所执行任务的优先级
+     */
+    void ThreadPool::finishTask(Priority priority) {
+        auto index = static_cast<size_t>(priority);
+        size_t running = m_running_counts[index].fetch_sub(1);
+        m_active_count.fetch_sub(1);
+        // 该优先级的配额刚从已满变为可用，可能有线程因配额而空闲等待
+        if (running == m_priority_quotas[index] && m_priority_quotas[index] < m_thread_num)
+            notifyIdleThread();
+    }
+
+    /*!
+     * @brief 在计数未达上限时将其加一
+     * @param [in,out] counter 目标计数
+     * @param [in] limit 上限
+     * @return 是否加一成功
+     */
+    bool ThreadPool::tryIncrease(std::atomic<size_t>& counter, size_t limit) {
+        size_t value = counter.load(std::memory_order_relaxed);
+        do {
+            if (value >= limit)
+                return false;
+        } while (!counter.compare_exchange_weak(value, value + 1));
+        return true;
+    }
+
+    /*!
+     * @brief 在不超过上限的前提下将计数至多增加amount
+     * @param [in,out] counter 目标计数
+     * @param [in] amount 欲增加的量
+     * @param [in] limit 上限
+     * @return 实际增加的量
+     */
+    size_t ThreadPool::increaseUpTo(std::atomic<size_t>& counter, size_t amount, size_t limit) {
+        size_t value = counter.load(std::memory_order_relaxed);
+        size_t increment;
+        do {
+            increment = value >= limit ? 0 : std::min(amount, limit - value);
+            if (0 == increment)
+                return 0;
+        } while (!counter.compare_exchange_weak(value, value + increment));
+        return increment;
+    }
+
+    /*!
+     * @brief 为批量添加一次性预留队列位置，能预留多少就预留多少
+     * @param [in] task_num 欲预留的位置数
+     * @return 实际预留的位置数
+     */
+    size_t ThreadPool::reserveSlots(size_t task_num) {
+        size_t active = task_num;
+        if (m_overload)
+            m_active_count.fetch_add(task_num);
+        else
+            active = increaseUpTo(m_active_count, task_num, m_thread_num);
+
+        size_t reserved = increaseUpTo(m_pending_count, active, m_capacity);
+        if (reserved < active)  // 归还未能预留到队列位置的部分
+            m_active_count.fetch_sub(active - reserved);
+        return reserved;
+    }
+
+    /*!
+     * @brief Block策略下等待队列出现空位并预留
+     */
+    void ThreadPool::waitForPendingSlot() {
+        AutoLockMutex autoLockMutex(&m_full_mutex);
+        // 先登记为阻塞再重新检查，与notifyBlockedSubmitter配合避免丢失唤醒
+        m_blocked_count.fetch_add(1);
+        while (!tryIncrease(m_pending_count, m_capacity)) {
+            if (!m_running) {
+                m_blocked_count.fetch_sub(1);
+                throw std::runtime_error("thread pool is not running.");
+            }
+            m_not_full_cond_var.timedWait(&m_full_mutex, 1);
+        }
+        m_blocked_count.fetch_sub(1);
+    }
+
+    /*!
+     * @brief DropOldest策略下丢弃最低优先级队列中最老的任务
+     * @return 是否丢弃了任务（队列均为空时返回false）
+     */
+    bool ThreadPool::dropOldestTask() {
+        for (size_t i = PriorityNum; i > 0; i--) {
+            QueuedTask dropped;
+            if (m_waiting_queues[i - 1].tryPop(dropped)) {
+                m_pending_count.fetch_sub(1);
+                m_active_count.fetch_sub(1);
+                if (m_drop_callback)
+                    m_drop_callback(dropped.m_task);
+                return true;  // 被丢弃的任务在此析构，submit提交的任务会向future写入异常
+            }
+        }
+        return false;
+    }
+
+    /*!
+     * @brief 唤醒至多task_num个空闲等待的工作线程
+     * @param [in] task_num 新加入的任务数
+     */
+    void ThreadPool::notifyIdleThreads(size_t task_num) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        size_t wake_num = std::min(task_num, m_idle_count.load());
+        if (wake_num > 0) {
+            AutoLockMutex autoLockMutex(&m_idle_mutex);
+            for (; wake_num > 0; wake_num--)
+                m_idle_cond_var.signal();
+        }
+    }
+
+    /*!
+     * @brief 工作线程取出任务后调用，若有因队满而阻塞的提交线程，唤醒其中一个
+     */
+    void ThreadPool::notifyBlockedSubmitter() {
+        if (m_rejection_policy != RejectionPolicy::Block ||
+                m_capacity == std::numeric_limits<size_t>::max())
+            return;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_blocked_count.load() > 0) {
+            AutoLockMutex autoLockMutex(&m_full_mutex);
+            m_not_full_cond_var.signal();
+        }
+    }
+
+    /*!
+     * @brief 若有空闲等待的工作线程，唤醒其中一个
+     */
+    void ThreadPool::notifyIdleThread() {
+        // 与takeTask中先登记空闲再检查队列的顺序相对，保证双方至少一方看到对方的修改
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_idle_count.load() > 0) {
+            AutoLockMutex autoLockMutex(&m_idle_mutex);
+            m_idle_cond_var.signal();
         }
-        return -1;
     }
 
     /*!
@@ -114,23 +573,36 @@ namespace xjj {
         return nullptr;
     }
 
+    /*!
+     * @brief 计算两个时间点之间的纳秒数，设为static函数以限制只能在本文件内使用
+     * @param [in] start 起始时间点
+     * @param [in] end 结束时间点
+     * @return 纳秒数，end早于start时为0
+     */
+    static uint64_t elapsedNanoseconds(std::chrono::steady_clock::time_point start,
+                                       std::chrono::steady_clock::time_point end) {
+        if (end <= start)
+            return 0;
+        return static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    }
+
     /*!
      * @brief 构造函数
-     * @param [in,out] waiting_queue_ptr 等待队列指针
-     * @param [in,out] working_queue_ptr 工作队列指针
-     * @param [in,out] finished_queue_ptr 任务完成队列指针
+     * @param [in] pool_ptr 所属线程池指针
+     * @param [in] index 线程序号，用于线程命名
      * @param [in] wait_finish 线程池发出终止指令时，是否选择继续执行等待队列中的任务，默认为true
      */
-    ThreadPool::Thread::Thread(BlockingQueue<Task> *waiting_queue_ptr,
-                               BlockingQueue<int> *working_queue_ptr,
-                               BlockingQueue<int32_t> *finished_queue_ptr,
-                               bool wait_finish)
-            : m_waiting_queue_ptr(waiting_queue_ptr),
-              m_working_queue_ptr(working_queue_ptr),
-              m_finished_queue_ptr(finished_queue_ptr),
-              m_wait_finish(wait_finish),
+    ThreadPool::Thread::Thread(ThreadPool *pool_ptr, size_t index, bool wait_finish)
+            : m_thread_id(0),
               m_running(false),
-              m_thread_id(0) {}
+              m_wait_finish(wait_finish),
+              m_pool_ptr(pool_ptr),
+              m_name("workerbee-" + std::to_string(index)),
+              m_tasks_run(0),
+              m_busy_ns(0),
+              m_idle_ns(0),
+              m_idle_since(0) {}
 
     /*!
      * @brief 析构函数
@@ -150,33 +622,46 @@ namespace xjj {
      * @brief 执行线程工作
      */
     void ThreadPool::Thread::run() {
+        pthread_setname_np(pthread_self(), m_name.c_str());
+
+        typedef QueuedTask::clock_type clock_type;
+        clock_type::time_point idle_start = clock_type::now();
+        m_idle_since.store(idle_start.time_since_epoch().count(), std::memory_order_relaxed);
+
         // 循环获取等待队列中的任务
         while (true) {
             if (!m_running) {  // 判断是否在运行状态
                 if (!m_wait_finish ||  // 不需要等待所有挂起任务被执行完
-                        (m_wait_finish && m_waiting_queue_ptr -> empty())) // 需要等待挂起任务执行完，但是已经没有挂起任务
+                        (m_wait_finish && 0 == m_pool_ptr -> m_pending_count.load())) // 需要等待挂起任务执行完，但是已经没有挂起任务
                     break;
             }
 
-            Task task;
+            QueuedTask task;
+            Priority priority;
 
-            // 定时获取一个等待队列队头任务，超时1秒返回
-            if (!m_waiting_queue_ptr -> timedPop(task, 1))
+            // 按优先级获取一个任务，没有任务时超时1秒返回
+            bool got = m_pool_ptr -> takeTask(task, priority);
+            clock_type::time_point run_start = clock_type::now();
+            // 先更新当前空闲起点再累加，并发读取的快照至多少计、不会重复计入这段空闲
+            m_idle_since.store(got ? 0 : run_start.time_since_epoch().count(), std::memory_order_relaxed);
+            m_idle_ns.fetch_add(elapsedNanoseconds(idle_start, run_start), std::memory_order_relaxed);
+            idle_start = run_start;
+            if (!got)
                 continue;
+            m_queue_wait.record(elapsedNanoseconds(task.m_enqueue_time, run_start));
 
-            // 工作队列中的线程数+1
-            m_working_queue_ptr -> push(1);
-
-            // 执行获取到的任务
-            task.m_function();
+            // 执行获取到的任务，任务结果由TaskFuture或完成回调传递
+            task.m_task();
 
-            int i;
+            // 归还该优先级的配额
+            m_pool_ptr -> finishTask(priority);
 
-            // 工作队列中的线程数-1
-            m_working_queue_ptr -> pop(i);
-
-            if (task.m_task_id >= 0)
-                m_finished_queue_ptr -> push(task.m_task_id);  // 将id非负的任务id加入完成队列
+            idle_start = clock_type::now();
+            m_idle_since.store(idle_start.time_since_epoch().count(), std::memory_order_relaxed);
+            uint64_t run_ns = elapsedNanoseconds(run_start, idle_start);
+            m_run_time.record(run_ns);
+            m_busy_ns.fetch_add(run_ns, std::memory_order_relaxed);
+            m_tasks_run.fetch_add(1, std::memory_order_relaxed);
         }
     }
 
@@ -205,12 +690,24 @@ namespace xjj {
     }
 
     /*!
-     * @brief 任务类构造函数
-     * @param [in] function 任务可执行对象，默认为nullptr
-     * @param [in] task_id 任务id，默认为-1
+     * @brief 将本线程的统计累加到线程池统计快照中
+     * @param [in,out] stats 线程池统计快照
      */
-    ThreadPool::Task::Task(std::function<void()> function, int32_t task_id)
-            : m_function(std::move(function)),
-              m_task_id(task_id) {}
+    void ThreadPool::Thread::collectStats(Stats& stats) const {
+        typedef QueuedTask::clock_type clock_type;
+        WorkerStats worker;
+        worker.m_name = m_name;
+        worker.m_tasks_run = m_tasks_run.load(std::memory_order_relaxed);
+        worker.m_busy_ns = m_busy_ns.load(std::memory_order_relaxed);
+        worker.m_idle_ns = m_idle_ns.load(std::memory_order_relaxed);
+        // 加上正在进行中的这段空闲
+        clock_type::rep idle_since = m_idle_since.load(std::memory_order_relaxed);
+        if (0 != idle_since)
+            worker.m_idle_ns += elapsedNanoseconds(
+                    clock_type::time_point(clock_type::duration(idle_since)), clock_type::now());
+        stats.m_workers.push_back(std::move(worker));
+        stats.m_queue_wait.merge(m_queue_wait.snapshot());
+        stats.m_run_time.merge(m_run_time.snapshot());
+    }
 
 } // namespace xjj
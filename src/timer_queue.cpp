@@ -0,0 +1,230 @@
+//
+// created by agent on 2026-10-18
+//
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include "timer_queue.hpp"
+
+namespace xjj {
+
+    /*!
+     * @brief 构造函数
+     * @param [in] state 定时器共享状态
+     */
+    TimerHandle::TimerHandle(std::shared_ptr<TimerState> state)
+            : m_state(std::move(state)) {}
+
+    /*!
+     * @brief 取消定时器；周期定时器取消后不再触发，已提交的那一次仍会执行
+     * @return 取消前定时器是否仍在等待触发
+     */
+    bool TimerHandle::cancel() {
+        if (!m_state)
+            return false;
+        int expected = TimerState::Pending;
+        return m_state -> m_status.compare_exchange_strong(expected, TimerState::Cancelled);
+    }
+
+    /*!
+     * @brief 判断定时器是否仍在等待触发
+     * @return 是否等待触发
+     */
+    bool TimerHandle::pending() const {
+        return m_state && TimerState::Pending == m_state -> m_status.load();
+    }
+
+    /*!
+     * @brief 判断句柄是否关联定时器
+     * @return 是否非空
+     */
+    bool TimerHandle::valid() const {
+        return static_cast<bool>(m_state);
+    }
+
+    /*!
+     * @brief 构造函数
+     */
+    TimerQueue::TimerQueue()
+            : m_next_sequence(0),
+              m_running(false),
+              m_thread_id(0) {}
+
+    /*!
+     * @brief 析构函数：调用stop停止定时器线程
+     */
+    TimerQueue::~TimerQueue() {
+        stop();
+    }
+
+    /*!
+     * @brief 启动定时器线程
+     * @return 创建线程是否成功
+     */
+    bool TimerQueue::start() {
+        AutoLockMutex autoLockMutex(&m_mutex);
+        if (m_running)
+            return true;
+        m_running = true;
+        if (0 != pthread_create(&m_thread_id, nullptr, threadFunction, this)) {
+            m_running = false;
+            return false;
+        }
+        return true;
+    }
+
+    /*!
+     * @brief 停止定时器线程，丢弃所有未触发的定时器
+     */
+    void TimerQueue::stop() {
+        {
+            AutoLockMutex autoLockMutex(&m_mutex);
+            if (!m_running)
+                return;
+            m_running = false;
+        }
+        m_cond_var.signal();
+        pthread_join(m_thread_id, nullptr);
+
+        std::vector<Entry> discarded;
+        {
+            AutoLockMutex autoLockMutex(&m_mutex);
+            discarded.swap(m_heap);
+        }
+        for (auto& entry : discarded)
+            entry.m_state -> m_status.store(TimerState::Cancelled);
+    }
+
+    /*!
+     * @brief 安排单次定时器
+     * @param [in] deadline 到期时间
+     * @param [in] task 到期时执行的任务
+     * @return 定时器句柄
+     */
+    TimerHandle TimerQueue::scheduleAt(time_point deadline, Task task) {
+        return schedule(deadline, std::chrono::nanoseconds::zero(), std::move(task));
+    }
+
+    /*!
+     * @brief 安排周期定时器；错过的触发不会补执行
+     * @param [in] first 首次到期时间
+     * @param [in] period 触发周期，须为正
+     * @param [in] task 每次到期时执行的任务
+     * @return 定时器句柄
+     */
+    TimerHandle TimerQueue::scheduleEvery(time_point first, std::chrono::nanoseconds period, Task task) {
+        if (period.count() <= 0)
+            throw std::invalid_argument("timer period must be positive.");
+        return schedule(first, period, std::move(task));
+    }
+
+    /*!
+     * @brief 获取堆中的定时器数目（包括已取消但尚未到期的）
+     * @return 定时器数目
+     */
+    size_t TimerQueue::size() {
+        AutoLockMutex autoLockMutex(&m_mutex);
+        return m_heap.size();
+    }
+
+    /*!
+     * @brief 将定时器加入堆
+     * @param [in] deadline 到期时间
+     * @param [in] period 触发周期，为0表示单次定时器
+     * @param [in] task 到期时执行的任务
+     * @return 定时器句柄
+     */
+    TimerHandle TimerQueue::schedule(time_point deadline, std::chrono::nanoseconds period, Task task) {
+        Entry entry;
+        entry.m_deadline = deadline;
+        entry.m_state = std::make_shared<TimerState>(std::move(task), period);
+        TimerHandle handle(entry.m_state);
+        const TimerState* state_ptr = entry.m_state.get();
+
+        bool earliest = false;  // 新定时器是否成为堆顶
+        {
+            AutoLockMutex autoLockMutex(&m_mutex);
+            entry.m_sequence = m_next_sequence++;
+            pushEntry(std::move(entry));
+            earliest = m_heap.front().m_state.get() == state_ptr;
+        }
+        if (earliest)  // 堆顶提前，唤醒定时器线程重新计算等待时间
+            m_cond_var.signal();
+        return handle;
+    }
+
+    /*!
+     * @brief 将堆元素加入堆，调用者须持有互斥量
+     * @param [in] entry 堆元素
+     */
+    void TimerQueue::pushEntry(Entry entry) {
+        m_heap.push_back(std::move(entry));
+        std::push_heap(m_heap.begin(), m_heap.end(), EntryLater());
+    }
+
+    /*!
+     * @brief 定时器线程主循环
+     */
+    void TimerQueue::run() {
+        pthread_setname_np(pthread_self(), "workerbee-timer");
+        AutoLockMutex autoLockMutex(&m_mutex);
+        while (m_running) {
+            if (m_heap.empty()) {
+                m_cond_var.wait(&m_mutex);
+                continue;
+            }
+
+            time_point now = clock_type::now();
+            if (m_heap.front().m_deadline > now) {  // 堆顶未到期，等到堆顶到期或被唤醒
+                m_cond_var.timedWaitUntil(&m_mutex, m_heap.front().m_deadline);
+                continue;
+            }
+
+            std::pop_heap(m_heap.begin(), m_heap.end(), EntryLater());
+            Entry entry = std::move(m_heap.back());
+            m_heap.pop_back();
+
+            TimerState& state = *entry.m_state;
+            bool periodic = state.m_period.count() > 0;
+            int expected = TimerState::Pending;
+            if (periodic ? TimerState::Pending != state.m_status.load() :
+                    !state.m_status.compare_exchange_strong(expected, TimerState::Fired))
+                continue;  // 已取消，丢弃
+
+            // 执行到期任务时释放互斥量，任务中可以安排新的定时器
+            m_mutex.unlock();
+            try {
+                state.m_task();
+            } catch (...) {
+                // 定时器线程须继续服务其它定时器，任务自身的异常在此忽略
+            }
+            if (!periodic)
+                state.m_task.reset();  // 在锁外销毁单次任务
+            m_mutex.lock();
+
+            if (periodic && TimerState::Pending == state.m_status.load()) {
+                // 按固定频率安排下一次触发，跳过已错过的周期；超出时钟范围时取最大时间点
+                now = clock_type::now();
+                auto period = std::chrono::duration_cast<clock_type::duration>(state.m_period);
+                do {
+                    entry.m_deadline = entry.m_deadline < time_point::max() - period ?
+                                       entry.m_deadline + period : time_point::max();
+                } while (entry.m_deadline <= now);
+                entry.m_sequence = m_next_sequence++;
+                pushEntry(std::move(entry));
+            }
+        }
+    }
+
+    /*!
+     * @brief 定时器线程入口函数
+     * @param [in] arg 定时器队列指针
+     * @return nullptr
+     */
+    void* TimerQueue::threadFunction(void* arg) {
+        static_cast<TimerQueue*>(arg) -> run();
+        return nullptr;
+    }
+
+} // namespace xjj